@@ -11,7 +11,16 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include <algorithm>
+#include <array>
+#include <chrono>  // NOLINT
+#include <cmath>
 #include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "common/config.h"
@@ -22,11 +31,34 @@ namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
                                                      LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
-  // we allocate a consecutive memory space for the buffer pool
-  pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHashTable<page_id_t, frame_id_t>(bucket_size_);
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, replacer_k, log_manager) {}
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                                     DiskManager *disk_manager, size_t replacer_k,
+                                                     LogManager *log_manager, int numa_node)
+    : pool_size_(pool_size),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      next_page_id_(static_cast<page_id_t>(instance_index)),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager),
+      flush_victims_(pool_size),
+      scan_ring_capacity_(std::min<size_t>(SCAN_RING_SIZE, std::max<size_t>(1, pool_size / 4))),
+      scan_only_(pool_size),
+      prefetched_(pool_size) {
+  BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
+  BUSTUB_ASSERT(
+      instance_index < num_instances,
+      "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
+  // we allocate a consecutive memory space for the buffer pool, and keep the frame data apart from the metadata
+  arena_ = new FrameArena(pool_size_, numa_node);
+  pages_ = static_cast<Page *>(::operator new(pool_size_ * sizeof(Page)));
+  for (size_t i = 0; i < pool_size_; ++i) {
+    new (&pages_[i]) Page(arena_->GetFrame(static_cast<frame_id_t>(i)));
+  }
+  page_table_ = new LockFreePageTable(pool_size_);
   replacer_ = new LRUKReplacer(pool_size, replacer_k);
+  scan_ring_.reserve(scan_ring_capacity_);
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
@@ -40,140 +72,716 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManag
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  StopBackgroundFlusher();
+  {
+    // Prefetch reads still write into our frames.
+    std::unique_lock<std::mutex> lock(io_latch_);
+    io_cv_.wait(lock, [this] { return reads_in_flight_ == 0; });
+  }
+  for (size_t i = 0; i < pool_size_; ++i) {
+    pages_[i].~Page();
+  }
+  ::operator delete(pages_);
+  delete arena_;
+  delete compressed_cache_;
   delete page_table_;
   delete replacer_;
 }
 
-auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
-  if (free_list_.empty() && replacer_->Size() == 0U) {
+auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id, AccessType access_type) -> Page * {
+  auto lock = LockLatch();
+  frame_id_t frame_id;
+  if (!(access_type == AccessType::Scan ? AcquireScanFrame(&frame_id) : AcquireFrame(&frame_id))) {
     return nullptr;
   }
 
-  frame_id_t frame_id;
-  if (!free_list_.empty()) {  // free list有
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else {  // lru-k替换
-    replacer_->Evict(&frame_id);
-  }
-  if (pages_[frame_id].IsDirty()) {
-    disk_manager_->WritePage(pages_[frame_id].page_id_, pages_[frame_id].GetData());
-    pages_[frame_id].is_dirty_ = false;
-  }
-  page_table_->Remove(pages_[frame_id].GetPageId());  // 将旧的page id清除
-  pages_[frame_id].ResetMemory();
-  pages_[frame_id].page_id_ = AllocatePage();
-  pages_[frame_id].pin_count_ = 1;
-  *page_id = pages_[frame_id].GetPageId();
-  replacer_->RecordAccess(frame_id);
-  replacer_->SetEvictable(frame_id, false);
-  page_table_->Insert(pages_[frame_id].GetPageId(), frame_id);
-  return &pages_[frame_id];
-}
-
-auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
-  frame_id_t frame_id;
-  if (page_id == INVALID_PAGE_ID) {
+  bool reused = false;
+  *page_id = AllocatePage(&reused);
+  if (*page_id == INVALID_PAGE_ID) {
+    // Hand the frame back without a page.
+    pages_[frame_id].page_id_ = INVALID_PAGE_ID;
+    free_list_.emplace_back(frame_id);
+    pages_[frame_id].pin_count_.store(0, std::memory_order_release);
     return nullptr;
   }
-  if (page_table_->Find(page_id, frame_id)) {
-    pages_[frame_id].pin_count_++;
-    replacer_->RecordAccess(frame_id);
-    replacer_->SetEvictable(frame_id, false);
-    return &pages_[frame_id];
-  }
+  // A reused page still holds the data of the deleted page on disk, so it must be written even if nobody touches it.
+  return InitNewPage(frame_id, *page_id, reused, access_type);
+}
 
-  if (free_list_.empty() && replacer_->Size() == 0U) {
+auto BufferPoolManagerInstance::NewPgAtImp(page_id_t page_id, AccessType access_type) -> Page * {
+  if (page_id == INVALID_PAGE_ID) {
     return nullptr;
   }
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else {
-    replacer_->Evict(&frame_id);
+  ValidatePageId(page_id);
+  while (true) {
+    auto lock = LockLatch();
+    frame_id_t frame_id;
+    if (page_table_->Find(page_id, &frame_id)) {
+      // Something read the page before it existed. Take its frame over rather than load the page into a second one.
+      Page &page = pages_[frame_id];
+      if (page.pin_count_.load() < 0) {
+        // Still being read in; wait for the read without the latch and start over, as FetchPgImp() does.
+        lock.unlock();
+        std::unique_lock<std::mutex> io_lock(io_latch_);
+        io_cv_.wait_for(io_lock, std::chrono::milliseconds(1), [&page] { return page.pin_count_.load() >= 0; });
+        continue;
+      }
+      if (page.GetPageId() == page_id) {
+        int expected = 0;
+        if (!page.pin_count_.compare_exchange_strong(expected, -1)) {
+          return nullptr;
+        }
+        // Resident frames are always evictable in the replacer.
+        replacer_->Remove(frame_id);
+        return InitNewPage(frame_id, page_id, false, access_type);
+      }
+      // Left behind by a prefetch that failed its checksum.
+      page_table_->Remove(page_id);
+    }
+    if (!(access_type == AccessType::Scan ? AcquireScanFrame(&frame_id) : AcquireFrame(&frame_id))) {
+      return nullptr;
+    }
+    return InitNewPage(frame_id, page_id, false, access_type);
+  }
+}
+
+auto BufferPoolManagerInstance::InitNewPage(frame_id_t frame_id, page_id_t page_id, bool is_dirty,
+                                            AccessType access_type) -> Page * {
+  Page &page = pages_[frame_id];
+  page.ResetMemory();
+  page.is_dirty_ = is_dirty;
+  page.page_id_ = page_id;
+  page_table_->Insert(page_id, frame_id);
+  scan_only_[frame_id] = access_type == AccessType::Scan;
+  prefetched_[frame_id] = false;
+  replacer_->RecordAccess(frame_id, access_type);
+  replacer_->SetEvictable(frame_id, true);
+  if (IsUncreated(page_id)) {
+    // The extent is filled in id order, so the ids before this one are not waiting to be created either.
+    auto it = std::prev(uncreated_pages_.upper_bound(page_id));
+    const page_id_t end = it->second;
+    uncreated_pages_.erase(it);
+    if (end - page_id > static_cast<page_id_t>(num_instances_)) {
+      uncreated_pages_.emplace(page_id + static_cast<page_id_t>(num_instances_), end);
+    }
   }
+  // Publish the frame; lock-free readers that saw it claimed retry through the latch.
+  page.pin_count_.store(1, std::memory_order_release);
+  return &page;
+}
 
-  if (pages_[frame_id].IsDirty()) {
-    disk_manager_->WritePage(pages_[frame_id].GetPageId(), pages_[frame_id].GetData());
-    pages_[frame_id].is_dirty_ = false;
+auto BufferPoolManagerInstance::IsUncreated(page_id_t page_id) const -> bool {
+  auto it = uncreated_pages_.upper_bound(page_id);
+  return it != uncreated_pages_.begin() && page_id < std::prev(it)->second;
+}
+
+auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id, AccessType access_type) -> Page * {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
   }
-  page_table_->Remove(pages_[frame_id].GetPageId());
-  disk_manager_->ReadPage(page_id, pages_[frame_id].GetData());
-  pages_[frame_id].pin_count_ = 1;
-  pages_[frame_id].page_id_ = page_id;
-  page_table_->Insert(page_id, frame_id);
-  replacer_->RecordAccess(frame_id);
-  replacer_->SetEvictable(frame_id, false);
+  ValidatePageId(page_id);
+  while (true) {
+    if (auto *page = TryPinResident(page_id, access_type); page != nullptr) {
+      return page;
+    }
+
+    auto lock = LockLatch();
+    frame_id_t frame_id;
+    if (page_table_->Find(page_id, &frame_id)) {
+      Page &page = pages_[frame_id];
+      // Other than prefetches, frames are only ever claimed while holding the latch, so a negative pin count here
+      // means that the page is still being read in. Wait for it without the latch and start over.
+      if (page.pin_count_.load() < 0) {
+        lock.unlock();
+        std::unique_lock<std::mutex> io_lock(io_latch_);
+        io_cv_.wait_for(io_lock, std::chrono::milliseconds(1), [&page] { return page.pin_count_.load() >= 0; });
+        continue;
+      }
+      if (page.GetPageId() == page_id) {
+        // Loaded by someone else in the meantime.
+        page.pin_count_.fetch_add(1);
+        RecordAccess(frame_id, access_type);
+        stats_.RecordHit();
+        return &page;
+      }
+      // A prefetch whose page failed its checksum left the entry behind; read the page again below, which throws.
+      page_table_->Remove(page_id);
+    }
 
-  return &pages_[frame_id];
+    if (!(access_type == AccessType::Scan ? AcquireScanFrame(&frame_id) : AcquireFrame(&frame_id))) {
+      return nullptr;
+    }
+    stats_.RecordMiss();
+    Page &page = pages_[frame_id];
+    page.page_id_ = page_id;
+    try {
+      if (compressed_cache_ != nullptr && compressed_cache_->Get(page_id, page.GetData())) {
+        stats_.RecordCompressedHit();
+      } else {
+        disk_manager_->ReadPage(page_id, page.GetData());
+      }
+    } catch (Exception &e) {
+      // Hand the frame back as an evictable frame that holds no page, and let the caller see the error.
+      page.page_id_ = INVALID_PAGE_ID;
+      replacer_->RecordAccess(frame_id);
+      replacer_->SetEvictable(frame_id, true);
+      page.pin_count_.store(0, std::memory_order_release);
+      throw;
+    }
+    page.is_dirty_ = false;
+    page_table_->Insert(page_id, frame_id);
+    scan_only_[frame_id] = access_type == AccessType::Scan;
+    prefetched_[frame_id] = false;
+    replacer_->RecordAccess(frame_id, access_type);
+    replacer_->SetEvictable(frame_id, true);
+    page.pin_count_.store(1, std::memory_order_release);
+    return &page;
+  }
 }
 
 auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
   if (page_id == INVALID_PAGE_ID) {
     return false;
   }
   frame_id_t frame_id;
-  if (!page_table_->Find(page_id, frame_id) || pages_[frame_id].GetPinCount() <= 0) {
-    return false;
+  if (!page_table_->Find(page_id, &frame_id)) {
+    // A lock-free lookup can miss while the table is being compacted; ask again under the latch.
+    auto lock = LockLatch();
+    if (!page_table_->Find(page_id, &frame_id)) {
+      return false;
+    }
   }
-  pages_[frame_id].pin_count_ -= 1;
-  if (pages_[frame_id].GetPinCount() == 0U) {
-    replacer_->SetEvictable(frame_id, true);
+  Page &page = pages_[frame_id];
+  if (page.GetPageId() != page_id || page.GetPinCount() <= 0) {
+    return false;
   }
+  // Mark dirty before dropping the pin, so that whoever claims the frame next sees the flag.
   if (is_dirty) {
-    pages_[frame_id].is_dirty_ = is_dirty;
+    page.is_dirty_ = true;
   }
+  int pin_count = page.pin_count_.load();
+  do {
+    if (pin_count <= 0) {
+      return false;
+    }
+  } while (!page.pin_count_.compare_exchange_weak(pin_count, pin_count - 1));
   return true;
 }
 
 auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
   if (page_id == INVALID_PAGE_ID) {
     return false;
   }
-  frame_id_t frame_id;
-  if (!page_table_->Find(page_id, frame_id)) {
-    return false;
+  Page *page;
+  {
+    auto lock = LockLatch();
+    frame_id_t frame_id;
+    if (!page_table_->Find(page_id, &frame_id)) {
+      return false;
+    }
+    page = &pages_[frame_id];
+    if (page->pin_count_.load() < 0) {
+      // Still being prefetched, so the copy on disk is the page.
+      return true;
+    }
+    if (page->GetPageId() != page_id) {
+      // Left behind by a prefetch that failed its checksum; the frame does not hold the page.
+      return false;
+    }
+    // Claims only happen under the latch, so the pin holds the frame once we let go of it. Unpins do not take the
+    // latch, and a writer may hold the page latch while it waits for ours, so latch the page without holding it.
+    page->pin_count_.fetch_add(1);
   }
-  disk_manager_->WritePage(page_id, pages_[frame_id].GetData());
-  pages_[frame_id].is_dirty_ = false;
-  return true;
+  page->RLatch();
+  // Clear the flag before writing: a writer that modifies the page from here on marks it dirty again when it unpins.
+  page->is_dirty_ = false;
+  const bool written = disk_manager_->WritePage(page_id, page->GetData());
+  if (!written) {
+    page->is_dirty_ = true;
+  }
+  page->RUnlatch();
+  page->pin_count_.fetch_sub(1);
+  return written;
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  for (frame_id_t frame_id = 0; frame_id < static_cast<frame_id_t>(pool_size_); frame_id++) {
-    FlushPgImp(frame_id);
+  std::vector<Page *> pages;
+  CollectDirtyPages(&pages);
+  WriteBackPages(disk_manager_, &pages);
+  for (auto *page : pages) {
+    UnpinPgImp(page->GetPageId(), false);
   }
+  disk_manager_->Sync();
+}
+
+void BufferPoolManagerInstance::CollectDirtyPages(std::vector<Page *> *pages) {
+  auto lock = LockLatch();
+  for (size_t frame_id = 0; frame_id < pool_size_; frame_id++) {
+    Page &page = pages_[frame_id];
+    // Prefetched frames are clean while their read is in flight, and every other claim is released before latch_ is,
+    // so the pin count of a dirty page is not negative here.
+    if (page.GetPageId() != INVALID_PAGE_ID && page.IsDirty()) {
+      page.pin_count_.fetch_add(1);
+      pages->push_back(&page);
+    }
+  }
+}
+
+auto BufferPoolManagerInstance::WriteBackPages(DiskManager *disk_manager, std::vector<Page *> *pages) -> bool {
+  std::sort(pages->begin(), pages->end(),
+            [](Page *lhs, Page *rhs) { return lhs->GetPageId() < rhs->GetPageId(); });
+
+  auto staging = std::make_unique<char[]>(FLUSH_BATCH_PAGES * BUSTUB_PAGE_SIZE);
+  std::vector<const char *> run;
+  run.reserve(FLUSH_BATCH_PAGES);
+  std::vector<Page *> run_pages;
+  run_pages.reserve(FLUSH_BATCH_PAGES);
+  page_id_t run_start = INVALID_PAGE_ID;
+  bool written = true;
+  auto write_run = [&]() {
+    if (!run.empty()) {
+      if (!disk_manager->WritePages(run_start, run.data(), run.size())) {
+        // The pages are still pinned, so they are in their frames to be written again later.
+        for (auto *page : run_pages) {
+          page->is_dirty_ = true;
+        }
+        written = false;
+      }
+      run.clear();
+      run_pages.clear();
+    }
+  };
+
+  size_t staged = 0;
+  for (auto *page : *pages) {
+    if (staged == FLUSH_BATCH_PAGES) {
+      write_run();
+      staged = 0;
+    }
+    if (!run.empty() && page->GetPageId() != run_start + static_cast<page_id_t>(run.size())) {
+      write_run();
+    }
+    if (run.empty()) {
+      run_start = page->GetPageId();
+    }
+    char *dst = staging.get() + staged * BUSTUB_PAGE_SIZE;
+    page->RLatch();
+    // Clear the flag before copying: a writer that modifies the page from here on marks it dirty again.
+    page->is_dirty_ = false;
+    memcpy(dst, page->GetData(), BUSTUB_PAGE_SIZE);
+    page->RUnlatch();
+    run.push_back(dst);
+    run_pages.push_back(page);
+    staged++;
+  }
+  write_run();
+  return written;
 }
 
 auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
+  auto lock = LockLatch();
   if (page_id == INVALID_PAGE_ID) {
     return false;
   }
   frame_id_t frame_id;
-  if (!page_table_->Find(page_id, frame_id)) {
-    return true;
+  if (!page_table_->Find(page_id, &frame_id)) {
+    if (page_id % static_cast<page_id_t>(num_instances_) != static_cast<page_id_t>(instance_index_) ||
+        page_id >= next_page_id_ || IsUncreated(page_id)) {
+      return false;
+    }
+    return DeallocatePage(page_id);
   }
-  if (pages_[frame_id].pin_count_ > 0) {
+  Page &page = pages_[frame_id];
+  int expected = 0;
+  if (!page.pin_count_.compare_exchange_strong(expected, -1)) {
     return false;
   }
+  if (page.page_id_ != page_id) {
+    // Stale entry left by a prefetch that failed its checksum; the frame now holds another page or none.
+    page.pin_count_.store(0, std::memory_order_release);
+    page_table_->Remove(page_id);
+    return DeallocatePage(page_id);
+  }
   page_table_->Remove(page_id);
-  free_list_.emplace_back(frame_id);
   replacer_->SetEvictable(frame_id, true);
   replacer_->Remove(frame_id);
-  pages_[frame_id].ResetMemory();
-  pages_[frame_id].is_dirty_ = false;
-  pages_[frame_id].page_id_ = INVALID_PAGE_ID;
+  page.ResetMemory();
+  page.is_dirty_ = false;
+  page.page_id_ = INVALID_PAGE_ID;
+  scan_only_[frame_id] = false;
+  prefetched_[frame_id] = false;
+  page.pin_count_.store(0, std::memory_order_release);
+  free_list_.emplace_back(frame_id);
 
   DeallocatePage(page_id);
   return true;
 }
 
-auto BufferPoolManagerInstance::AllocatePage() -> page_id_t { return next_page_id_++; }
+void BufferPoolManagerInstance::PrefetchPgImp(page_id_t page_id, size_t num_pages, AccessType access_type) {
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  if (access_type == AccessType::Scan) {
+    // Anything beyond this would be recycled by the scan ring before the scan gets to it.
+    num_pages = std::min(num_pages, std::max<size_t>(1, scan_ring_capacity_ / 2));
+  }
+  for (size_t i = 0; i < num_pages; i++) {
+    const page_id_t prefetch_page_id = page_id + static_cast<page_id_t>(i);
+    frame_id_t frame_id;
+    if (prefetch_page_id % static_cast<page_id_t>(num_instances_) != static_cast<page_id_t>(instance_index_) ||
+        page_table_->Find(prefetch_page_id, &frame_id) || disk_manager_->IsFreePage(prefetch_page_id)) {
+      continue;
+    }
+
+    auto lock = LockLatch();
+    if (prefetch_page_id >= next_page_id_ || IsUncreated(prefetch_page_id) ||
+        page_table_->Find(prefetch_page_id, &frame_id)) {
+      continue;
+    }
+    if (compressed_cache_ != nullptr && compressed_cache_->Contains(prefetch_page_id)) {
+      // Fetching it will be cheaper than reading it.
+      continue;
+    }
+    if (!(access_type == AccessType::Scan ? AcquireScanFrame(&frame_id) : AcquireFrame(&frame_id))) {
+      return;
+    }
+    Page &page = pages_[frame_id];
+    page.page_id_ = prefetch_page_id;
+    page.is_dirty_ = false;
+    page_table_->Insert(prefetch_page_id, frame_id);
+    scan_only_[frame_id] = access_type == AccessType::Scan;
+    prefetched_[frame_id] = true;
+    replacer_->RecordAccess(frame_id, access_type);
+    replacer_->SetEvictable(frame_id, true);
+    {
+      std::scoped_lock<std::mutex> io_lock(io_latch_);
+      reads_in_flight_++;
+    }
+    stats_.RecordPrefetch();
+    if (auto *query = QueryIoScope::Current(); query != nullptr) {
+      // The read completes on an I/O thread, outside the query's scope.
+      query->read_bytes_ += BUSTUB_PAGE_SIZE;
+    }
+    disk_manager_->ReadPageAsync(prefetch_page_id, page.GetData(), [this, &page](bool verified) {
+      if (!verified) {
+        // Keep the page out of reach: hits check the frame's page id, and FetchPgImp() drops the stale page table
+        // entry and reads the page itself, which reports the corruption to the caller.
+        page.page_id_ = INVALID_PAGE_ID;
+      }
+      // Publish the frame, as the miss path does once it has read the page.
+      page.pin_count_.store(0, std::memory_order_release);
+      // Notify under the latch: once reads_in_flight_ drops to 0 the destructor may destroy io_cv_.
+      std::scoped_lock<std::mutex> io_lock(io_latch_);
+      reads_in_flight_--;
+      io_cv_.notify_all();
+    });
+  }
+}
+
+auto BufferPoolManagerInstance::TryPinResident(page_id_t page_id, AccessType access_type) -> Page * {
+  frame_id_t frame_id;
+  if (!page_table_->Find(page_id, &frame_id)) {
+    return nullptr;
+  }
+  Page &page = pages_[frame_id];
+  int pin_count = page.pin_count_.load(std::memory_order_acquire);
+  do {
+    if (pin_count < 0) {
+      // The frame is being evicted, loaded or deleted.
+      return nullptr;
+    }
+  } while (!page.pin_count_.compare_exchange_weak(pin_count, pin_count + 1, std::memory_order_acq_rel));
+  if (page.GetPageId() != page_id) {
+    // The frame was recycled between the lookup and the pin.
+    page.pin_count_.fetch_sub(1);
+    return nullptr;
+  }
+  RecordAccess(frame_id, access_type);
+  stats_.RecordHit();
+  return &page;
+}
+
+auto BufferPoolManagerInstance::AcquireFrame(frame_id_t *frame_id) -> bool {
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    // A reader holding a stale page table entry may have this frame pinned for a moment; wait it out.
+    int expected = 0;
+    while (!pages_[*frame_id].pin_count_.compare_exchange_weak(expected, -1)) {
+      expected = 0;
+      std::this_thread::yield();
+    }
+    return true;
+  }
+
+  bool claimed = false;
+  std::array<frame_id_t, EVICTION_LOOKAHEAD> candidates;
+  const size_t num_candidates = replacer_->PeekVictims(candidates.data(), candidates.size());
+  for (size_t i = 0; i < num_candidates; i++) {
+    const frame_id_t candidate = candidates[i];
+    int expected = 0;
+    if (!pages_[candidate].IsDirty() && pages_[candidate].pin_count_.compare_exchange_strong(expected, -1)) {
+      replacer_->Remove(candidate);
+      *frame_id = candidate;
+      claimed = true;
+      break;
+    }
+  }
+
+  if (!claimed) {
+    // Pinned frames are skipped but keep their access history in the replacer.
+    auto claim = [this](frame_id_t candidate) {
+      int expected = 0;
+      return pages_[candidate].pin_count_.compare_exchange_strong(expected, -1);
+    };
+    if (!replacer_->Evict(frame_id, claim)) {
+      return false;
+    }
+  }
+
+  Page &page = pages_[*frame_id];
+  // The page can also have been dirtied between the check above and the claim.
+  const bool dirty = page.IsDirty();
+  if (dirty) {
+    if (!disk_manager_->WritePage(page.GetPageId(), page.GetData())) {
+      // The page stays in its frame, dirty, and the miss fails as if every frame were pinned. The frame was taken out
+      // of the replacer, so it comes back as if just accessed.
+      replacer_->RecordAccess(*frame_id);
+      replacer_->SetEvictable(*frame_id, true);
+      page.pin_count_.store(0, std::memory_order_release);
+      return false;
+    }
+    page.is_dirty_ = false;
+    if (enable_background_flush_) {
+      // The flusher is falling behind; wake it up instead of waiting for the next interval.
+      flush_requested_ = true;
+      flush_cv_.notify_one();
+    }
+  }
+  if (page.GetPageId() != INVALID_PAGE_ID) {
+    stats_.RecordEviction(dirty);
+  }
+  if (compressed_cache_ != nullptr && page.GetPageId() != INVALID_PAGE_ID && !scan_only_[*frame_id]) {
+    compressed_cache_->Put(page.GetPageId(), page.GetData());
+  }
+  page_table_->Remove(page.GetPageId());
+  return true;
+}
+
+auto BufferPoolManagerInstance::AcquireScanFrame(frame_id_t *frame_id) -> bool {
+  if (scan_ring_.size() < scan_ring_capacity_) {
+    if (!AcquireFrame(frame_id)) {
+      return false;
+    }
+    scan_ring_.push_back(*frame_id);
+    return true;
+  }
+
+  const size_t slot = scan_ring_next_;
+  scan_ring_next_ = (scan_ring_next_ + 1) % scan_ring_capacity_;
+  const frame_id_t candidate = scan_ring_[slot];
+  Page &page = pages_[candidate];
+  int expected = 0;
+  if (page.pin_count_.compare_exchange_strong(expected, -1)) {
+    // Check only after claiming, so that no other access can sneak in between the check and the reuse.
+    const bool dirty = page.IsDirty();
+    if (scan_only_[candidate] && (!dirty || disk_manager_->WritePage(page.GetPageId(), page.GetData()))) {
+      // Resident frames are always evictable in the replacer.
+      replacer_->Remove(candidate);
+      stats_.RecordEviction(dirty);
+      page.is_dirty_ = false;
+      page_table_->Remove(page.GetPageId());
+      *frame_id = candidate;
+      return true;
+    }
+    page.pin_count_.store(0, std::memory_order_release);
+  }
+
+  // The frame is pinned, its page has been promoted out of the ring, or its page could not be written back and stays
+  // dirty; leave it be and refill the slot.
+  if (!AcquireFrame(frame_id)) {
+    return false;
+  }
+  scan_ring_[slot] = *frame_id;
+  return true;
+}
+
+auto BufferPoolManagerInstance::LockLatch() -> std::unique_lock<std::mutex> {
+  std::unique_lock<std::mutex> lock(latch_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    // Only read the clock when there is a wait to time, which keeps the uncontended path as cheap as before.
+    auto start = std::chrono::steady_clock::now();
+    lock.lock();
+    auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    stats_.RecordLatchWait(static_cast<uint64_t>(waited.count()));
+  }
+  return lock;
+}
+
+void BufferPoolManagerInstance::RecordAccess(frame_id_t frame_id, AccessType access_type) {
+  // Read before writing, so that scans and hot hits do not all store to the same cache line.
+  if (access_type != AccessType::Scan && scan_only_[frame_id].load(std::memory_order_relaxed)) {
+    scan_only_[frame_id].store(false, std::memory_order_relaxed);
+  }
+  if (prefetched_[frame_id].load(std::memory_order_relaxed) && prefetched_[frame_id].exchange(false)) {
+    stats_.RecordPrefetchHit();
+  }
+  replacer_->RecordAccess(frame_id, access_type);
+}
+
+void BufferPoolManagerInstance::StartBackgroundFlusher(double clean_fraction) {
+  BUSTUB_ASSERT(clean_fraction > 0 && clean_fraction <= 1, "clean fraction must be in (0, 1]");
+  if (flush_thread_ != nullptr) {
+    return;
+  }
+  clean_fraction_ = clean_fraction;
+  enable_background_flush_ = true;
+  flush_thread_ = new std::thread(&BufferPoolManagerInstance::RunBackgroundFlusher, this);
+}
+
+void BufferPoolManagerInstance::EnableCompressedCache(size_t budget_bytes) {
+  BUSTUB_ASSERT(compressed_cache_ == nullptr, "the compressed page cache is already enabled");
+  compressed_cache_ = new CompressedPageCache(budget_bytes);
+}
+
+auto BufferPoolManagerInstance::GetCompressedCacheStats() -> CompressedPageCache::Stats {
+  return compressed_cache_ != nullptr ? compressed_cache_->GetStats() : CompressedPageCache::Stats{};
+}
+
+void BufferPoolManagerInstance::StopBackgroundFlusher() {
+  if (flush_thread_ == nullptr) {
+    return;
+  }
+  {
+    std::scoped_lock<std::mutex> lock(flush_latch_);
+    enable_background_flush_ = false;
+  }
+  flush_cv_.notify_one();
+  flush_thread_->join();
+  delete flush_thread_;
+  flush_thread_ = nullptr;
+}
+
+void BufferPoolManagerInstance::RunBackgroundFlusher() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(flush_latch_);
+      flush_cv_.wait_for(lock, background_flush_interval,
+                         [this] { return !enable_background_flush_ || flush_requested_; });
+      if (!enable_background_flush_) {
+        return;
+      }
+      flush_requested_ = false;
+    }
+    auto target = static_cast<size_t>(std::ceil(clean_fraction_ * static_cast<double>(replacer_->Size())));
+    const size_t num_victims = replacer_->PeekVictims(flush_victims_.data(), std::min(target, flush_victims_.size()));
+    for (size_t i = 0; i < num_victims; i++) {
+      FlushFrameInBackground(flush_victims_[i]);
+    }
+  }
+}
+
+auto BufferPoolManagerInstance::FlushFrameInBackground(frame_id_t frame_id) -> bool {
+  Page &page = pages_[frame_id];
+  if (!page.IsDirty()) {
+    return false;
+  }
+  // Pin the frame like a reader would, so that it cannot be evicted or recycled while we write it. Only unpinned frames
+  // are worth cleaning: anyone holding a pin is likely to dirty the page again.
+  int expected = 0;
+  if (!page.pin_count_.compare_exchange_strong(expected, 1)) {
+    return false;
+  }
+  bool flushed = false;
+  if (page.GetPageId() != INVALID_PAGE_ID && page.IsDirty()) {
+    page.RLatch();
+    // Clear the flag before writing: a writer that modifies the page from here on marks it dirty again when it unpins.
+    page.is_dirty_ = false;
+    flushed = disk_manager_->WritePage(page.GetPageId(), page.GetData());
+    if (!flushed) {
+      page.is_dirty_ = true;
+    }
+    page.RUnlatch();
+  }
+  page.pin_count_.fetch_sub(1);
+  return flushed;
+}
+
+auto BufferPoolManagerInstance::AllocatePage(bool *reused) -> page_id_t {
+  const page_id_t free_page_id = disk_manager_->AllocateFreePage(num_instances_, instance_index_);
+  if (free_page_id != INVALID_PAGE_ID) {
+    ValidatePageId(free_page_id);
+    // The counter only moves on while the map has no page for this instance. A page can still be ahead of it, e.g.
+    // one freed by an earlier pool over the same file, so move the counter past the page before handing it out.
+    page_id_t next_page_id = next_page_id_.load();
+    while (next_page_id <= free_page_id &&
+           !next_page_id_.compare_exchange_weak(next_page_id, free_page_id + static_cast<page_id_t>(num_instances_))) {
+    }
+    *reused = true;
+    return free_page_id;
+  }
+  // Stop short of the largest id instead of wrapping around to negative ones.
+  const auto step = static_cast<page_id_t>(num_instances_);
+  page_id_t next_page_id = next_page_id_.load();
+  do {
+    if (next_page_id > std::numeric_limits<page_id_t>::max() - step) {
+      return INVALID_PAGE_ID;
+    }
+  } while (!next_page_id_.compare_exchange_weak(next_page_id, next_page_id + step));
+  ValidatePageId(next_page_id);
+  *reused = false;
+  return next_page_id;
+}
+
+auto BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) -> bool {
+  if (compressed_cache_ != nullptr) {
+    compressed_cache_->Erase(page_id);
+  }
+  return disk_manager_->DeallocatePage(page_id);
+}
+
+auto BufferPoolManagerInstance::AllocateExtentImp(size_t num_pages) -> page_id_t {
+  if (num_instances_ != 1 || num_pages > static_cast<size_t>(std::numeric_limits<page_id_t>::max())) {
+    return INVALID_PAGE_ID;
+  }
+  const auto extent_pages = static_cast<page_id_t>(num_pages);
+  page_id_t first = next_page_id_.load();
+  do {
+    if (first > std::numeric_limits<page_id_t>::max() - extent_pages) {
+      return INVALID_PAGE_ID;
+    }
+  } while (!next_page_id_.compare_exchange_weak(first, first + extent_pages));
+  auto lock = LockLatch();
+  uncreated_pages_.emplace(first, first + extent_pages);
+  return first;
+}
+
+auto BufferPoolManagerInstance::ReservePageIds(page_id_t first, page_id_t end) -> bool {
+  const page_id_t begin = FirstPageIdFrom(first);
+  const page_id_t stop = FirstPageIdFrom(end);
+  page_id_t next_page_id = next_page_id_.load();
+  do {
+    if (next_page_id > begin) {
+      return false;
+    }
+  } while (!next_page_id_.compare_exchange_weak(next_page_id, stop));
+  for (page_id_t page_id = next_page_id; page_id < begin; page_id += static_cast<page_id_t>(num_instances_)) {
+    disk_manager_->DeallocatePage(page_id);
+  }
+  if (begin < stop) {
+    auto lock = LockLatch();
+    uncreated_pages_.emplace(begin, stop);
+  }
+  return true;
+}
+
+auto BufferPoolManagerInstance::FirstPageIdFrom(page_id_t page_id) const -> page_id_t {
+  auto offset = static_cast<page_id_t>((instance_index_ + num_instances_ - page_id % num_instances_) % num_instances_);
+  return page_id + offset;
+}
+
+void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
+  assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
+}
 
 }  // namespace bustub
@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.cpp
+//
+// Identification: src/buffer/compressed_page_cache.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/compressed_page_cache.h"
+
+#include <array>
+#include <iterator>
+#include <utility>
+
+#include "common/util/lz4.h"
+
+namespace bustub {
+
+auto CompressedPageCache::Stats::operator+=(const Stats &other) -> Stats & {
+  hits_ += other.hits_;
+  misses_ += other.misses_;
+  insertions_ += other.insertions_;
+  rejections_ += other.rejections_;
+  evictions_ += other.evictions_;
+  used_bytes_ += other.used_bytes_;
+  num_pages_ += other.num_pages_;
+  return *this;
+}
+
+void CompressedPageCache::Put(page_id_t page_id, const char *data) {
+  std::array<char, BUSTUB_PAGE_SIZE - BUSTUB_PAGE_SIZE / 8> buffer;
+  const size_t size = Lz4::Compress(data, BUSTUB_PAGE_SIZE, buffer.data(), buffer.size());
+
+  std::scoped_lock lock(latch_);
+  if (auto it = entries_.find(page_id); it != entries_.end()) {
+    EraseEntry(it->second);
+  }
+  if (size == 0 || size > budget_bytes_) {
+    stats_.rejections_++;
+    return;
+  }
+  while (used_bytes_ + size > budget_bytes_) {
+    EraseEntry(std::prev(lru_.end()));
+    stats_.evictions_++;
+  }
+  lru_.push_front(Entry{page_id, std::vector<char>(buffer.data(), buffer.data() + size)});
+  entries_[page_id] = lru_.begin();
+  used_bytes_ += size;
+  stats_.insertions_++;
+}
+
+auto CompressedPageCache::Get(page_id_t page_id, char *data) -> bool {
+  std::vector<char> compressed;
+  {
+    std::scoped_lock lock(latch_);
+    auto it = entries_.find(page_id);
+    if (it == entries_.end()) {
+      stats_.misses_++;
+      return false;
+    }
+    compressed = EraseEntry(it->second);
+    stats_.hits_++;
+  }
+  // Only this tier ever compressed the block, so it can only fail to decompress if memory was corrupted.
+  BUSTUB_ENSURE(Lz4::Decompress(compressed.data(), compressed.size(), data, BUSTUB_PAGE_SIZE),
+                "corrupted page in the compressed page cache");
+  return true;
+}
+
+auto CompressedPageCache::Contains(page_id_t page_id) -> bool {
+  std::scoped_lock lock(latch_);
+  return entries_.find(page_id) != entries_.end();
+}
+
+void CompressedPageCache::Erase(page_id_t page_id) {
+  std::scoped_lock lock(latch_);
+  if (auto it = entries_.find(page_id); it != entries_.end()) {
+    EraseEntry(it->second);
+  }
+}
+
+auto CompressedPageCache::GetStats() -> Stats {
+  std::scoped_lock lock(latch_);
+  Stats stats = stats_;
+  stats.used_bytes_ = used_bytes_;
+  stats.num_pages_ = entries_.size();
+  return stats;
+}
+
+auto CompressedPageCache::EraseEntry(std::list<Entry>::iterator entry) -> std::vector<char> {
+  std::vector<char> data = std::move(entry->data_);
+  used_bytes_ -= data.size();
+  entries_.erase(entry->page_id_);
+  lru_.erase(entry);
+  return data;
+}
+
+}  // namespace bustub
@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+#include <cstdint>
+
+#include "common/exception.h"
+#include "common/util/numa.h"
+
+namespace bustub {
+
+FrameArena::FrameArena(size_t num_frames, int numa_node) {
+  size_t size = num_frames * BUSTUB_PAGE_SIZE;
+  void *data = MAP_FAILED;
+  if (size >= HUGE_PAGE_SIZE) {
+    mapped_size_ = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+#ifdef MAP_HUGETLB
+    data = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED) {
+      huge_pages_ = HugePages::RESERVED;
+    }
+#endif
+    if (data == MAP_FAILED) {
+      // Over-allocate by a huge page so that the arena can start on a huge page boundary, where THP can back it.
+      size_t unaligned_size = mapped_size_ + HUGE_PAGE_SIZE;
+      void *unaligned = mmap(nullptr, unaligned_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (unaligned != MAP_FAILED) {
+        auto start = reinterpret_cast<uintptr_t>(unaligned);
+        auto aligned = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+        if (aligned > start) {
+          munmap(unaligned, aligned - start);
+        }
+        size_t tail = start + unaligned_size - (aligned + mapped_size_);
+        if (tail > 0) {
+          munmap(reinterpret_cast<void *>(aligned + mapped_size_), tail);
+        }
+        data = reinterpret_cast<void *>(aligned);
+#ifdef MADV_HUGEPAGE
+        if (madvise(data, mapped_size_, MADV_HUGEPAGE) == 0) {
+          huge_pages_ = HugePages::TRANSPARENT;
+        }
+#endif
+      }
+    }
+  } else {
+    mapped_size_ = size > 0 ? size : BUSTUB_PAGE_SIZE;
+    data = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  }
+  if (data == MAP_FAILED) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't map the frames of the buffer pool");
+  }
+  data_ = static_cast<char *>(data);
+  // Nothing has been faulted in yet, so the whole arena follows the policy.
+  if (numa_node >= 0 && Numa::BindMemory(data_, mapped_size_, numa_node)) {
+    numa_node_ = numa_node;
+  }
+}
+
+FrameArena::~FrameArena() { munmap(data_, mapped_size_); }
+
+}  // namespace bustub
@@ -12,204 +12,235 @@
 
 #include "buffer/lru_k_replacer.h"
 #include <algorithm>
-#include <exception>
-#include <iostream>
-#include <stdexcept>
+#include <functional>
 #include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "common/exception.h"
 
 namespace bustub {
 
-LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(num_frames), k_(k) {}
+LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k)
+    : replacer_size_(num_frames), k_(k), frames_(num_frames), history_(num_frames * k) {
+  BUSTUB_ASSERT(k > 0, "k must be positive");
+  heap_.reserve(num_frames);
+  skipped_.reserve(num_frames);
+  peek_frontier_.reserve(num_frames);
+  peek_candidates_.reserve(num_frames);
+}
 
 auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
-  if (Size() == 0) {
-    return false;
-  }
+  return Evict(frame_id, [](frame_id_t) { return true; });
+}
 
-  bool res = std::any_of(history_time_id_.begin(), history_time_id_.end(), [&](const std::pair<size_t, frame_id_t> it) {
-    auto [ti, id] = it;
-    if (history_is_evictable_.count(id) != 0U) {
-      *frame_id = id;
-      history_id_time_.erase(std::make_pair(id, ti));
-      history_time_id_.erase(std::make_pair(ti, id));
-      history_cnt_.erase(id);
-      history_is_evictable_.erase(id);
-      return true;
+auto LRUKReplacer::Evict(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &can_evict) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  bool evicted = false;
+  while (!heap_.empty()) {
+    const frame_id_t top = heap_.front();
+    auto &entry = frames_[top];
+    if (!entry.evictable_) {
+      HeapErase(top);
+      continue;
     }
-    return false;
-  });
-
-  if (res) {
-    return res;
-  }
-
-  res = std::any_of(cache_time_id_.begin(), cache_time_id_.end(), [&](const std::pair<size_t, frame_id_t> it) {
-    auto [ti, id] = it;
-    if (cache_is_evictable_.count(id) != 0U) {
-      *frame_id = id;
-      cache_id_time_.erase(std::make_pair(id, ti));
-      cache_time_id_.erase(std::make_pair(ti, id));
-      cache_is_evictable_.erase(id);
-      return true;
+    // Every other frame's key is at least its heap key, so the top is the victim once its own heap key is current.
+    auto key = EvictionKey(top);
+    if (key != entry.heap_key_) {
+      entry.heap_key_ = key;
+      HeapSiftDown(0);
+      continue;
+    }
+    HeapErase(top);
+    if (!can_evict(top)) {
+      skipped_.push_back(top);
+      continue;
     }
-    return false;
-  });
-  return res;
+    ResetFrame(top);
+    curr_size_--;
+    *frame_id = top;
+    evicted = true;
+    break;
+  }
+  // The skipped frames were not accessed, so they go back to where they were in the eviction order.
+  for (auto skipped : skipped_) {
+    HeapPush(skipped);
+  }
+  skipped_.clear();
+  return evicted;
 }
 
-void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+auto LRUKReplacer::PeekVictims(frame_id_t *victims, size_t max_frames) -> size_t {
   std::scoped_lock<std::mutex> lock(latch_);
-  try {
-    if (frame_id < 0 || frame_id >= static_cast<frame_id_t>(replacer_size_)) {
-      throw std::runtime_error("The frame id is invalid!");
+  size_t num_victims = 0;
+  // Walk the heap best-first by heap key, the lower bound of every key below a node. A frame that was walked is the
+  // next victim once its current key is no larger than the heap key of every node not walked yet. Both queues are
+  // min-heaps kept in the preallocated scratch vectors; each holds at most one entry per heap node.
+  auto &frontier = peek_frontier_;
+  auto &candidates = peek_candidates_;
+  auto frontier_greater = [this](size_t lhs, size_t rhs) { return HeapLess(rhs, lhs); };
+  auto candidate_greater = std::greater<>();
+  frontier.clear();
+  candidates.clear();
+  if (!heap_.empty()) {
+    frontier.push_back(0);
+  }
+  while (num_victims < max_frames) {
+    if (!candidates.empty() &&
+        (frontier.empty() || candidates.front().first <= frames_[heap_[frontier.front()]].heap_key_)) {
+      victims[num_victims++] = candidates.front().second;
+      std::pop_heap(candidates.begin(), candidates.end(), candidate_greater);
+      candidates.pop_back();
+      continue;
+    }
+    if (frontier.empty()) {
+      break;
+    }
+    size_t index = frontier.front();
+    std::pop_heap(frontier.begin(), frontier.end(), frontier_greater);
+    frontier.pop_back();
+    if (frames_[heap_[index]].evictable_) {
+      candidates.emplace_back(EvictionKey(heap_[index]), heap_[index]);
+      std::push_heap(candidates.begin(), candidates.end(), candidate_greater);
+    }
+    for (size_t child = 2 * index + 1; child <= 2 * index + 2 && child < heap_.size(); child++) {
+      frontier.push_back(child);
+      std::push_heap(frontier.begin(), frontier.end(), frontier_greater);
     }
-  } catch (const std::exception &e) {
-    std::cerr << e.what() << '\n';
   }
+  return num_victims;
+}
 
-  auto it = cache_id_time_.lower_bound(std::make_pair(frame_id, 0));
-  if (it != cache_id_time_.end() && it->first == frame_id) {  // 在cache queue里, 更新时间
-    auto [id, ti] = *it;
-    auto it2 = cache_time_id_.lower_bound(std::make_pair(ti, id));
-    cache_id_time_.erase(it);
-    cache_time_id_.erase(it2);
-    cache_id_time_.insert(std::make_pair(id, current_timestamp_));
-    cache_time_id_.insert(std::make_pair(current_timestamp_, id));
-    current_timestamp_ += 1;
-  } else {
-    it = history_id_time_.lower_bound(std::make_pair(frame_id, 0));
-    if (it != history_id_time_.end() && it->first == frame_id) {  // 在history queue里
-      auto [id, ti] = *it;
-      auto it2 = history_time_id_.lower_bound(std::make_pair(ti, id));
-      history_cnt_[frame_id]++;
-      if (history_cnt_[frame_id] == k_) {  // his queue里删除, 添加到cache queue
-        history_id_time_.erase(it);
-        history_time_id_.erase(it2);
-        history_cnt_.erase(frame_id);
-        // 不可驱逐性保持一致
-        if (history_is_evictable_.count(frame_id) != 0U) {
-          if (cache_is_evictable_.size() == replacer_size_) {  // cache满了, 删一个
-            for (auto it3 : cache_time_id_) {
-              if (cache_is_evictable_.count(it3.second) != 0U) {
-                cache_is_evictable_.erase(it3.second);
-                cache_id_time_.erase(std::make_pair(it3.second, it3.first));
-                cache_time_id_.erase(std::make_pair(it3.first, it3.second));
-                break;
-              }
-            }
-          }
-          history_is_evictable_.erase(frame_id);
-          cache_is_evictable_.insert(frame_id);
-        }
-        cache_id_time_.insert(std::make_pair(id, current_timestamp_));
-        cache_time_id_.insert(std::make_pair(current_timestamp_, id));
-        current_timestamp_ += 1;
-      }
-    } else {  // 不在cache, 也不在his中
-      // 默认不可以删除, 所以his queue的size不会变大, 不用判断要不要删除
-      history_cnt_[frame_id] = 1;
-      history_time_id_.insert(std::make_pair(current_timestamp_, frame_id));
-      history_id_time_.insert(std::make_pair(frame_id, current_timestamp_));
-      current_timestamp_ += 1;
-      // history_is_evictable_.insert(frame_id);  // 默认不可以删除
-    }
+void LRUKReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
+  CheckFrameId(frame_id);
+  auto &entry = frames_[frame_id];
+  if (access_type == AccessType::Scan && entry.num_accesses_.load(std::memory_order_relaxed) > 0) {
+    return;
   }
+  // The new access can only move the oldest retained timestamp forward, so the frame's heap key stays a lower bound.
+  size_t timestamp = current_timestamp_.fetch_add(1, std::memory_order_relaxed);
+  size_t access = entry.num_accesses_.fetch_add(1, std::memory_order_acq_rel);
+  history_[frame_id * k_ + access % k_].store(timestamp, std::memory_order_release);
 }
 
 void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
   std::scoped_lock<std::mutex> lock(latch_);
-  try {
-    if (frame_id < 0 || frame_id >= static_cast<frame_id_t>(replacer_size_)) {
-      throw std::runtime_error("The frame id is invalid!");
+  CheckFrameId(frame_id);
+  auto &entry = frames_[frame_id];
+  if (entry.num_accesses_.load(std::memory_order_acquire) == 0 || entry.evictable_ == set_evictable) {
+    return;
+  }
+  entry.evictable_ = set_evictable;
+  if (set_evictable) {
+    // A frame that is still in the heap keeps its place; its heap key is still a lower bound.
+    if (entry.heap_index_ == NOT_IN_HEAP) {
+      HeapPush(frame_id);
     }
-  } catch (const std::exception &e) {
-    std::cerr << e.what() << '\n';
+    curr_size_++;
+  } else {
+    curr_size_--;
   }
+}
 
-  auto it = history_id_time_.lower_bound(std::make_pair(frame_id, 0));
-  if (it != history_id_time_.end() && it->first == frame_id) {
-    if (set_evictable && history_is_evictable_.count(frame_id) == 0U) {
-      if (history_is_evictable_.size() == replacer_size_) {  // his queue满了
-        for (auto [ti, id] : history_time_id_) {
-          if (history_is_evictable_.count(id) != 0U) {
-            history_is_evictable_.erase(id);
-            history_id_time_.erase(std::make_pair(id, ti));
-            history_time_id_.erase(std::make_pair(ti, id));
-            history_cnt_[id] = 0;
-            break;
-          }
-        }
-      }
-      history_is_evictable_.insert(frame_id);
-    } else if (!set_evictable) {
-      history_is_evictable_.erase(frame_id);
-    }
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
+  auto &entry = frames_[frame_id];
+  if (entry.num_accesses_.load(std::memory_order_acquire) == 0) {
     return;
   }
-  it = cache_id_time_.lower_bound(std::make_pair(frame_id, 0));
-  if (it != cache_id_time_.end() && it->first == frame_id) {
-    if (set_evictable && cache_is_evictable_.count(frame_id) == 0U) {
-      if (cache_is_evictable_.size() == replacer_size_) {  // cache满了, 删一个
-        for (auto it : cache_time_id_) {
-          if (cache_is_evictable_.count(it.second) != 0U) {
-            cache_is_evictable_.erase(it.second);
-            cache_id_time_.erase(std::make_pair(it.second, it.first));
-            cache_time_id_.erase(std::make_pair(it.first, it.second));
-            break;
-          }
-        }
-      }
-      cache_is_evictable_.insert(frame_id);
-    } else if (!set_evictable) {
-      cache_is_evictable_.erase(frame_id);
-    }
+  if (!entry.evictable_) {
+    throw Exception(ExceptionType::INVALID, "cannot remove a non-evictable frame from the replacer");
   }
+  HeapErase(frame_id);
+  ResetFrame(frame_id);
+  curr_size_--;
 }
 
-void LRUKReplacer::Remove(frame_id_t frame_id) {
+auto LRUKReplacer::Size() -> size_t {
   std::scoped_lock<std::mutex> lock(latch_);
-  try {
-    if (frame_id < 0 || frame_id >= static_cast<frame_id_t>(replacer_size_)) {
-      throw std::runtime_error("The frame id is invalid!");
+  return curr_size_;
+}
+
+auto LRUKReplacer::EvictionKey(frame_id_t frame_id) const -> EvictionKeyType {
+  size_t num_accesses = frames_[frame_id].num_accesses_.load(std::memory_order_acquire);
+  bool has_k_accesses = num_accesses >= k_;
+  // Before the ring wraps the oldest access is in slot 0, afterwards it is the slot the next access overwrites.
+  size_t oldest = history_[frame_id * k_ + (has_k_accesses ? num_accesses % k_ : 0)].load(std::memory_order_acquire);
+  return {has_k_accesses, oldest};
+}
+
+void LRUKReplacer::HeapSwap(size_t lhs, size_t rhs) {
+  std::swap(heap_[lhs], heap_[rhs]);
+  frames_[heap_[lhs]].heap_index_ = lhs;
+  frames_[heap_[rhs]].heap_index_ = rhs;
+}
+
+void LRUKReplacer::HeapSiftUp(size_t index) {
+  while (index > 0) {
+    size_t parent = (index - 1) / 2;
+    if (!HeapLess(index, parent)) {
+      break;
     }
-  } catch (const std::exception &e) {
-    std::cerr << e.what() << '\n';
+    HeapSwap(index, parent);
+    index = parent;
   }
-  auto it = history_id_time_.lower_bound(std::make_pair(frame_id, 0));
-  if (it != history_id_time_.end() && it->first == frame_id) {
-    try {
-      if (history_is_evictable_.count(frame_id) == 0U) {
-        throw std::runtime_error("The frame is not evictable!");
-      }
-      history_is_evictable_.erase(frame_id);
-      history_cnt_[frame_id] = 0;
-      history_time_id_.erase(std::make_pair(it->second, it->first));
-      history_id_time_.erase(it);
-    } catch (const std::exception &e) {
-      std::cerr << e.what() << '\n';
+}
+
+void LRUKReplacer::HeapSiftDown(size_t index) {
+  while (true) {
+    size_t smallest = index;
+    size_t left = 2 * index + 1;
+    size_t right = left + 1;
+    if (left < heap_.size() && HeapLess(left, smallest)) {
+      smallest = left;
     }
-    return;
-  }
-  it = cache_id_time_.lower_bound(std::make_pair(frame_id, 0));
-  if (it != cache_id_time_.end() && it->first == frame_id) {
-    try {
-      if (cache_is_evictable_.count(frame_id) == 0U) {
-        throw std::runtime_error("The frame is not evictable!");
-      }
-      cache_is_evictable_.erase(frame_id);
-      cache_time_id_.erase(std::make_pair(it->second, it->first));
-      cache_id_time_.erase(it);
-    } catch (const std::exception &e) {
-      std::cerr << e.what() << '\n';
+    if (right < heap_.size() && HeapLess(right, smallest)) {
+      smallest = right;
     }
-    return;
+    if (smallest == index) {
+      break;
+    }
+    HeapSwap(index, smallest);
+    index = smallest;
+  }
+}
+
+void LRUKReplacer::HeapPush(frame_id_t frame_id) {
+  auto &entry = frames_[frame_id];
+  entry.heap_key_ = EvictionKey(frame_id);
+  entry.heap_index_ = heap_.size();
+  heap_.push_back(frame_id);
+  HeapSiftUp(entry.heap_index_);
+}
+
+void LRUKReplacer::HeapErase(frame_id_t frame_id) {
+  auto &entry = frames_[frame_id];
+  size_t index = entry.heap_index_;
+  size_t last = heap_.size() - 1;
+  if (index != last) {
+    HeapSwap(index, last);
+  }
+  heap_.pop_back();
+  entry.heap_index_ = NOT_IN_HEAP;
+  if (index < heap_.size()) {
+    // The element moved into the hole can belong either above or below it.
+    frame_id_t moved = heap_[index];
+    HeapSiftUp(index);
+    HeapSiftDown(frames_[moved].heap_index_);
   }
 }
 
-auto LRUKReplacer::Size() -> size_t { return history_is_evictable_.size() + cache_is_evictable_.size(); }
+void LRUKReplacer::ResetFrame(frame_id_t frame_id) {
+  auto &entry = frames_[frame_id];
+  entry.num_accesses_.store(0, std::memory_order_release);
+  entry.evictable_ = false;
+}
+
+void LRUKReplacer::CheckFrameId(frame_id_t frame_id) const {
+  if (frame_id < 0 || static_cast<size_t>(frame_id) >= replacer_size_) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "frame id is out of range of the replacer");
+  }
+}
 
 }  // namespace bustub
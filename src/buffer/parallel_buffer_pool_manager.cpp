@@ -0,0 +1,194 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "common/macros.h"
+#include "common/util/numa.h"
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                                     size_t replacer_k, LogManager *log_manager)
+    : num_instances_(num_instances), pool_size_(pool_size), disk_manager_(disk_manager) {
+  BUSTUB_ASSERT(num_instances > 0, "a parallel buffer pool needs at least one instance");
+  const int num_nodes = Numa::NumNodes();
+  instances_.reserve(num_instances_);
+  for (size_t i = 0; i < num_instances_; i++) {
+    const int numa_node = num_nodes > 1 ? static_cast<int>(i % num_nodes) : -1;
+    instances_.emplace_back(std::make_unique<BufferPoolManagerInstance>(
+        pool_size_, static_cast<uint32_t>(num_instances_), static_cast<uint32_t>(i), disk_manager, replacer_k,
+        log_manager, numa_node));
+    if (instances_.back()->GetNumaNode() >= 0) {
+      num_numa_nodes_ = num_nodes;
+    }
+  }
+}
+
+void ParallelBufferPoolManager::StartBackgroundFlusher(double clean_fraction) {
+  for (auto &instance : instances_) {
+    instance->StartBackgroundFlusher(clean_fraction);
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundFlusher() {
+  for (auto &instance : instances_) {
+    instance->StopBackgroundFlusher();
+  }
+}
+
+void ParallelBufferPoolManager::EnableCompressedCache(size_t budget_bytes) {
+  for (auto &instance : instances_) {
+    instance->EnableCompressedCache(budget_bytes / num_instances_);
+  }
+}
+
+auto ParallelBufferPoolManager::GetCompressedCacheStats() -> CompressedPageCache::Stats {
+  CompressedPageCache::Stats stats;
+  for (auto &instance : instances_) {
+    stats += instance->GetCompressedCacheStats();
+  }
+  return stats;
+}
+
+auto ParallelBufferPoolManager::GetStats() -> IoStats {
+  IoStats stats;
+  for (auto &instance : instances_) {
+    stats += instance->GetStats();
+  }
+  return stats;
+}
+
+auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance * {
+  return instances_[static_cast<size_t>(page_id) % num_instances_].get();
+}
+
+auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id, AccessType access_type) -> Page * {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, access_type);
+}
+
+auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id, AccessType access_type) -> Page * {
+  const size_t start = start_index_.fetch_add(1) % num_instances_;
+  if (num_numa_nodes_ > 1) {
+    const int node = Numa::CurrentNode();
+    for (size_t i = 0; i < num_instances_; i++) {
+      auto &instance = instances_[(start + i) % num_instances_];
+      if (instance->GetNumaNode() != node) {
+        continue;
+      }
+      auto *page = instance->NewPage(page_id, access_type);
+      if (page != nullptr) {
+        return page;
+      }
+    }
+  }
+  for (size_t i = 0; i < num_instances_; i++) {
+    auto *page = instances_[(start + i) % num_instances_]->NewPage(page_id, access_type);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  *page_id = INVALID_PAGE_ID;
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPgsImp() {
+  std::vector<Page *> pages;
+  for (auto &instance : instances_) {
+    instance->CollectDirtyPages(&pages);
+  }
+  BufferPoolManagerInstance::WriteBackPages(disk_manager_, &pages);
+  for (auto *page : pages) {
+    GetBufferPoolManager(page->GetPageId())->UnpinPage(page->GetPageId(), false);
+  }
+  disk_manager_->Sync();
+}
+
+void ParallelBufferPoolManager::PrefetchPgImp(page_id_t page_id, size_t num_pages, AccessType access_type) {
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  for (size_t i = 0; i < num_pages; i++) {
+    auto prefetch_page_id = page_id + static_cast<page_id_t>(i);
+    GetBufferPoolManager(prefetch_page_id)->Prefetch(prefetch_page_id, 1, access_type);
+  }
+}
+
+auto ParallelBufferPoolManager::AllocateExtentImp(size_t num_pages) -> page_id_t {
+  // Every instance rounds the end of the extent up to an id of its own, which must not overflow either.
+  const auto max_page_id = std::numeric_limits<page_id_t>::max();
+  if (num_pages > static_cast<size_t>(max_page_id) - num_instances_) {
+    return INVALID_PAGE_ID;
+  }
+  const auto extent_pages = static_cast<page_id_t>(num_pages);
+  std::scoped_lock lock(extent_latch_);
+  while (true) {
+    page_id_t first = 0;
+    for (auto &instance : instances_) {
+      first = std::max(first, instance->GetNextPageId());
+    }
+    if (first > max_page_id - extent_pages - static_cast<page_id_t>(num_instances_)) {
+      return INVALID_PAGE_ID;
+    }
+    const page_id_t end = first + extent_pages;
+    size_t reserved = 0;
+    while (reserved < num_instances_ && instances_[reserved]->ReservePageIds(first, end)) {
+      reserved++;
+    }
+    if (reserved == num_instances_) {
+      return first;
+    }
+    // An instance allocated past first in the meantime. Free what the others reserved and start over.
+    for (page_id_t page_id = first; page_id < end; page_id++) {
+      if (static_cast<size_t>(page_id) % num_instances_ < reserved) {
+        disk_manager_->DeallocatePage(page_id);
+      }
+    }
+  }
+}
+
+auto ParallelBufferPoolManager::NewPgAtImp(page_id_t page_id, AccessType access_type) -> Page * {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  return GetBufferPoolManager(page_id)->NewPageAt(page_id, access_type);
+}
+
+}  // namespace bustub
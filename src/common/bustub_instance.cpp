@@ -41,11 +41,15 @@ auto BustubInstance::MakeExecutorContext(Transaction *txn) -> std::unique_ptr<Ex
   return std::make_unique<ExecutorContext>(txn, catalog_, buffer_pool_manager_, txn_manager_, lock_manager_);
 }
 
-BustubInstance::BustubInstance(const std::string &db_file_name) {
+BustubInstance::BustubInstance(const std::string &db_file_name, bool read_only) {
   enable_logging = false;
 
   // Storage related.
-  disk_manager_ = new DiskManager(db_file_name);
+  if (read_only) {
+    disk_manager_ = new DiskManagerMmap(db_file_name);
+  } else {
+    disk_manager_ = new DiskManager(db_file_name);
+  }
 
   // Log related.
   log_manager_ = new LogManager(disk_manager_);
@@ -53,7 +57,12 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
   // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
   // buffer pool size specified in `config.h`.
   try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    auto *bpm = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    // Writes go to a real file here, so clean pages ahead of eviction in the background.
+    if (!read_only) {
+      bpm->StartBackgroundFlusher();
+    }
+    buffer_pool_manager_ = bpm;
   } catch (NotImplementedException &e) {
     std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
     buffer_pool_manager_ = nullptr;
@@ -300,6 +309,17 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
           output += "\n";
         }
 
+        // Run the query and print what it read and wrote.
+        if ((explain_stmt.options_ & ExplainOptions::ANALYZE) != 0) {
+          auto exec_ctx = MakeExecutorContext(txn);
+          std::vector<Tuple> result_set{};
+          is_successful &= execution_engine_->Execute(optimized_plan, &result_set, txn, exec_ctx.get());
+          output += "=== ANALYZE ===";
+          output += "\n";
+          output += fmt::format("rows={} {}", result_set.size(), exec_ctx->GetIoStats()->ToString());
+          output += "\n";
+        }
+
         WriteOneCell(output, writer);
 
         continue;
@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_stats.cpp
+//
+// Identification: src/common/io_stats.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/io_stats.h"
+
+#include "fmt/format.h"
+
+namespace bustub {
+
+namespace {
+
+thread_local IoStats *query_io_stats = nullptr;
+
+}  // namespace
+
+auto IoStats::operator+=(const IoStats &other) -> IoStats & {
+  hits_ += other.hits_;
+  misses_ += other.misses_;
+  compressed_hits_ += other.compressed_hits_;
+  prefetches_ += other.prefetches_;
+  prefetch_hits_ += other.prefetch_hits_;
+  evictions_ += other.evictions_;
+  dirty_evictions_ += other.dirty_evictions_;
+  read_bytes_ += other.read_bytes_;
+  write_bytes_ += other.write_bytes_;
+  latch_wait_ns_ += other.latch_wait_ns_;
+  return *this;
+}
+
+auto IoStats::GetHitRatio() const -> double {
+  uint64_t fetches = hits_ + misses_;
+  return fetches == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(fetches);
+}
+
+auto IoStats::ToString() const -> std::string {
+  return fmt::format(
+      "hits={} misses={} hit_ratio={:.3f} compressed_hits={} prefetches={} prefetch_hits={} evictions={} "
+      "dirty_evictions={} read_bytes={} write_bytes={} latch_wait_us={}",
+      hits_, misses_, GetHitRatio(), compressed_hits_, prefetches_, prefetch_hits_, evictions_, dirty_evictions_,
+      read_bytes_, write_bytes_, latch_wait_ns_ / 1000);
+}
+
+auto IoCounters::Snapshot() const -> IoStats {
+  IoStats stats;
+  stats.hits_ = hits_.load(std::memory_order_relaxed);
+  stats.misses_ = misses_.load(std::memory_order_relaxed);
+  stats.compressed_hits_ = compressed_hits_.load(std::memory_order_relaxed);
+  stats.prefetches_ = prefetches_.load(std::memory_order_relaxed);
+  stats.prefetch_hits_ = prefetch_hits_.load(std::memory_order_relaxed);
+  stats.evictions_ = evictions_.load(std::memory_order_relaxed);
+  stats.dirty_evictions_ = dirty_evictions_.load(std::memory_order_relaxed);
+  stats.read_bytes_ = read_bytes_.load(std::memory_order_relaxed);
+  stats.write_bytes_ = write_bytes_.load(std::memory_order_relaxed);
+  stats.latch_wait_ns_ = latch_wait_ns_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+auto IoCounters::QueryStats() -> IoStats * { return query_io_stats; }
+
+QueryIoScope::QueryIoScope(IoStats *stats) : previous_(query_io_stats) { query_io_stats = stats; }
+
+QueryIoScope::~QueryIoScope() { query_io_stats = previous_; }
+
+auto QueryIoScope::Current() -> IoStats * { return query_io_stats; }
+
+}  // namespace bustub
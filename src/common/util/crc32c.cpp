@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.cpp
+//
+// Identification: src/common/util/crc32c.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace bustub {
+
+namespace {
+
+/** Reflected CRC32C polynomial. */
+constexpr uint32_t POLYNOMIAL = 0x82F63B78;
+
+constexpr auto MakeTable() -> std::array<uint32_t, 256> {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) != 0 ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+constexpr std::array<uint32_t, 256> TABLE = MakeTable();
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) auto ComputeHardware(const char *data, size_t length, uint32_t crc) -> uint32_t {
+  uint64_t crc64 = ~crc;
+  while (length >= sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+    data += sizeof(word);
+    length -= sizeof(word);
+  }
+  auto crc32 = static_cast<uint32_t>(crc64);
+  while (length > 0) {
+    crc32 = _mm_crc32_u8(crc32, static_cast<uint8_t>(*data));
+    data++;
+    length--;
+  }
+  return ~crc32;
+}
+#endif
+
+auto HasSse42() -> bool {
+#if defined(__x86_64__)
+  static const bool has_sse42 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") != 0;
+  }();
+  return has_sse42;
+#else
+  return false;
+#endif
+}
+
+}  // namespace
+
+auto Crc32c::Compute(const char *data, size_t length, uint32_t crc) -> uint32_t {
+#if defined(__x86_64__)
+  if (HasSse42()) {
+    return ComputeHardware(data, length, crc);
+  }
+#endif
+  return ComputeSoftware(data, length, crc);
+}
+
+auto Crc32c::IsHardwareAccelerated() -> bool { return HasSse42(); }
+
+auto Crc32c::ComputeSoftware(const char *data, size_t length, uint32_t crc) -> uint32_t {
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc = TABLE[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+}  // namespace bustub
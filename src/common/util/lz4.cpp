@@ -0,0 +1,186 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4.cpp
+//
+// Identification: src/common/util/lz4.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/lz4.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+/** Shortest match the format can encode. */
+constexpr size_t MIN_MATCH = 4;
+/** The last bytes of a block are always literals. */
+constexpr size_t LAST_LITERALS = 5;
+/** No match may start within this many bytes of the end of a block. */
+constexpr size_t MF_LIMIT = 12;
+/** Matches are at most this far back, the range of the 2-byte offset. */
+constexpr size_t MAX_OFFSET = 65535;
+constexpr int HASH_BITS = 12;
+constexpr uint32_t NO_POSITION = UINT32_MAX;
+
+inline auto Load32(const uint8_t *p) -> uint32_t {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline auto Hash(uint32_t sequence) -> uint32_t { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Write the bytes of a length beyond what its 4-bit field holds: runs of 255, then the rest. */
+inline void WriteLength(uint8_t *out, size_t *op, size_t length) {
+  while (length >= 255) {
+    out[(*op)++] = 255;
+    length -= 255;
+  }
+  out[(*op)++] = static_cast<uint8_t>(length);
+}
+
+/** Read the bytes of a length whose 4-bit field is 15 and add them to length. */
+inline auto ReadLength(const uint8_t *in, size_t *ip, size_t src_size, size_t *length) -> bool {
+  uint8_t byte;
+  do {
+    if (*ip >= src_size) {
+      return false;
+    }
+    byte = in[(*ip)++];
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/**
+ * Write one sequence: literals, then a match unless match_length is 0 (which ends the block).
+ * @return false if the sequence does not fit in dst_capacity
+ */
+auto WriteSequence(uint8_t *out, size_t *op, size_t dst_capacity, const uint8_t *literals, size_t literal_length,
+                   size_t offset, size_t match_length) -> bool {
+  const size_t worst = 1 + literal_length / 255 + 1 + literal_length + 2 + match_length / 255 + 1;
+  if (*op + worst > dst_capacity) {
+    return false;
+  }
+  const size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+  const size_t token_op = (*op)++;
+  uint8_t token = static_cast<uint8_t>((literal_length < 15 ? literal_length : 15) << 4);
+  if (literal_length >= 15) {
+    WriteLength(out, op, literal_length - 15);
+  }
+  memcpy(out + *op, literals, literal_length);
+  *op += literal_length;
+  if (match_length != 0) {
+    out[(*op)++] = static_cast<uint8_t>(offset & 0xFF);
+    out[(*op)++] = static_cast<uint8_t>(offset >> 8);
+    token |= static_cast<uint8_t>(match_code < 15 ? match_code : 15);
+    if (match_code >= 15) {
+      WriteLength(out, op, match_code - 15);
+    }
+  }
+  out[token_op] = token;
+  return true;
+}
+
+}  // namespace
+
+auto Lz4::Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) -> size_t {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  auto *out = reinterpret_cast<uint8_t *>(dst);
+  size_t op = 0;
+  size_t anchor = 0;
+
+  if (src_size > MF_LIMIT) {
+    std::array<uint32_t, 1 << HASH_BITS> table;
+    table.fill(NO_POSITION);
+    const size_t match_limit = src_size - LAST_LITERALS;
+    const size_t search_limit = src_size - MF_LIMIT;
+    size_t ip = 0;
+    while (ip <= search_limit) {
+      const uint32_t sequence = Load32(in + ip);
+      const uint32_t hash = Hash(sequence);
+      size_t candidate = table[hash];
+      table[hash] = static_cast<uint32_t>(ip);
+      if (candidate == NO_POSITION || ip - candidate > MAX_OFFSET || Load32(in + candidate) != sequence) {
+        ip++;
+        continue;
+      }
+      // Extend the match backwards over literals not written yet, then forwards.
+      while (ip > anchor && candidate > 0 && in[ip - 1] == in[candidate - 1]) {
+        ip--;
+        candidate--;
+      }
+      size_t match_length = MIN_MATCH;
+      while (ip + match_length < match_limit && in[candidate + match_length] == in[ip + match_length]) {
+        match_length++;
+      }
+      if (!WriteSequence(out, &op, dst_capacity, in + anchor, ip - anchor, ip - candidate, match_length)) {
+        return 0;
+      }
+      ip += match_length;
+      anchor = ip;
+    }
+  }
+
+  if (!WriteSequence(out, &op, dst_capacity, in + anchor, src_size - anchor, 0, 0)) {
+    return 0;
+  }
+  return op;
+}
+
+auto Lz4::Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) -> bool {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  auto *out = reinterpret_cast<uint8_t *>(dst);
+  size_t ip = 0;
+  size_t op = 0;
+  while (ip < src_size) {
+    const uint8_t token = in[ip++];
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !ReadLength(in, &ip, src_size, &literal_length)) {
+      return false;
+    }
+    if (literal_length > src_size - ip || literal_length > dst_size - op) {
+      return false;
+    }
+    memcpy(out + op, in + ip, literal_length);
+    ip += literal_length;
+    op += literal_length;
+    if (ip == src_size) {
+      // The last sequence has no match.
+      break;
+    }
+
+    if (src_size - ip < 2) {
+      return false;
+    }
+    const size_t offset = in[ip] | (static_cast<size_t>(in[ip + 1]) << 8);
+    ip += 2;
+    if (offset == 0 || offset > op) {
+      return false;
+    }
+    size_t match_length = token & 15;
+    if (match_length == 15 && !ReadLength(in, &ip, src_size, &match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (match_length > dst_size - op) {
+      return false;
+    }
+    // Byte by byte: a match may overlap the bytes it produces, e.g. a run with offset 1.
+    for (size_t i = 0; i < match_length; i++, op++) {
+      out[op] = out[op - offset];
+    }
+  }
+  return op == dst_size;
+}
+
+}  // namespace bustub
@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// numa.cpp
+//
+// Identification: src/common/util/numa.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/numa.h"
+
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <string>
+
+namespace bustub {
+
+namespace {
+
+/**
+ * Parse a sysfs node list such as "0" or "0-1,3".
+ * @return the highest node id of the list plus one, or 1 if the list cannot be parsed
+ */
+auto ParseNodeList(const std::string &list) -> int {
+  int highest = -1;
+  size_t pos = 0;
+  while (pos < list.size()) {
+    size_t end = list.find(',', pos);
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+    auto range = list.substr(pos, end - pos);
+    auto dash = range.find('-');
+    try {
+      highest = std::max(highest, std::stoi(dash == std::string::npos ? range : range.substr(dash + 1)));
+    } catch (...) {
+      return 1;
+    }
+    pos = end + 1;
+  }
+  return highest + 1 > 0 ? highest + 1 : 1;
+}
+
+}  // namespace
+
+auto Numa::NumNodes() -> int {
+  static const int num_nodes = []() {
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string list;
+    if (!online || !std::getline(online, list)) {
+      return 1;
+    }
+    return ParseNodeList(list);
+  }();
+  return num_nodes;
+}
+
+auto Numa::CurrentNode() -> int {
+  unsigned int cpu;
+  unsigned int node;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+    return 0;
+  }
+  return static_cast<int>(node);
+}
+
+auto Numa::BindMemory(void *addr, size_t length, int node) -> bool {
+  constexpr int mask_bits = sizeof(unsigned long) * CHAR_BIT;  // NOLINT
+  if (NumNodes() < 2 || node < 0 || node >= NumNodes() || node >= mask_bits) {
+    return false;
+  }
+  unsigned long node_mask = 1UL << node;  // NOLINT
+  // The kernel reads one bit less than maxnode.
+  return syscall(SYS_mbind, addr, length, MPOL_PREFERRED, &node_mask, mask_bits + 1, 0) == 0;
+}
+
+}  // namespace bustub
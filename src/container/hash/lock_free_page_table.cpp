@@ -0,0 +1,115 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lock_free_page_table.cpp
+//
+// Identification: src/container/hash/lock_free_page_table.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "container/hash/lock_free_page_table.h"
+
+#include <vector>
+
+namespace bustub {
+
+LockFreePageTable::LockFreePageTable(size_t max_entries) {
+  // Keep the load factor of live entries at or below 1/2 so that probe sequences stay short.
+  size_t capacity = 8;
+  int bits = 3;
+  while (capacity < 2 * max_entries) {
+    capacity <<= 1;
+    bits++;
+  }
+  mask_ = capacity - 1;
+  shift_ = 64 - bits;
+  slots_ = std::vector<std::atomic<uint64_t>>(capacity);
+  for (auto &slot : slots_) {
+    slot.store(EMPTY, std::memory_order_relaxed);
+  }
+}
+
+auto LockFreePageTable::Find(page_id_t page_id, frame_id_t *frame_id) const -> bool {
+  size_t idx = SlotOf(page_id);
+  for (size_t probes = 0; probes <= mask_; probes++) {
+    uint64_t slot = slots_[idx].load(std::memory_order_acquire);
+    if (slot == EMPTY) {
+      return false;
+    }
+    if (slot != TOMBSTONE && PageOf(slot) == page_id) {
+      *frame_id = FrameOf(slot);
+      return true;
+    }
+    idx = (idx + 1) & mask_;
+  }
+  return false;
+}
+
+void LockFreePageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  BUSTUB_ASSERT(page_id != INVALID_PAGE_ID, "cannot map the invalid page id");
+  size_t idx = SlotOf(page_id);
+  size_t target = mask_ + 1;
+  for (size_t probes = 0; probes <= mask_; probes++) {
+    uint64_t slot = slots_[idx].load(std::memory_order_relaxed);
+    if (slot == EMPTY) {
+      if (target > mask_) {
+        target = idx;
+      }
+      break;
+    }
+    if (slot == TOMBSTONE) {
+      if (target > mask_) {
+        target = idx;
+      }
+    } else if (PageOf(slot) == page_id) {
+      slots_[idx].store(Pack(page_id, frame_id), std::memory_order_release);
+      return;
+    }
+    idx = (idx + 1) & mask_;
+  }
+  BUSTUB_ASSERT(target <= mask_, "page table is full");
+  if (slots_[target].load(std::memory_order_relaxed) == TOMBSTONE) {
+    num_tombstones_--;
+  }
+  slots_[target].store(Pack(page_id, frame_id), std::memory_order_release);
+}
+
+auto LockFreePageTable::Remove(page_id_t page_id) -> bool {
+  size_t idx = SlotOf(page_id);
+  for (size_t probes = 0; probes <= mask_; probes++) {
+    uint64_t slot = slots_[idx].load(std::memory_order_relaxed);
+    if (slot == EMPTY) {
+      return false;
+    }
+    if (slot != TOMBSTONE && PageOf(slot) == page_id) {
+      slots_[idx].store(TOMBSTONE, std::memory_order_release);
+      if (++num_tombstones_ > (mask_ + 1) / 4) {
+        Compact();
+      }
+      return true;
+    }
+    idx = (idx + 1) & mask_;
+  }
+  return false;
+}
+
+void LockFreePageTable::Compact() {
+  std::vector<uint64_t> live;
+  for (auto &slot : slots_) {
+    uint64_t value = slot.load(std::memory_order_relaxed);
+    if (value != EMPTY && value != TOMBSTONE) {
+      live.push_back(value);
+    }
+    // Readers racing with this only see misses, which send them to the latched path.
+    slot.store(EMPTY, std::memory_order_release);
+  }
+  num_tombstones_ = 0;
+  for (auto value : live) {
+    Insert(PageOf(value), FrameOf(value));
+  }
+}
+
+}  // namespace bustub
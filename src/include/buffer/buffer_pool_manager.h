@@ -16,10 +16,13 @@
 #include <mutex>  // NOLINT
 #include <unordered_map>
 
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "common/io_stats.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -40,7 +43,15 @@ class BufferPoolManager {
   /** Grading function. Do not modify! */
   auto FetchPage(page_id_t page_id, bufferpool_callback_fn callback = nullptr) -> Page * {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
-    auto *result = FetchPgImp(page_id);
+    auto *result = FetchPgImp(page_id, AccessType::Unknown);
+    GradingCallback(callback, CallbackType::AFTER, page_id);
+    return result;
+  }
+
+  /** Fetch a page, telling the buffer pool why it is being accessed. */
+  auto FetchPage(page_id_t page_id, AccessType access_type, bufferpool_callback_fn callback = nullptr) -> Page * {
+    GradingCallback(callback, CallbackType::BEFORE, page_id);
+    auto *result = FetchPgImp(page_id, access_type);
     GradingCallback(callback, CallbackType::AFTER, page_id);
     return result;
   }
@@ -64,7 +75,15 @@ class BufferPoolManager {
   /** Grading function. Do not modify! */
   auto NewPage(page_id_t *page_id, bufferpool_callback_fn callback = nullptr) -> Page * {
     GradingCallback(callback, CallbackType::BEFORE, INVALID_PAGE_ID);
-    auto *result = NewPgImp(page_id);
+    auto *result = NewPgImp(page_id, AccessType::Unknown);
+    GradingCallback(callback, CallbackType::AFTER, *page_id);
+    return result;
+  }
+
+  /** Create a new page, telling the buffer pool why it is being accessed. */
+  auto NewPage(page_id_t *page_id, AccessType access_type, bufferpool_callback_fn callback = nullptr) -> Page * {
+    GradingCallback(callback, CallbackType::BEFORE, INVALID_PAGE_ID);
+    auto *result = NewPgImp(page_id, access_type);
     GradingCallback(callback, CallbackType::AFTER, *page_id);
     return result;
   }
@@ -84,9 +103,86 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetch a page and pin it for as long as the returned guard holds it.
+   * @return a guard holding the page, or an invalid guard if the page could not be fetched
+   */
+  auto FetchPageBasic(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> BasicPageGuard {
+    return {this, FetchPgImp(page_id, access_type)};
+  }
+
+  /**
+   * Fetch a page, pin it and take its read latch for as long as the returned guard holds it.
+   * @return a guard holding the page, or an invalid guard if the page could not be fetched
+   */
+  auto FetchPageRead(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> ReadPageGuard {
+    auto *page = FetchPgImp(page_id, access_type);
+    if (page != nullptr) {
+      page->RLatch();
+    }
+    return {this, page};
+  }
+
+  /**
+   * Fetch a page, pin it and take its write latch for as long as the returned guard holds it.
+   * @return a guard holding the page, or an invalid guard if the page could not be fetched
+   */
+  auto FetchPageWrite(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> WritePageGuard {
+    auto *page = FetchPgImp(page_id, access_type);
+    if (page != nullptr) {
+      page->WLatch();
+    }
+    return {this, page};
+  }
+
+  /**
+   * Create a new page, pinned for as long as the returned guard holds it.
+   * @param[out] page_id id of the new page
+   * @return a guard holding the page, or an invalid guard if no new page could be created
+   */
+  auto NewPageGuarded(page_id_t *page_id, AccessType access_type = AccessType::Unknown) -> BasicPageGuard {
+    return {this, NewPgImp(page_id, access_type)};
+  }
+
+  /**
+   * Reserve an extent: num_pages consecutive page ids for one table or index, which creates its pages with
+   * NewPageAt(), so that the pages of the object are contiguous on disk and a scan of it reads sequentially.
+   * @param num_pages number of pages of the extent
+   * @return the id of the first page of the extent, or INVALID_PAGE_ID if the buffer pool does not support extents
+   */
+  auto AllocateExtent(size_t num_pages) -> page_id_t { return AllocateExtentImp(num_pages); }
+
+  /**
+   * Create a new page with an id reserved by AllocateExtent().
+   * @param page_id id of the page, reserved by AllocateExtent() and not created yet
+   * @param access_type why the page is being accessed
+   * @return nullptr if no new page could be created, otherwise pointer to the new page
+   */
+  auto NewPageAt(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> Page * {
+    return NewPgAtImp(page_id, access_type);
+  }
+
+  /**
+   * Start reading pages [page_id, page_id + num_pages) into the buffer pool without waiting for them. This is only a
+   * hint: pages that are resident or were never allocated are skipped, and so is the rest of the range once no frame
+   * can be spared. Fetching a page that is still being read waits for the read to finish.
+   * @param page_id id of the first page to read ahead
+   * @param num_pages number of pages to read ahead
+   * @param access_type why the pages are going to be accessed
+   */
+  void Prefetch(page_id_t page_id, size_t num_pages, AccessType access_type = AccessType::Unknown) {
+    PrefetchPgImp(page_id, num_pages, access_type);
+  }
+
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
+  /**
+   * @return the hits, misses, evictions and latch wait of the buffer pool so far; bytes read and written are counted
+   * by the DiskManager. The default implementation counts nothing.
+   */
+  virtual auto GetStats() -> IoStats { return {}; }
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -104,9 +200,10 @@ class BufferPoolManager {
   /**
    * Fetch the requested page from the buffer pool.
    * @param page_id id of page to be fetched
+   * @param access_type why the page is being accessed
    * @return the requested page
    */
-  virtual auto FetchPgImp(page_id_t page_id) -> Page * = 0;
+  virtual auto FetchPgImp(page_id_t page_id, AccessType access_type) -> Page * = 0;
 
   /**
    * Unpin the target page from the buffer pool.
@@ -126,9 +223,10 @@ class BufferPoolManager {
   /**
    * Creates a new page in the buffer pool.
    * @param[out] page_id id of created page
+   * @param access_type why the page is being accessed
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  virtual auto NewPgImp(page_id_t *page_id) -> Page * = 0;
+  virtual auto NewPgImp(page_id_t *page_id, AccessType access_type) -> Page * = 0;
 
   /**
    * Deletes a page from the buffer pool.
@@ -141,5 +239,28 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+  /**
+   * Start asynchronous reads of a range of pages. The default implementation does nothing.
+   * @param page_id id of the first page to read ahead
+   * @param num_pages number of pages to read ahead
+   * @param access_type why the pages are going to be accessed
+   */
+  virtual void PrefetchPgImp(page_id_t page_id, size_t num_pages, AccessType access_type) {}
+
+  /**
+   * Reserve num_pages consecutive page ids. The default implementation does not support extents.
+   * @param num_pages number of pages of the extent
+   * @return the id of the first page of the extent, or INVALID_PAGE_ID
+   */
+  virtual auto AllocateExtentImp(size_t num_pages) -> page_id_t { return INVALID_PAGE_ID; }
+
+  /**
+   * Create a new page with a reserved id. The default implementation does not support extents.
+   * @param page_id id of the page
+   * @param access_type why the page is being accessed
+   * @return nullptr if no new page could be created, otherwise pointer to the new page
+   */
+  virtual auto NewPgAtImp(page_id_t page_id, AccessType access_type) -> Page * { return nullptr; }
 };
 }  // namespace bustub
@@ -12,14 +12,21 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
 #include <list>
+#include <map>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/frame_arena.h"
 #include "buffer/lru_k_replacer.h"
 #include "common/config.h"
-#include "container/hash/extendible_hash_table.h"
+#include "container/hash/lock_free_page_table.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -41,6 +48,20 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
                             LogManager *log_manager = nullptr);
 
+  /**
+   * @brief Creates a new BufferPoolManagerInstance that is one shard of a ParallelBufferPoolManager.
+   * @param pool_size the size of the buffer pool
+   * @param num_instances total number of BPIs in the parallel BPM
+   * @param instance_index index of this BPI in the parallel BPM
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer
+   * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param numa_node the NUMA node to place the frames on, or -1 to leave them where they are first touched
+   */
+  BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                            DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
+                            LogManager *log_manager = nullptr, int numa_node = -1);
+
   /**
    * @brief Destroy an existing BufferPoolManagerInstance.
    */
@@ -52,6 +73,72 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @brief Return the pointer to all the pages in the buffer pool. */
   auto GetPages() -> Page * { return pages_; }
 
+  /** @brief Return the NUMA node the frames were placed on, or -1 if they were not placed. */
+  auto GetNumaNode() const -> int { return arena_->GetNumaNode(); }
+
+  /** @brief Return the counters of this instance. */
+  auto GetStats() -> IoStats override { return stats_.Snapshot(); }
+
+  /**
+   * @brief Start a background thread that writes back dirty pages before they are evicted.
+   *
+   * Every background_flush_interval, or sooner when a miss had to write back a dirty victim itself, the thread flushes
+   * the dirty pages among the next clean_fraction * (number of evictable frames) victims of the replacer. Together with
+   * AcquireFrame() preferring clean victims, this keeps the common miss down to a single read.
+   *
+   * The thread writes a page while holding a pin and the page's read latch, never latch_.
+   *
+   * @param clean_fraction fraction of the evictable frames, in replacer order, to keep clean
+   */
+  void StartBackgroundFlusher(double clean_fraction = 0.25);
+
+  /** @brief Stop the background flusher if it is running, and wait for it to exit. */
+  void StopBackgroundFlusher();
+
+  /**
+   * @brief Put a CompressedPageCache between this instance and the disk. Clean pages evicted from the pool are kept
+   * there compressed, except pages only ever read by sequential scans, and a miss looks for the page there before
+   * reading it from disk. Must be called before the pool is used.
+   * @param budget_bytes how many compressed bytes the tier may hold
+   */
+  void EnableCompressedCache(size_t budget_bytes);
+
+  /** @brief Return the counters of the compressed page cache; all zero if it is not enabled. */
+  auto GetCompressedCacheStats() -> CompressedPageCache::Stats;
+
+  /**
+   * @brief Pin every dirty page in the pool and append it to pages, as the snapshot of a checkpoint. The caller writes
+   * the pages back with WriteBackPages() and then unpins them.
+   * @param[out] pages the dirty pages, each pinned once
+   */
+  void CollectDirtyPages(std::vector<Page *> *pages);
+
+  /**
+   * @brief Write back a set of pinned pages in page id order and mark them clean.
+   *
+   * Each page is copied out under its read latch into a staging buffer, so page latches are never held during I/O or
+   * more than one at a time, and every run of consecutive page ids is written with one DiskManager::WritePages() call.
+   * The pages may come from several instances sharing disk_manager. Does not sync. If a run cannot be written, every
+   * page of it is marked dirty again.
+   *
+   * @param disk_manager the disk manager the pages belong to
+   * @param[in,out] pages the pages to write; sorted by page id on return
+   * @return false if some run could not be written
+   */
+  static auto WriteBackPages(DiskManager *disk_manager, std::vector<Page *> *pages) -> bool;
+
+  /**
+   * @brief Reserve the page ids of this instance in [first, end) for an extent of a parallel buffer pool. The counter
+   * moves past end, and the ids it skips before first go to the free-space map, to be handed out by AllocatePage().
+   * @param first id of the first page of the extent
+   * @param end id past the last page of the extent
+   * @return false, reserving nothing, if the counter has already passed first
+   */
+  auto ReservePageIds(page_id_t first, page_id_t end) -> bool;
+
+  /** @brief Return the id the counter of AllocatePage() hands out next. */
+  auto GetNextPageId() const -> page_id_t { return next_page_id_.load(); }
+
  protected:
   /**
    * TODO(P1): Add implementation
@@ -67,10 +154,13 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * so that the replacer wouldn't evict the frame before the buffer pool manager "Unpin"s it.
    * Also, remember to record the access history of the frame in the replacer for the lru-k algorithm to work.
    *
+   * A Scan access takes its frame from the scan ring (see AcquireScanFrame()) rather than from the replacer.
+   *
    * @param[out] page_id id of created page
+   * @param access_type why the page is being accessed
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
-  auto NewPgImp(page_id_t *page_id) -> Page * override;
+  auto NewPgImp(page_id_t *page_id, AccessType access_type) -> Page * override;
 
   /**
    * TODO(P1): Add implementation
@@ -85,10 +175,14 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    *
    * In addition, remember to disable eviction and record the access history of the frame like you did for NewPgImp().
    *
+   * A Scan access that misses reads the page into a frame from the scan ring (see AcquireScanFrame()) rather than
+   * evicting from the replacer.
+   *
    * @param page_id id of page to be fetched
+   * @param access_type why the page is being accessed
    * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
    */
-  auto FetchPgImp(page_id_t page_id) -> Page * override;
+  auto FetchPgImp(page_id_t page_id, AccessType access_type) -> Page * override;
 
   /**
    * TODO(P1): Add implementation
@@ -113,71 +207,250 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * Use the DiskManager::WritePage() method to flush a page to disk, REGARDLESS of the dirty flag.
    * Unset the dirty flag of the page after flushing.
    *
+   * If the disk manager cannot write the page, it stays dirty.
+   *
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
-   * @return false if the page could not be found in the page table, true otherwise
+   * @return false if the page could not be found in the page table or could not be written, true otherwise
    */
   auto FlushPgImp(page_id_t page_id) -> bool override;
 
   /**
-   * TODO(P1): Add implementation
+   * @brief Flush all the dirty pages in the buffer pool to disk, then sync the disk once.
    *
-   * @brief Flush all the pages in the buffer pool to disk.
+   * The dirty set is snapshotted (and pinned) under latch_, and written back by WriteBackPages() without holding it.
    */
   void FlushAllPgsImp() override;
 
   /**
    * TODO(P1): Add implementation
    *
-   * @brief Delete a page from the buffer pool. If page_id is not in the buffer pool, do nothing and return true. If the
-   * page is pinned and cannot be deleted, return false immediately.
+   * @brief Delete a page from the buffer pool. If page_id is not in the buffer pool, only free it on disk and return true.
+   * If the page is pinned and cannot be deleted, return false immediately. Also return false for a page id that is not
+   * allocated, because it was never handed out or is free already: freeing it would let it be handed out twice.
    *
    * After deleting the page from the page table, stop tracking the frame in the replacer and add the frame
    * back to the free list. Also, reset the page's memory and metadata. Finally, you should call DeallocatePage() to
    * imitate freeing the page on the disk.
    *
    * @param page_id id of page to be deleted
-   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   * @return false if the page is pinned or not allocated, true if the page was deleted
    */
   auto DeletePgImp(page_id_t page_id) -> bool override;
 
+  /**
+   * @brief Start asynchronous reads of the pages of the range that belong to this instance.
+   *
+   * Each page gets a frame the same way FetchPgImp() would, and is entered in the page table right away, but its frame
+   * keeps pin count -1 until DiskManager::ReadPageAsync() completes. Until then lock-free hits miss, and the latched
+   * path of FetchPgImp() waits for the read. Scans read ahead through the scan ring, and at most half of it.
+   * Pages that do not exist on disk are skipped: ids that were never handed out, free pages, and pages of an extent
+   * that NewPgAtImp() has not created yet.
+   *
+   * @param page_id id of the first page to read ahead
+   * @param num_pages number of pages to read ahead
+   * @param access_type why the pages are going to be accessed
+   */
+  void PrefetchPgImp(page_id_t page_id, size_t num_pages, AccessType access_type) override;
+
+  /**
+   * @brief Reserve num_pages consecutive page ids. Only a buffer pool instance on its own can do this; the instances
+   * of a parallel buffer pool each own every num_instances-th id, so ParallelBufferPoolManager reserves extents.
+   * @param num_pages number of pages of the extent
+   * @return the id of the first page of the extent, or INVALID_PAGE_ID if the instance is part of a parallel pool
+   */
+  auto AllocateExtentImp(size_t num_pages) -> page_id_t override;
+
+  /**
+   * @brief Create a new page with an id reserved by AllocateExtent(), like NewPgImp() does with a new id. A frame that
+   * already holds the id, e.g. one a fetch read before the page was created, is taken over.
+   * @param page_id id of the page
+   * @param access_type why the page is being accessed
+   * @return nullptr if all frames are pinned or the id is resident and pinned, otherwise pointer to the new page
+   */
+  auto NewPgAtImp(page_id_t page_id, AccessType access_type) -> Page * override;
+
   /** Number of pages in the buffer pool. */
   const size_t pool_size_;
-  /** The next page id to be allocated  */
-  std::atomic<page_id_t> next_page_id_ = 0;
+  /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
+  const uint32_t num_instances_ = 1;
+  /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
+  const uint32_t instance_index_ = 0;
+  /** Each BPI maintains its own counter for page_ids to hand out, must ensure they mod back to its instance_index_ */
+  std::atomic<page_id_t> next_page_id_;
   /** Bucket size for the extendible hash table */
   const size_t bucket_size_ = 4;
 
   /** Array of buffer pool pages. */
   Page *pages_;
+  /** The data of the pages. */
+  FrameArena *arena_;
+  /** The second cache tier, or nullptr if it is not enabled. */
+  CompressedPageCache *compressed_cache_{nullptr};
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
 
   /** Pointer to the log manager. Please ignore this for P1. */
   LogManager *log_manager_ __attribute__((__unused__));
 
-  /** Page table for keeping track of buffer pool pages. */
-  ExtendibleHashTable<page_id_t, frame_id_t> *page_table_;
+  /** Maximum number of pages WriteBackPages() stages and writes at once. */
+  static constexpr size_t FLUSH_BATCH_PAGES = 256;
+  /** How many victims AcquireFrame() looks at to find a clean one. */
+  static constexpr size_t EVICTION_LOOKAHEAD = 8;
+
+  /** Page table for keeping track of buffer pool pages. Read lock-free, written only while holding latch_. */
+  LockFreePageTable *page_table_;
   /** Replacer to find unpinned pages for replacement. */
   LRUKReplacer *replacer_;
   /** List of free frames that don't have any pages on them. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /** Background flusher thread, or nullptr if it is not running. */
+  std::thread *flush_thread_{nullptr};
+  std::atomic<bool> enable_background_flush_{false};
+  /** Set by the miss path after it wrote back a dirty victim, to wake the flusher early. */
+  std::atomic<bool> flush_requested_{false};
+  /** Hits, misses, evictions and latch waits of this instance. */
+  IoCounters stats_;
+  /** Fraction of the evictable frames the flusher keeps clean. */
+  double clean_fraction_{0};
+  /** The flusher's buffer for the victims it cleans, one slot per frame. */
+  std::vector<frame_id_t> flush_victims_;
+  std::mutex flush_latch_;
+  std::condition_variable flush_cv_;
+  /** Number of prefetch reads that have not completed yet. Protected by io_latch_. */
+  size_t reads_in_flight_{0};
+  /** Signalled whenever a prefetch read completes. */
+  std::mutex io_latch_;
+  std::condition_variable io_cv_;
+  /**
+   * Ids of extents reserved by this instance that NewPgAtImp() has not created yet, as ranges [first, end) keyed by
+   * first. Extents are filled in id order, so each range shrinks from the front. Protected by latch_.
+   */
+  std::map<page_id_t, page_id_t> uncreated_pages_;
+  /** Frames recently loaded by scans, reused round-robin once full. Protected by latch_. */
+  std::vector<frame_id_t> scan_ring_;
+  /** Maximum size of scan_ring_. */
+  const size_t scan_ring_capacity_;
+  /** Next slot of a full scan_ring_ to recycle. Protected by latch_. */
+  size_t scan_ring_next_{0};
+  /**
+   * Per frame: true while the frame holds a page that only scans have touched. Set when a scan loads the page and
+   * cleared by any other access, which takes the page out of the ring's reach.
+   */
+  std::vector<std::atomic<bool>> scan_only_;
+  /** Per frame: true while the frame holds a page a prefetch read and nobody has fetched since. */
+  std::vector<std::atomic<bool>> prefetched_;
+  /**
+   * This latch serializes the miss path: it protects free_list_, writes to page_table_, and every transition of a
+   * frame from one page to another. Hits (FetchPgImp on a resident page) and UnpinPgImp do not take it; they pin and
+   * unpin frames with atomics on Page::pin_count_ and validate the frame's page id afterwards.
+   *
+   * Because pins do not go through the latch, the replacer is not told when a frame becomes pinned. Every resident
+   * frame stays evictable in the replacer, and a victim is only taken after AcquireFrame() claims it by moving its pin
+   * count from 0 to -1. Frames that turn out to be pinned are put back.
+   * The replacer records the accesses of hits without its own latch either, so a hit takes no mutex at all.
+   *
+   * A claimed frame is released before the latch is, except for prefetches: their frames stay at -1 until the I/O
+   * thread finishes the read.
+   */
   std::mutex latch_;
 
+  /** @brief Lock latch_, counting the time spent waiting for it if it is taken. */
+  auto LockLatch() -> std::unique_lock<std::mutex>;
+
   /**
    * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
-   * @return the id of the allocated page
+   *
+   * Pages freed by DeallocatePage() are handed out again, lowest id first, before new pages are allocated at the end
+   * of the file.
+   *
+   * @param[out] reused true if the page was freed before, so that the disk still holds the data of the deleted page
+   * @return the id of the allocated page, or INVALID_PAGE_ID if the page ids of this instance are used up
    */
-  auto AllocatePage() -> page_id_t;
+  auto AllocatePage(bool *reused) -> page_id_t;
 
   /**
-   * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
+   * validate input data and ensure that a parallel BPM is routing requests to the correct BPI
+   * @param page_id the page id to validate
+   */
+  void ValidatePageId(page_id_t page_id) const;
+
+  /** @brief Return the smallest page id of this instance that is at least page_id. */
+  auto FirstPageIdFrom(page_id_t page_id) const -> page_id_t;
+
+  /**
+   * @brief Set up a claimed frame for a new page. Caller must hold the latch.
+   * @param frame_id the frame, claimed by AcquireFrame() or AcquireScanFrame()
+   * @param page_id id of the new page
+   * @param is_dirty true if the page must be written back even if nobody modifies it
+   * @param access_type why the page is being accessed
+   * @return the new page, pinned once
+   */
+  auto InitNewPage(frame_id_t frame_id, page_id_t page_id, bool is_dirty, AccessType access_type) -> Page *;
+
+  /** @brief Return true if page_id belongs to an extent and has not been created yet. Caller must hold the latch. */
+  auto IsUncreated(page_id_t page_id) const -> bool;
+
+  /**
+   * @brief Deallocate a page on disk, by adding it to the free-space map of the disk manager. Caller should acquire
+   * the latch before calling this function.
    * @param page_id id of the page to deallocate
+   * @return false if the page is free already
+   */
+  auto DeallocatePage(page_id_t page_id) -> bool;
+
+  /**
+   * @brief Pin page_id if it is resident, without taking latch_.
+   * @param page_id id of the page to pin
+   * @param access_type why the page is being accessed
+   * @return the pinned page, or nullptr if the page is not (observably) resident and the caller has to take the slow
+   * path
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  auto TryPinResident(page_id_t page_id, AccessType access_type) -> Page *;
 
-  // TODO(student): You may add additional private members and helper functions
+  /**
+   * @brief Take exclusive ownership of a frame, from the free list first and from the replacer otherwise. If the frame
+   * held a page, it is written back when dirty and removed from the page table. Caller must hold latch_.
+   *
+   * On success the frame's pin count is -1; the caller installs the new page and then publishes it by storing the
+   * final pin count.
+   *
+   * Among the first EVICTION_LOOKAHEAD victims of the replacer, a clean one is taken over a dirty one, so that the miss
+   * does not have to write back a page while holding latch_. Otherwise the first victim that is not pinned is taken;
+   * pinned victims stay in the replacer as they were.
+   *
+   * @param[out] frame_id the acquired frame
+   * @return false if every frame is pinned, or the victim is dirty and could not be written back
+   */
+  auto AcquireFrame(frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Take exclusive ownership of a frame for a page a scan is about to load. Caller must hold latch_.
+   *
+   * Scans recycle a bounded ring of frames, like a Postgres buffer access strategy: until the ring is full, frames come
+   * from AcquireFrame() and join the ring; afterwards, the oldest ring frame is reused if it is unpinned and nobody but
+   * a scan has touched its page since. Otherwise that slot is refilled through AcquireFrame(). A large scan therefore
+   * only ever displaces scan_ring_capacity_ pages of the working set. The ring is shared by all scans on this instance.
+   *
+   * @param[out] frame_id the acquired frame, in the same state as after AcquireFrame()
+   * @return false if every frame is pinned
+   */
+  auto AcquireScanFrame(frame_id_t *frame_id) -> bool;
+
+  /** Main loop of the background flusher. */
+  void RunBackgroundFlusher();
+
+  /**
+   * @brief Write back the page in frame_id if it is dirty and unpinned, without taking latch_. Used by the flusher.
+   * @param frame_id frame to clean
+   * @return true if the page was written
+   */
+  auto FlushFrameInBackground(frame_id_t frame_id) -> bool;
+
+  /**
+   * Record an access to a frame, and take it out of the scan ring's reach if it is not a scan access. The first access
+   * to a prefetched page counts as a prefetch hit.
+   */
+  void RecordAccess(frame_id_t frame_id, AccessType access_type);
 };
 }  // namespace bustub
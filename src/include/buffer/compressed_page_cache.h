@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.h
+//
+// Identification: src/include/buffer/compressed_page_cache.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * CompressedPageCache is a second cache tier between a buffer pool and its disk: it keeps clean pages evicted from the
+ * pool, LZ4-compressed, so that a working set somewhat larger than the pool is served from memory rather than from
+ * disk. Pages typically compress well (free space in the middle of a table page, padding in index pages), so the same
+ * memory holds more pages here than in the pool.
+ *
+ * The tier is exclusive of the pool: Get() hands a page back to the pool and drops it from the tier, so a page is
+ * never in both and the tier never holds a stale copy of a page that was modified in the pool. Pages are evicted in
+ * LRU order once the compressed pages exceed the budget. Pages that do not compress to at most 7/8 of their size are
+ * not worth the space and are rejected.
+ */
+class CompressedPageCache {
+ public:
+  /** Counters of the tier; insertions, rejections and evictions only count Put(). */
+  struct Stats {
+    /** Get() calls that found the page. */
+    uint64_t hits_{0};
+    /** Get() calls that did not. */
+    uint64_t misses_{0};
+    /** Pages stored. */
+    uint64_t insertions_{0};
+    /** Pages that did not compress well enough to be stored. */
+    uint64_t rejections_{0};
+    /** Pages dropped to stay within the budget. */
+    uint64_t evictions_{0};
+    /** Compressed bytes currently stored. */
+    uint64_t used_bytes_{0};
+    /** Pages currently stored. */
+    uint64_t num_pages_{0};
+
+    auto operator+=(const Stats &other) -> Stats &;
+  };
+
+  /** @param budget_bytes how many compressed bytes the tier may hold */
+  explicit CompressedPageCache(size_t budget_bytes) : budget_bytes_(budget_bytes) {}
+
+  DISALLOW_COPY_AND_MOVE(CompressedPageCache);
+
+  /**
+   * Compress and store a clean page that is leaving the buffer pool, replacing any copy of it. The page is compressed
+   * before the tier is latched.
+   * @param page_id id of the page
+   * @param data the page, BUSTUB_PAGE_SIZE bytes, which must match the page on disk
+   */
+  void Put(page_id_t page_id, const char *data);
+
+  /**
+   * Take a page out of the tier.
+   * @param page_id id of the page
+   * @param[out] data where to decompress the page, BUSTUB_PAGE_SIZE bytes
+   * @return true if the page was in the tier; it no longer is
+   */
+  auto Get(page_id_t page_id, char *data) -> bool;
+
+  /** @return true if the page is in the tier */
+  auto Contains(page_id_t page_id) -> bool;
+
+  /** Drop a page from the tier, e.g. because it was deleted. Does nothing if the page is not in the tier. */
+  void Erase(page_id_t page_id);
+
+  /** @return the budget in compressed bytes */
+  auto GetBudget() const -> size_t { return budget_bytes_; }
+
+  auto GetStats() -> Stats;
+
+ private:
+  struct Entry {
+    page_id_t page_id_;
+    std::vector<char> data_;
+  };
+
+  /** Remove an entry; the latch must be held. @return the compressed page the entry held */
+  auto EraseEntry(std::list<Entry>::iterator entry) -> std::vector<char>;
+
+  const size_t budget_bytes_;
+  std::mutex latch_;
+  /** Most recently stored first. */
+  std::list<Entry> lru_;
+  std::unordered_map<page_id_t, std::list<Entry>::iterator> entries_;
+  size_t used_bytes_{0};
+  Stats stats_;
+};
+
+}  // namespace bustub
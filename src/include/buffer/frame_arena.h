@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrameArena holds the data of the frames of a buffer pool: one contiguous mapping of page-sized frames, apart from
+ * the Page metadata, so that frame data is densely packed and every frame is aligned for O_DIRECT.
+ *
+ * An arena of at least HUGE_PAGE_SIZE is backed by huge pages, so that a large pool needs few TLB entries: reserved
+ * ones (MAP_HUGETLB) if the system has enough of them, transparent ones (madvise(MADV_HUGEPAGE)) otherwise. Smaller
+ * arenas use ordinary pages. Frames start out zeroed.
+ *
+ * An arena can be placed on a NUMA node, so that the frames of a buffer pool shard are local to the threads that use
+ * it rather than to whichever thread happened to touch them first.
+ */
+class FrameArena {
+ public:
+  /** How the arena is backed. */
+  enum class HugePages { NONE, TRANSPARENT, RESERVED };
+
+  /**
+   * @param num_frames number of frames
+   * @param numa_node the NUMA node to place the frames on, or -1 to leave them to the first thread that touches them
+   * @throws Exception of type OUT_OF_MEMORY if the arena cannot be mapped
+   */
+  explicit FrameArena(size_t num_frames, int numa_node = -1);
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the data of a frame, BUSTUB_PAGE_SIZE bytes */
+  inline auto GetFrame(frame_id_t frame_id) -> char * {
+    return data_ + static_cast<size_t>(frame_id) * BUSTUB_PAGE_SIZE;
+  }
+
+  /** @return the number of bytes mapped, rounded up to whole huge pages if huge pages are used */
+  inline auto GetMappedSize() const -> size_t { return mapped_size_; }
+
+  /** @return how the arena is backed */
+  inline auto GetHugePages() const -> HugePages { return huge_pages_; }
+
+  /** @return the NUMA node the frames were placed on, or -1 if they were not placed (e.g. on a single-node host) */
+  inline auto GetNumaNode() const -> int { return numa_node_; }
+
+ private:
+  char *data_{nullptr};
+  size_t mapped_size_{0};
+  HugePages huge_pages_{HugePages::NONE};
+  int numa_node_{-1};
+};
+
+}  // namespace bustub
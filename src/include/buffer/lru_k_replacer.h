@@ -12,13 +12,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstddef>
+#include <functional>
 #include <limits>
-#include <list>
-#include <map>
 #include <mutex>  // NOLINT
-#include <set>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -27,6 +25,15 @@
 
 namespace bustub {
 
+/**
+ * Why a page is being accessed, as passed down from the caller of the buffer pool.
+ *
+ * Scan marks a one-off sequential pass over a table. The replacer does not let repeated scan accesses promote a frame,
+ * and the buffer pool recycles scan frames through a small ring instead of evicting the working set for them. Lookup
+ * and Index are currently treated like Unknown.
+ */
+enum class AccessType { Unknown = 0, Lookup, Scan, Index };
+
 /**
  * LRUKReplacer implements the LRU-k replacement policy.
  *
@@ -37,6 +44,21 @@ namespace bustub {
  * A frame with less than k historical references is given
  * +inf as its backward k-distance. When multiple frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
+ *
+ * Each frame keeps its last k access timestamps in a fixed-size ring buffer inside one flat array of atomics.
+ * RecordAccess only writes that ring: it never allocates and takes no latch, so buffer pool hits do not serialize on
+ * the replacer. Evictable frames sit in an indexed binary min-heap ordered by (has k accesses, oldest retained
+ * timestamp) as of when each frame was placed. An access can only raise a frame's key, so the heap keys are lower
+ * bounds: Evict and PeekVictims repair them lazily, re-sifting a frame whose key moved once it comes to the top.
+ * SetEvictable(false) likewise leaves the frame in the heap for Evict to drop.
+ *
+ * RecordAccess and SetEvictable are O(1), except that making a frame that left the heap evictable again sifts it up
+ * from the bottom, where a frame that was just accessed stays. Evict is O(log n) amortized, not worst case: a repair
+ * makes the frame's heap key current, so a frame is only repaired again after another access, and the repairs one call
+ * does are at most the accesses since the frames involved were last placed, each O(log n). A single call after a burst
+ * of accesses to evictable frames can repair up to n frames. PeekVictims repairs nothing; it walks the heap from the
+ * top until it has its victims. Neither allocates: their scratch space is sized for every frame up front. An access
+ * that races with an eviction may be ordered approximately.
  */
 class LRUKReplacer {
  public:
@@ -76,6 +98,32 @@ class LRUKReplacer {
    */
   auto Evict(frame_id_t *frame_id) -> bool;
 
+  /**
+   * @brief Like Evict(), but evict only a frame that can_evict accepts, trying frames in eviction order.
+   *
+   * A frame that can_evict turns down is skipped and stays in the replacer with its access history and its place in
+   * the eviction order, so that a frame the buffer pool finds pinned for a moment does not lose its history.
+   * can_evict runs under the replacer's latch and must not call back into the replacer.
+   *
+   * @param[out] frame_id id of frame that is evicted.
+   * @param can_evict decides whether the frame passed to it can be evicted
+   * @return true if a frame is evicted, false if every evictable frame was turned down or there were none
+   */
+  auto Evict(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &can_evict) -> bool;
+
+  /**
+   * @brief Fill victims with up to max_frames evictable frames in the order Evict() would pick them, without evicting
+   * them.
+   *
+   * The background flusher uses this to clean the frames that are about to be evicted, and the buffer pool to look
+   * for a clean victim on a miss, so it does not allocate.
+   *
+   * @param[out] victims the next victims, first victim first; room for max_frames frames
+   * @param max_frames the maximum number of frames to return
+   * @return the number of frames written to victims
+   */
+  auto PeekVictims(frame_id_t *victims, size_t max_frames) -> size_t;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -85,9 +133,15 @@ class LRUKReplacer {
    * If frame id is invalid (ie. larger than replacer_size_), throw an exception. You can
    * also use BUSTUB_ASSERT to abort the process if frame id is invalid.
    *
+   * A Scan access to a frame that is already tracked is not recorded: touching every tuple of a page during a scan
+   * would otherwise give the page k accesses and make it look as hot as the index pages we want to keep.
+   *
+   * Does not take the replacer's latch, and may be called concurrently with any other method.
+   *
    * @param frame_id id of frame that received a new access.
+   * @param access_type why the frame was accessed
    */
-  void RecordAccess(frame_id_t frame_id);
+  void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown);
 
   /**
    * TODO(P1): Add implementation
@@ -137,16 +191,50 @@ class LRUKReplacer {
   auto Size() -> size_t;
 
  private:
-  // TODO(student): implement me! You can replace these member variables as you like.
-  // Remove maybe_unused if you start using them.
-  size_t current_timestamp_{0};
-  [[maybe_unused]] size_t curr_size_{0};
+  static constexpr size_t NOT_IN_HEAP = std::numeric_limits<size_t>::max();
+
+  using EvictionKeyType = std::pair<bool, size_t>;
+
+  /** Bookkeeping for one frame. Its access history lives in history_[frame_id * k_, (frame_id + 1) * k_). */
+  struct FrameEntry {
+    /** Number of accesses recorded since the frame was last reset; access n went to ring slot n % k_. */
+    std::atomic<size_t> num_accesses_{0};
+    // The rest is protected by latch_.
+    /** Position in heap_, or NOT_IN_HEAP. A frame stays in the heap for a while after it stops being evictable. */
+    size_t heap_index_{NOT_IN_HEAP};
+    /** The frame's eviction key when it was last placed in the heap; a lower bound on its current key. */
+    EvictionKeyType heap_key_{};
+    bool evictable_{false};
+  };
+
+  /** @return the frame's sort key: frames with fewer than k accesses first, then by oldest retained timestamp. */
+  auto EvictionKey(frame_id_t frame_id) const -> EvictionKeyType;
+  auto HeapLess(size_t lhs, size_t rhs) const -> bool {
+    return frames_[heap_[lhs]].heap_key_ < frames_[heap_[rhs]].heap_key_;
+  }
+  void HeapSwap(size_t lhs, size_t rhs);
+  void HeapSiftUp(size_t index);
+  void HeapSiftDown(size_t index);
+  void HeapPush(frame_id_t frame_id);
+  void HeapErase(frame_id_t frame_id);
+  /** Drop a frame's access history and stop tracking it. The frame must not be in the heap. */
+  void ResetFrame(frame_id_t frame_id);
+  /** Throw if the frame id is out of range. */
+  void CheckFrameId(frame_id_t frame_id) const;
+
+  std::atomic<size_t> current_timestamp_{0};
+  size_t curr_size_{0};
   size_t replacer_size_;
   size_t k_;
-  std::set<std::pair<frame_id_t, size_t>> cache_id_time_, history_id_time_;
-  std::set<std::pair<size_t, frame_id_t>> cache_time_id_, history_time_id_;
-  std::map<frame_id_t, size_t> history_cnt_;
-  std::set<frame_id_t> cache_is_evictable_, history_is_evictable_;
+  std::vector<FrameEntry> frames_;
+  std::vector<std::atomic<size_t>> history_;
+  /** Frames that are or recently were evictable, a min-heap on their heap_key_. */
+  std::vector<frame_id_t> heap_;
+  /** Frames that Evict took off the heap because can_evict turned them down, to be put back. */
+  std::vector<frame_id_t> skipped_;
+  /** PeekVictims' scratch space: heap positions still to walk, and walked frames by their current key. */
+  std::vector<size_t> peek_frontier_;
+  std::vector<std::pair<EvictionKeyType, frame_id_t>> peek_candidates_;
   std::mutex latch_;
 };
 
@@ -0,0 +1,182 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager spreads pages over several independently latched BufferPoolManagerInstances.
+ *
+ * A page always lives in the instance `page_id % num_instances`, so every operation on an existing page only takes
+ * the latch of one shard. New pages are handed out round-robin across the shards; each shard allocates page ids
+ * congruent to its own index, so the mapping stays stable for the lifetime of the page.
+ *
+ * On a host with several NUMA nodes, the frames of instance i are placed on node i % (number of nodes), and a new
+ * page goes to an instance on the node of the thread that creates it whenever one has room. Since the page keeps its
+ * instance, the thread that loads a table or builds an index reads those pages from local memory afterwards.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * @brief Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of individual BufferPoolManagerInstances to store
+   * @param pool_size the pool size of each BufferPoolManagerInstance
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer of each instance
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            size_t replacer_k = LRUK_REPLACER_K, LogManager *log_manager = nullptr);
+
+  /**
+   * @brief Destroys an existing ParallelBufferPoolManager.
+   */
+  ~ParallelBufferPoolManager() override = default;
+
+  /** @brief Return the total number of frames over all instances. */
+  auto GetPoolSize() -> size_t override { return num_instances_ * pool_size_; }
+
+  /** @brief Return the number of instances the pool is partitioned into. */
+  auto GetNumInstances() const -> size_t { return num_instances_; }
+
+  /** @brief Return the counters of all instances added up. */
+  auto GetStats() -> IoStats override;
+
+  /** @brief Return the NUMA node the frames of one instance were placed on, or -1 if they were not placed. */
+  auto GetInstanceNumaNode(size_t instance_index) const -> int { return instances_[instance_index]->GetNumaNode(); }
+
+  /** @brief Return the counters of one instance, to spot a shard that gets more than its share of the load. */
+  auto GetInstanceStats(size_t instance_index) -> IoStats { return instances_[instance_index]->GetStats(); }
+
+  /** @brief Start the background flusher of every instance. See BufferPoolManagerInstance::StartBackgroundFlusher(). */
+  void StartBackgroundFlusher(double clean_fraction = 0.25);
+
+  /** @brief Stop the background flusher of every instance. */
+  void StopBackgroundFlusher();
+
+  /**
+   * @brief Give every instance a compressed page cache. See BufferPoolManagerInstance::EnableCompressedCache().
+   * @param budget_bytes how many compressed bytes the tiers may hold together, split evenly between the instances
+   */
+  void EnableCompressedCache(size_t budget_bytes);
+
+  /** @brief Return the counters of the compressed page caches of all instances added up. */
+  auto GetCompressedCacheStats() -> CompressedPageCache::Stats;
+
+ protected:
+  /**
+   * @param page_id id of page
+   * @return pointer to the BufferPoolManagerInstance responsible for handling given page id
+   */
+  auto GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance *;
+
+  /**
+   * @brief Fetch the requested page from the responsible BufferPoolManagerInstance.
+   * @param page_id id of page to be fetched
+   * @param access_type why the page is being accessed
+   * @return the requested page
+   */
+  auto FetchPgImp(page_id_t page_id, AccessType access_type) -> Page * override;
+
+  /**
+   * @brief Unpin the target page from the responsible BufferPoolManagerInstance.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
+
+  /**
+   * @brief Flush the target page to disk through the responsible BufferPoolManagerInstance.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  auto FlushPgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Create a new page. Instances are tried round-robin, starting from a rotating index, so that consecutive
+   * allocations land on different shards; on a NUMA host, the instances on the caller's node are tried first. The
+   * call fails only if every instance is full of pinned pages.
+   * @param[out] page_id id of created page
+   * @param access_type why the page is being accessed
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgImp(page_id_t *page_id, AccessType access_type) -> Page * override;
+
+  /**
+   * @brief Delete a page from the responsible BufferPoolManagerInstance.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  auto DeletePgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Flush all the dirty pages of every instance to disk. The dirty sets of all instances are merged before
+   * writing, since consecutive page ids live on different instances, and the disk is synced once at the end.
+   */
+  void FlushAllPgsImp() override;
+
+  /**
+   * @brief Route every page of the range to the instance responsible for it.
+   * @param page_id id of the first page to read ahead
+   * @param num_pages number of pages to read ahead
+   * @param access_type why the pages are going to be accessed
+   */
+  void PrefetchPgImp(page_id_t page_id, size_t num_pages, AccessType access_type) override;
+
+  /**
+   * @brief Reserve num_pages consecutive page ids, which belong to all instances in turn. The extent starts where the
+   * instance furthest ahead would allocate next, and every instance's counter moves past it; the ids the other
+   * instances skip go to the free-space map.
+   * @param num_pages number of pages of the extent
+   * @return the id of the first page of the extent, or INVALID_PAGE_ID if the extent would run past the largest page id
+   */
+  auto AllocateExtentImp(size_t num_pages) -> page_id_t override;
+
+  /**
+   * @brief Create a new page with a reserved id in the instance responsible for it.
+   * @param page_id id of the page
+   * @param access_type why the page is being accessed
+   * @return nullptr if that instance is full of pinned pages, otherwise pointer to the new page
+   */
+  auto NewPgAtImp(page_id_t page_id, AccessType access_type) -> Page * override;
+
+ private:
+  /** Number of BufferPoolManagerInstances. */
+  const size_t num_instances_;
+  /** Number of frames in each BufferPoolManagerInstance. */
+  const size_t pool_size_;
+  /** The disk manager shared by all instances. */
+  DiskManager *disk_manager_;
+  /** Number of NUMA nodes the instances are spread over; 1 if the frames were not placed. */
+  int num_numa_nodes_{1};
+  /** The shards, indexed by page_id % num_instances_. */
+  std::vector<std::unique_ptr<BufferPoolManagerInstance>> instances_;
+  /** The instance NewPgImp starts probing from; advanced on every call. */
+  std::atomic<size_t> start_index_{0};
+  /** Serializes AllocateExtentImp(). */
+  std::mutex extent_latch_;
+};
+
+}  // namespace bustub
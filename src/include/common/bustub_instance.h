@@ -211,7 +211,13 @@ class BustubInstance {
   auto MakeExecutorContext(Transaction *txn) -> std::unique_ptr<ExecutorContext>;
 
  public:
-  explicit BustubInstance(const std::string &db_file_name);
+  /**
+   * Create a BusTub instance backed by a database file.
+   * @param db_file_name the database file
+   * @param read_only serve an existing database file from a read-only memory mapping (DiskManagerMmap), e.g. on an
+   * analytic replica. Writing pages back to the file then throws.
+   */
+  explicit BustubInstance(const std::string &db_file_name, bool read_only = false);
 
   BustubInstance();
 
@@ -14,13 +14,31 @@
 
 #include <atomic>
 #include <chrono>  // NOLINT
+#include <cstddef>
 #include <cstdint>
 
+/**
+ * The page size, set with -DBUSTUB_PAGE_SIZE=<bytes> when configuring the build. A database file can only be opened
+ * with the page size it was created with.
+ */
+#ifndef BUSTUB_CONFIG_PAGE_SIZE
+#define BUSTUB_CONFIG_PAGE_SIZE 4096
+#endif
+
 namespace bustub {
 
 /** Cycle detection is performed every CYCLE_DETECTION_INTERVAL milliseconds. */
 extern std::chrono::milliseconds cycle_detection_interval;
 
+/** The background flusher of the buffer pool wakes up at least every BACKGROUND_FLUSH_INTERVAL milliseconds. */
+extern std::chrono::milliseconds background_flush_interval;
+
+/**
+ * True if pages read from a database file are checked against the CRC32C recorded when they were written. Checksums
+ * are always recorded; turning this off only skips the check on the read path.
+ */
+extern std::atomic<bool> verify_page_checksums;
+
 /** True if logging should be enabled, false otherwise. */
 extern std::atomic<bool> enable_logging;
 
@@ -31,11 +49,24 @@ static constexpr int INVALID_PAGE_ID = -1;
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                             // the header page id
-static constexpr int BUSTUB_PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr int BUSTUB_PAGE_SIZE = BUSTUB_CONFIG_PAGE_SIZE;                     // size of a data page in byte
 static constexpr int BUFFER_POOL_SIZE = 10;                                          // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
 static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int SCAN_RING_SIZE = 32;   // max frames a buffer pool instance lends to sequential scans
+static constexpr int READ_AHEAD_PAGES = 8;  // pages a sequential scan prefetches ahead of itself
+static constexpr int DISK_IO_WORKERS = 4;   // threads serving asynchronous reads in the disk manager
+static constexpr int EXTENT_PAGES = 64;     // pages a table reserves at once, so that its pages are contiguous
+static constexpr int WRITE_COMBINE_PAGES = 64;  // page writes a write-combining disk manager queues per batch
+static constexpr int IO_URING_QUEUE_DEPTH = 128;  // max I/Os the io_uring disk manager keeps in flight
+static constexpr int DIRECT_IO_ALIGNMENT = 4096;  // buffer alignment required by O_DIRECT
+static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;  // frame arenas at least this large are backed by huge pages
+static constexpr size_t INDEX_SORT_MEMORY = 64 << 20;  // bytes of entries an index build sorts per run in memory
+static constexpr double INDEX_FILL_FACTOR = 0.9;  // share of a B+ tree page that a bulk load fills
+
+static_assert(BUSTUB_PAGE_SIZE >= 4096 && BUSTUB_PAGE_SIZE <= 32768 && (BUSTUB_PAGE_SIZE & (BUSTUB_PAGE_SIZE - 1)) == 0,
+              "the page size must be 4, 8, 16 or 32 KB");
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
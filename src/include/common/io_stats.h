@@ -0,0 +1,167 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_stats.h
+//
+// Identification: src/include/common/io_stats.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * A snapshot of buffer pool and disk I/O counters. The buffer pool counts hits, misses, evictions and latch waits, the
+ * disk manager counts bytes; a query's IoStats (see QueryIoScope) gets all of them.
+ */
+struct IoStats {
+  /** Fetches of a page that was in the buffer pool. */
+  uint64_t hits_{0};
+  /** Fetches of a page that was not in the buffer pool. */
+  uint64_t misses_{0};
+  /** Misses served by the compressed page cache rather than read from disk. */
+  uint64_t compressed_hits_{0};
+  /** Pages read ahead by prefetches. */
+  uint64_t prefetches_{0};
+  /** Hits on a page that a prefetch read ahead, counted once per prefetched page. */
+  uint64_t prefetch_hits_{0};
+  /** Pages evicted to make room for another page. */
+  uint64_t evictions_{0};
+  /** Evictions that first had to write the page back. */
+  uint64_t dirty_evictions_{0};
+  uint64_t read_bytes_{0};
+  uint64_t write_bytes_{0};
+  /** Time spent waiting for the buffer pool latch, in nanoseconds. */
+  uint64_t latch_wait_ns_{0};
+
+  auto operator+=(const IoStats &other) -> IoStats &;
+
+  /** @return the fraction of fetches that hit, or 0 if there were none */
+  auto GetHitRatio() const -> double;
+
+  auto ToString() const -> std::string;
+};
+
+/**
+ * Lock-free I/O counters of one buffer pool instance or disk manager. Counters are relaxed atomics, padded to a cache
+ * line of their own so that the counters of different shards do not share one. Every event is also added to the
+ * IoStats of the query the calling thread runs, if any.
+ */
+class alignas(64) IoCounters {
+ public:
+  void RecordHit() {
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    if (auto *query = QueryStats(); query != nullptr) {
+      query->hits_++;
+    }
+  }
+
+  void RecordMiss() {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    if (auto *query = QueryStats(); query != nullptr) {
+      query->misses_++;
+    }
+  }
+
+  void RecordCompressedHit() {
+    compressed_hits_.fetch_add(1, std::memory_order_relaxed);
+    if (auto *query = QueryStats(); query != nullptr) {
+      query->compressed_hits_++;
+    }
+  }
+
+  void RecordPrefetch() {
+    prefetches_.fetch_add(1, std::memory_order_relaxed);
+    if (auto *query = QueryStats(); query != nullptr) {
+      query->prefetches_++;
+    }
+  }
+
+  void RecordPrefetchHit() {
+    prefetch_hits_.fetch_add(1, std::memory_order_relaxed);
+    if (auto *query = QueryStats(); query != nullptr) {
+      query->prefetch_hits_++;
+    }
+  }
+
+  void RecordEviction(bool dirty) {
+    evictions_.fetch_add(1, std::memory_order_relaxed);
+    if (dirty) {
+      dirty_evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (auto *query = QueryStats(); query != nullptr) {
+      query->evictions_++;
+      query->dirty_evictions_ += dirty ? 1 : 0;
+    }
+  }
+
+  void RecordRead(uint64_t bytes) {
+    read_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    if (auto *query = QueryStats(); query != nullptr) {
+      query->read_bytes_ += bytes;
+    }
+  }
+
+  void RecordWrite(uint64_t bytes) {
+    write_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    if (auto *query = QueryStats(); query != nullptr) {
+      query->write_bytes_ += bytes;
+    }
+  }
+
+  void RecordLatchWait(uint64_t ns) {
+    latch_wait_ns_.fetch_add(ns, std::memory_order_relaxed);
+    if (auto *query = QueryStats(); query != nullptr) {
+      query->latch_wait_ns_ += ns;
+    }
+  }
+
+  /** @return the current values of the counters; counters are read one at a time, not as a consistent set */
+  auto Snapshot() const -> IoStats;
+
+ private:
+  static auto QueryStats() -> IoStats *;
+
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+  std::atomic<uint64_t> compressed_hits_{0};
+  std::atomic<uint64_t> prefetches_{0};
+  std::atomic<uint64_t> prefetch_hits_{0};
+  std::atomic<uint64_t> evictions_{0};
+  std::atomic<uint64_t> dirty_evictions_{0};
+  std::atomic<uint64_t> read_bytes_{0};
+  std::atomic<uint64_t> write_bytes_{0};
+  std::atomic<uint64_t> latch_wait_ns_{0};
+};
+
+/**
+ * While a QueryIoScope lives, the I/O its thread does is also counted in the given IoStats, e.g. the one of the
+ * ExecutorContext running a query. Scopes nest; the innermost one counts. Only the thread that created the scope
+ * writes to the IoStats, so it needs no synchronization. Reads completed by I/O threads on a query's behalf are not
+ * seen by the scope; the buffer pool attributes prefetches when it issues them.
+ */
+class QueryIoScope {
+ public:
+  explicit QueryIoScope(IoStats *stats);
+  ~QueryIoScope();
+
+  DISALLOW_COPY_AND_MOVE(QueryIoScope);
+
+  /** @return the IoStats of the innermost scope of the calling thread, or nullptr if there is none */
+  static auto Current() -> IoStats *;
+
+ private:
+  IoStats *previous_;
+};
+
+}  // namespace bustub
@@ -12,6 +12,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <mutex>  // NOLINT
 #include <shared_mutex>
 
@@ -48,4 +50,92 @@ class ReaderWriterLatch {
   std::shared_mutex mutex_;
 };
 
+/**
+ * Reader-writer latch that also supports optimistic reads, like a seqlock. The latch keeps a version that is odd
+ * while a writer holds it and moves on every time a writer releases it.
+ *
+ * An optimistic reader takes no latch and writes no shared memory, so readers do not bounce a cache line between
+ * them the way the reader count of a shared mutex does:
+ *
+ *   uint64_t version;
+ *   if (latch.TryOptimisticRead(&version)) {
+ *     ... copy what you need out of the protected data ...
+ *     if (latch.Validate(version)) { ... the copy is consistent ... }
+ *   }
+ *
+ * What is read before Validate() may be torn by a concurrent writer: only copy it, do not follow pointers or index
+ * arrays with it until it has been validated. On failure, retry or fall back to RLock().
+ */
+class OptimisticLatch {
+ public:
+  /**
+   * Acquire a write latch.
+   */
+  void WLock() {
+    mutex_.lock();
+    BumpVersion();
+  }
+
+  /**
+   * Acquire a write latch if no one holds the latch.
+   * @return true if the write latch was acquired
+   */
+  auto TryWLock() -> bool {
+    if (!mutex_.try_lock()) {
+      return false;
+    }
+    BumpVersion();
+    return true;
+  }
+
+  /**
+   * Release a write latch.
+   */
+  void WUnlock() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    mutex_.unlock();
+  }
+
+  /**
+   * Acquire a read latch.
+   */
+  void RLock() { mutex_.lock_shared(); }
+
+  /**
+   * Release a read latch.
+   */
+  void RUnlock() { mutex_.unlock_shared(); }
+
+  /**
+   * Start an optimistic read.
+   * @param[out] version the version to pass to Validate()
+   * @return false if a writer holds the latch, so the read would fail anyway
+   */
+  auto TryOptimisticRead(uint64_t *version) const -> bool {
+    *version = version_.load(std::memory_order_acquire);
+    return (*version & 1) == 0;
+  }
+
+  /**
+   * Finish an optimistic read.
+   * @param version the version TryOptimisticRead() returned
+   * @return true if no writer took the latch since TryOptimisticRead(), i.e. what was read is consistent
+   */
+  auto Validate(uint64_t version) const -> bool {
+    // Order the reader's loads of the protected data before the version check.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
+ private:
+  void BumpVersion() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    // Order the version bump before the writer's stores to the protected data.
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  std::shared_mutex mutex_;
+  std::atomic<uint64_t> version_{0};
+};
+
 }  // namespace bustub
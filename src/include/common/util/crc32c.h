@@ -0,0 +1,41 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c.h
+//
+// Identification: src/include/common/util/crc32c.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * CRC32C (Castagnoli), the checksum of iSCSI and ext4. Uses the SSE4.2 crc32 instruction when the CPU has it, and a
+ * table-driven implementation otherwise.
+ */
+class Crc32c {
+ public:
+  /**
+   * @param data the bytes to checksum
+   * @param length number of bytes
+   * @param crc the checksum of the bytes before data, to checksum a buffer in pieces
+   * @return the checksum of the bytes
+   */
+  static auto Compute(const char *data, size_t length, uint32_t crc = 0) -> uint32_t;
+
+  /** @return true if Compute() uses the crc32 instruction */
+  static auto IsHardwareAccelerated() -> bool;
+
+  /** Table-driven Compute(), exposed so that tests can check both implementations. */
+  static auto ComputeSoftware(const char *data, size_t length, uint32_t crc = 0) -> uint32_t;
+};
+
+}  // namespace bustub
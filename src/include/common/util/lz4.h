@@ -0,0 +1,48 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4.h
+//
+// Identification: src/include/common/util/lz4.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * A small compressor for the LZ4 block format: no frames, no dictionaries, one fast (greedy, single-probe) level. It
+ * is meant for buffers of a page or a few, where it trades a little ratio for speed the way LZ4 does. The output can
+ * be decompressed by any LZ4 block decoder, and Decompress() accepts any valid LZ4 block.
+ */
+class Lz4 {
+ public:
+  /**
+   * @param src the bytes to compress
+   * @param src_size number of bytes
+   * @param dst where to write the compressed block
+   * @param dst_capacity size of dst
+   * @return the size of the compressed block, or 0 if it does not fit in dst_capacity
+   */
+  static auto Compress(const char *src, size_t src_size, char *dst, size_t dst_capacity) -> size_t;
+
+  /**
+   * @param src a compressed block
+   * @param src_size size of the block
+   * @param dst where to write the decompressed bytes
+   * @param dst_size the exact number of bytes the block decompresses to
+   * @return false if the block is malformed or does not decompress to exactly dst_size bytes
+   */
+  static auto Decompress(const char *src, size_t src_size, char *dst, size_t dst_size) -> bool;
+
+  /** @return the largest size Compress() can produce for src_size bytes, i.e. for incompressible input */
+  static constexpr auto MaxCompressedSize(size_t src_size) -> size_t { return src_size + src_size / 255 + 16; }
+};
+
+}  // namespace bustub
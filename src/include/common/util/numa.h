@@ -0,0 +1,43 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// numa.h
+//
+// Identification: src/include/common/util/numa.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * The NUMA topology of the host, read straight from the kernel (sysfs, getcpu and mbind) so that there is no libnuma
+ * to link. On a host with a single node, or a kernel without NUMA support, everything is node 0 and nothing is bound.
+ */
+class Numa {
+ public:
+  /** @return the number of NUMA nodes, at least 1 */
+  static auto NumNodes() -> int;
+
+  /** @return the node of the CPU the calling thread is running on, 0 if unknown */
+  static auto CurrentNode() -> int;
+
+  /**
+   * Ask the kernel to place the pages of a mapping on a node. The mapping must not have been touched yet, since pages
+   * already faulted in stay where they are. The node is preferred rather than required, so memory still comes from
+   * other nodes once it is full.
+   * @param addr start of the mapping, page aligned
+   * @param length length of the mapping in bytes
+   * @param node the node to place the pages on
+   * @return true if the policy was set; false on a single-node host, for a node that does not exist, or on error
+   */
+  static auto BindMemory(void *addr, size_t length, int node) -> bool;
+};
+
+}  // namespace bustub
@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lock_free_page_table.h
+//
+// Identification: src/include/container/hash/lock_free_page_table.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * LockFreePageTable maps page ids to frame ids for the buffer pool hit path.
+ *
+ * It is a fixed-capacity, linearly probed open-addressing table whose slots are single 64-bit atomics packing
+ * (page_id, frame_id). Readers never take a latch. Writers (Insert/Remove) must be serialized externally; the buffer
+ * pool calls them only while holding its own latch on the miss path.
+ *
+ * A concurrent reader may miss an entry that is being moved or may return a mapping that has just been removed.
+ * Callers must therefore treat Find() as a hint: a miss falls back to the latched path, and a hit is validated against
+ * the frame's own page id after the frame has been pinned.
+ */
+class LockFreePageTable {
+ public:
+  /**
+   * @brief Create a new LockFreePageTable.
+   * @param max_entries the maximum number of live entries the table will hold (i.e. the number of frames)
+   */
+  explicit LockFreePageTable(size_t max_entries);
+
+  DISALLOW_COPY_AND_MOVE(LockFreePageTable);
+
+  ~LockFreePageTable() = default;
+
+  /**
+   * @brief Look up the frame holding the given page. Safe to call concurrently with anything.
+   * @param page_id the page to look up
+   * @param[out] frame_id the frame the page was mapped to
+   * @return true if a mapping was found
+   */
+  auto Find(page_id_t page_id, frame_id_t *frame_id) const -> bool;
+
+  /**
+   * @brief Insert or update the mapping for page_id. Must be externally serialized with other writers.
+   * @param page_id the page to map
+   * @param frame_id the frame holding the page
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * @brief Remove the mapping for page_id. Must be externally serialized with other writers.
+   * @param page_id the page to remove
+   * @return true if the page was mapped
+   */
+  auto Remove(page_id_t page_id) -> bool;
+
+ private:
+  static constexpr uint64_t EMPTY = UINT64_MAX;
+  static constexpr uint64_t TOMBSTONE = UINT64_MAX - 1;
+
+  static inline auto Pack(page_id_t page_id, frame_id_t frame_id) -> uint64_t {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static inline auto PageOf(uint64_t slot) -> page_id_t { return static_cast<page_id_t>(slot >> 32); }
+  static inline auto FrameOf(uint64_t slot) -> frame_id_t { return static_cast<frame_id_t>(slot & UINT32_MAX); }
+
+  /** @return the home slot of page_id */
+  inline auto SlotOf(page_id_t page_id) const -> size_t {
+    // Fibonacci hashing: page ids are mostly dense and sequential, this spreads them over the table.
+    return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 11400714819323198485ULL) >>
+                               shift_) &
+           mask_;
+  }
+
+  /** Rebuild the table in place to drop accumulated tombstones. Called by writers only. */
+  void Compact();
+
+  size_t mask_;
+  int shift_;
+  /** Number of tombstones, only touched by writers. */
+  size_t num_tombstones_{0};
+  std::vector<std::atomic<uint64_t>> slots_;
+};
+
+}  // namespace bustub
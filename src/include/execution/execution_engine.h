@@ -54,6 +54,9 @@ class ExecutionEngine {
                ExecutorContext *exec_ctx) -> bool {
     BUSTUB_ASSERT((txn == exec_ctx->GetTransaction()), "Broken Invariant");
 
+    // Attribute the buffer pool and disk I/O done on this thread to the query
+    QueryIoScope io_scope(exec_ctx->GetIoStats());
+
     // Construct the executor for the abstract plan node
     auto executor = ExecutorFactory::CreateExecutor(exec_ctx, plan);
 
@@ -13,18 +13,58 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "common/config.h"
+#include "common/io_stats.h"
 
 namespace bustub {
 
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Every page written to the database file gets a CRC32C, which is checked when the page is read back (unless
+ * verify_page_checksums is off), so torn or otherwise corrupted pages are caught on their way into the buffer pool.
+ * All 4 KB of a page belong to its users, so the checksums are not stored in the page but in a checksum file next to
+ * the database file (foo.db -> foo.crc), one 16-byte entry per page. Pages without an entry, e.g. those of a database
+ * file written before checksums existed, are not checked. The checksum file starts with the page size the database
+ * was created with, and a database created with another page size than BUSTUB_PAGE_SIZE does not open.
+ *
+ * Since the page and its checksum live in two files, an entry holds the checksums of the version of the page being
+ * written and of the version before it. Checksums are made durable along with the pages, not one write at a time:
+ * - A batch of combined writes (see SetWriteCombining()) syncs its checksums once before it writes its pages, and the
+ *   database file once after. After a crash such a page is one of the two versions: the old one is stale but not
+ *   corrupt, while a page torn between them matches neither.
+ * - Any other write only syncs the checksum file when it is the first one since the last Sync(), to mark the file as
+ *   having unordered writes. Sync() makes the pages and their checksums durable and clears the mark.
+ * Opening a database that was not shut down cleanly reads every page that has a checksum once to settle which version
+ * it holds, so that the next write of the page keeps the right one. While the checksum file is marked, a page that
+ * matches neither checksum may be a write whose checksum did not reach the disk before the crash, so it is taken as it
+ * is (and logged) rather than reported as corrupt; log recovery redoes whatever it lost.
+ *
+ * Deleted pages are tracked in a free-space map, a bitmap with one bit per page id kept in a file next to the database
+ * file (foo.db -> foo.fsm). The buffer pool hands free pages out again before it grows the file, and Compact() gives
+ * the free pages at the end of the file back to the file system.
+ *
+ * File offsets are 64-bit throughout, so a database file can grow to the 2^31 pages page ids address (8 TB with 4 KB
+ * pages), sparse or not.
+ *
+ * With write combining on (see SetWriteCombining()), page writes are queued and written in batches, so that evicting
+ * or checkpointing many pages costs a few large sequential writes and one fdatasync per batch rather than a system
+ * call per page.
  */
 class DiskManager {
  public:
@@ -37,7 +77,7 @@ class DiskManager {
   /** FOR TEST / LEADERBOARD ONLY, used by DiskManagerMemory */
   DiskManager() = default;
 
-  virtual ~DiskManager() = default;
+  virtual ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -45,19 +85,99 @@ class DiskManager {
   void ShutDown();
 
   /**
-   * Write a page to the database file.
+   * Remove the files the disk manager keeps next to a database file, so that a test can start from an empty database.
+   * The database file itself is left alone.
+   * @param db_file the database file name, as passed to the constructor
+   */
+  static void RemoveSidecarFiles(const std::string &db_file);
+
+  /**
+   * Write a page to the database file. Short writes are continued; if the write still fails, the page's checksum is
+   * left as it was, and the caller has to keep the page dirty and write it again later.
    * @param page_id id of the page
    * @param page_data raw page data
+   * @return false if the page could not be written
    */
-  virtual void WritePage(page_id_t page_id, const char *page_data);
+  virtual auto WritePage(page_id_t page_id, const char *page_data) -> bool;
 
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @throws Exception of type CORRUPTION if the page does not match its checksum
    */
   virtual void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Read a page without blocking the caller. The read is queued to a small pool of I/O threads, started on first use,
+   * which call ReadPage() and then done.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, must stay valid until done is called
+   * @param done called on an I/O thread once page_data holds the page, with false if the page does not match its
+   * checksum
+   */
+  virtual void ReadPageAsync(page_id_t page_id, char *page_data, std::function<void(bool)> done);
+
+  /**
+   * Write a run of consecutive pages to the database file. The file-backed disk manager issues vectored writes
+   * (pwritev), so a run costs one system call instead of one per page; other disk managers write page by page.
+   * @param first_page_id id of the first page of the run
+   * @param pages_data raw data of pages first_page_id, first_page_id + 1, ...
+   * If the run cannot be written completely, the pages that did not make it keep the checksums they had, and the
+   * caller has to keep every page of the run dirty and write them again later.
+   * @param num_pages number of pages in the run
+   * @return false if some page of the run could not be written
+   */
+  virtual auto WritePages(page_id_t first_page_id, const char *const *pages_data, size_t num_pages) -> bool;
+
+  /**
+   * Make every page written so far, and its checksum, durable (fsync). A no-op for disk managers that do not write to
+   * a file. This is the barrier for queued writes: checkpoints, and anything else that must be on disk before it goes
+   * on (e.g. before truncating the log), call it rather than rely on when a batch happens to be written. Pages written
+   * before the last Sync() are checked strictly again after a crash, see the class comment.
+   */
+  virtual void Sync();
+
+  /**
+   * Turn write combining on or off. With write combining, WritePage() copies the page into a queue and returns. Once
+   * WRITE_COMBINE_PAGES pages are queued, the queue is written in page id order, each run of consecutive pages with
+   * one vectored write, and made durable with a single fdatasync. A page written again while queued is only written
+   * once. Reads see queued pages. Turning write combining off writes the queue. Disk managers that override WritePage()
+   * do not combine writes.
+   */
+  void SetWriteCombining(bool enabled);
+
+  /** @return the number of page writes queued and not written to the file yet */
+  auto GetNumQueuedWrites() -> size_t;
+
+  /**
+   * Mark a page as free, so that AllocateFreePage() hands its id out again. Freeing a free page does nothing: the id
+   * would otherwise be handed out twice.
+   * @param page_id id of the page
+   * @return false if the page id is invalid or the page is free already
+   */
+  auto DeallocatePage(page_id_t page_id) -> bool;
+
+  /**
+   * Take the free page with the lowest id among the pages of a buffer pool instance, i.e. the pages whose id is
+   * instance_index modulo num_instances.
+   * @return the id of the page, or INVALID_PAGE_ID if the instance has no free page
+   */
+  auto AllocateFreePage(uint32_t num_instances, uint32_t instance_index) -> page_id_t;
+
+  /** @return true if the page is free in the free-space map */
+  auto IsFreePage(page_id_t page_id) -> bool;
+
+  /** @return the number of free pages */
+  auto GetNumFreePages() -> size_t;
+
+  /**
+   * Truncate the database file after its last page that is not free. The truncated pages stay free, and read as
+   * zeros until they are written again. Safe to call while the database is in use.
+   * @return the number of pages the file shrank by
+   */
+  auto Compact() -> size_t;
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -72,7 +192,7 @@ class DiskManager {
    * @param offset offset of the log entry in the file
    * @return true if the read was successful, false otherwise
    */
-  auto ReadLog(char *log_data, int size, int offset) -> bool;
+  auto ReadLog(char *log_data, int size, int64_t offset) -> bool;
 
   /** @return the number of disk flushes */
   auto GetNumFlushes() const -> int;
@@ -83,6 +203,9 @@ class DiskManager {
   /** @return the number of disk writes */
   auto GetNumWrites() const -> int;
 
+  /** @return the bytes read and written so far; the other counters are the buffer pool's */
+  auto GetStats() const -> IoStats { return stats_.Snapshot(); }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -93,7 +216,103 @@ class DiskManager {
   inline auto HasFlushLogFuture() -> bool { return flush_log_f_ != nullptr; }
 
  protected:
-  auto GetFileSize(const std::string &file_name) -> int;
+  /**
+   * An entry of the checksum file: the checksums of the page as last written and as written before that. A checksum
+   * that was never written is zero and does not have the magic number.
+   */
+  struct PageChecksum {
+    uint32_t checksum_;
+    uint32_t magic_;
+    uint32_t previous_checksum_;
+    uint32_t previous_magic_;
+  };
+  static constexpr uint32_t CHECKSUM_MAGIC = 0x43524332;
+  /**
+   * The first entry of the checksum file holds the page size and this magic number. Its previous magic is
+   * CHECKSUM_CLEAN_MAGIC while the database is shut down cleanly, CHECKSUM_UNORDERED_MAGIC while pages may have been
+   * written since the last Sync() without their checksums being durable first, and zero otherwise.
+   */
+  static constexpr uint32_t CHECKSUM_FILE_MAGIC = 0x50475A32;
+  static constexpr uint32_t CHECKSUM_CLEAN_MAGIC = 0x434C4E31;
+  static constexpr uint32_t CHECKSUM_UNORDERED_MAGIC = 0x554E4F31;
+
+  /** @return the name of the file with the given extension that belongs to db_file, e.g. test.crc for test.db */
+  static auto SidecarFileName(const std::string &db_file, const char *extension) -> std::string;
+  /**
+   * Open the checksum file of a database file and load its entries.
+   * @param db_file the database file
+   * @param truncate true if the database file was just created, so that any old checksums are stale
+   * @param read_only true if checksums will only be verified, not recorded
+   * @throws Exception of type MISMATCH_TYPE if the database was created with another page size
+   */
+  void OpenChecksumFile(const std::string &db_file, bool truncate, bool read_only);
+  /**
+   * Compute and record the checksums of a run of consecutive pages that are about to be written, in memory and in the
+   * checksum file. Does not sync: callers either sync the checksum file before they write the pages, or hold
+   * write_order_latch_ shared and call BeginUnorderedWrite() first.
+   * @param[out] replaced if not null, gets the num_pages entries the pages had before, for RestoreChecksums()
+   */
+  void RecordChecksums(page_id_t first_page_id, const char *const *pages_data, size_t num_pages,
+                       PageChecksum *replaced = nullptr);
+  /** Put back the entries RecordChecksums() replaced, after the pages could not be written. */
+  void RestoreChecksums(page_id_t first_page_id, const PageChecksum *entries, size_t num_pages);
+  /**
+   * Mark the checksum file as having unordered writes, unless it already is, before a page is written without its
+   * checksum being synced first. Caller must hold write_order_latch_ shared.
+   */
+  void BeginUnorderedWrite();
+  /** Write the first entry of the checksum file with the given previous magic, and sync the file. */
+  auto WriteChecksumHeader(uint32_t state_magic) -> bool;
+  /**
+   * Settle which of its two checksums each page on disk matches, after the database was not shut down cleanly.
+   * Caller must hold checksum_latch_.
+   * @param unordered true if the checksum file was marked as having unordered writes, so that a page matching neither
+   * checksum gets the checksum of what it holds
+   */
+  void ResolveChecksums(bool unordered);
+  /** Sync the database and checksum files, and mark the latter as shut down cleanly. Caller must hold db_io_latch_. */
+  void MarkCleanShutdown();
+  /**
+   * Write the queued pages before the file is closed, and mark the checksum file as shut down cleanly unless some of
+   * them could not be written. Caller must hold db_io_latch_.
+   */
+  void CloseWriteQueue();
+  /** Write the checksum file entries of a run of pages. Caller must hold checksum_latch_. */
+  void PersistChecksums(size_t first, size_t num_pages);
+  /** @return false if checksums are verified and the page matches neither of the checksums recorded for it */
+  auto ChecksumMatches(page_id_t page_id, const char *page_data) -> bool;
+  /** Throw an Exception of type CORRUPTION if the page does not match its checksum. */
+  void VerifyChecksum(page_id_t page_id, const char *page_data);
+
+  /**
+   * Open the free-space map of a database file and load it.
+   * @param db_file the database file
+   * @param truncate true if the database file was just created, so that the old map is stale
+   */
+  void OpenFreeSpaceMap(const std::string &db_file, bool truncate);
+  /** Write a word of the free-space map back to its file. Caller must hold fsm_latch_. */
+  void PersistFreePagesWord(size_t word);
+  /** Make the free-space map durable. */
+  void SyncFreeSpaceMap();
+
+  /**
+   * Write a run of consecutive pages to the file, whose checksums are recorded, continuing short writes. If a write
+   * fails, the checksums of the pages from the one it stopped in on are restored from replaced. Caller must hold
+   * db_io_latch_.
+   * @param replaced the entries RecordChecksums() replaced for the run
+   * @return the number of pages at the start of the run that were written, num_pages unless a write failed
+   */
+  auto WritePagesLocked(page_id_t first_page_id, const char *const *pages_data, size_t num_pages,
+                        const PageChecksum *replaced) -> size_t;
+  /**
+   * Write the queued pages to the file as one batch and empty the queue: record their checksums and sync them, write
+   * the pages, and sync the database file. Pages that could not be written stay queued, as does the whole batch if
+   * the database file cannot be synced. Caller must hold db_io_latch_.
+   * @return false if some page stays queued
+   */
+  auto WriteQueuedPages() -> bool;
+
+  auto GetFileSize(const std::string &file_name) -> int64_t;
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
@@ -102,10 +321,51 @@ class DiskManager {
   std::string file_name_;
   int num_flushes_{0};
   int num_writes_{0};
+  // bytes read and written, see GetStats()
+  IoCounters stats_;
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
+  // file descriptor of the db file for vectored writes and fsync, -1 if there is no file
+  int db_fd_{-1};
   // With multiple buffer pool instances, need to protect file access
   std::mutex db_io_latch_;
+  // queued page writes by page id, see SetWriteCombining(); protected by db_io_latch_
+  bool write_combining_{false};
+  std::map<page_id_t, std::unique_ptr<char[]>> write_queue_;
+  // checksum file, its entries indexed by page id, and the latch protecting both
+  std::string checksum_name_;
+  int checksum_fd_{-1};
+  std::vector<PageChecksum> checksums_;
+  std::mutex checksum_latch_;
+  // Held shared by writes that do not sync their checksums first, and exclusively by Sync() while it makes them
+  // durable, so that the unordered mark is not cleared under a write in progress.
+  std::shared_mutex write_order_latch_;
+  // true while the checksum file is marked as having unordered writes; set under checksum_header_latch_
+  std::atomic<bool> unordered_writes_{false};
+  std::mutex checksum_header_latch_;
+  // free-space map file, the map itself (bit i of word j is page j * 64 + i), its number of set bits, and the latch
+  // protecting them
+  std::string fsm_name_;
+  int fsm_fd_{-1};
+  std::vector<uint64_t> free_pages_;
+  size_t num_free_pages_{0};
+  std::mutex fsm_latch_;
+
+  /**
+   * Drain the request queue and join the I/O threads. Subclasses that override ReadPage() must call this in their
+   * destructor, since queued reads would otherwise run against the base class.
+   */
+  void StopIoWorkers();
+
+ private:
+  /** Body of an I/O thread: run queued requests until StopIoWorkers() is called and the queue is drained. */
+  void RunIoWorker();
+
+  std::vector<std::thread> io_workers_;
+  std::deque<std::function<void()>> io_queue_;
+  bool io_workers_stopping_{false};
+  std::mutex io_queue_latch_;
+  std::condition_variable io_queue_cv_;
 };
 
 }  // namespace bustub
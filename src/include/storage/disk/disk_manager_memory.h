@@ -12,6 +12,7 @@
 #include <array>
 #include <cstring>
 #include <fstream>
+#include <functional>
 #include <future>  // NOLINT
 #include <memory>
 #include <mutex>  // NOLINT
@@ -42,8 +43,9 @@ class DiskManagerMemory : public DiskManager {
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
+   * @return true, writing to memory does not fail
    */
-  void WritePage(page_id_t page_id, const char *page_data) override;
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override;
 
   /**
    * Read a page from the database file.
@@ -68,8 +70,9 @@ class DiskManagerUnlimitedMemory : public DiskManager {
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
+   * @return true, writing to memory does not fail
    */
-  void WritePage(page_id_t page_id, const char *page_data) override {
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override {
     std::unique_lock<std::mutex> l(mutex_);
     if (page_id >= static_cast<int>(data_.size())) {
       data_.resize(page_id + 1);
@@ -81,7 +84,9 @@ class DiskManagerUnlimitedMemory : public DiskManager {
     std::unique_lock<std::shared_mutex> l_page(ptr->second);
     l.unlock();
 
+    stats_.RecordWrite(BUSTUB_PAGE_SIZE);
     memcpy(ptr->first.data(), page_data, BUSTUB_PAGE_SIZE);
+    return true;
   }
 
   /**
@@ -103,6 +108,7 @@ class DiskManagerUnlimitedMemory : public DiskManager {
     std::shared_lock<std::shared_mutex> l_page(ptr->second);
     l.unlock();
 
+    stats_.RecordRead(BUSTUB_PAGE_SIZE);
     memcpy(page_data, ptr->first.data(), BUSTUB_PAGE_SIZE);
   }
 
@@ -113,4 +119,52 @@ class DiskManagerUnlimitedMemory : public DiskManager {
   std::vector<std::shared_ptr<ProtectedPage>> data_;
 };
 
+/**
+ * DiskManagerMmap serves the pages of an existing database file from a read-only memory mapping. It is meant for
+ * read-mostly replicas: ReadPage() is a memcpy out of the mapping instead of a system call, and readers that bypass
+ * the buffer pool can use pages in place through GetPageData().
+ *
+ * The mapping covers the file as it was when the disk manager was created; pages past its end read as zeros. Writing
+ * a page throws.
+ */
+class DiskManagerMmap : public DiskManager {
+ public:
+  /**
+   * Map the specified database file.
+   * @param db_file the file name of the database file to read from
+   */
+  explicit DiskManagerMmap(const std::string &db_file);
+
+  ~DiskManagerMmap() override;
+
+  /** Always throws, the file is mapped read-only. */
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override;
+
+  /**
+   * Copy a page out of the mapping.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   * @throws Exception of type CORRUPTION if the page does not match its checksum
+   */
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /** Reading a page does not block, so this copies the page and calls done right away. */
+  void ReadPageAsync(page_id_t page_id, char *page_data, std::function<void(bool)> done) override;
+
+  /**
+   * @param page_id id of the page
+   * @return the page inside the mapping, or nullptr if it is past the end of the file. Valid until the disk manager
+   * is destroyed. The page is not checked against its checksum.
+   */
+  auto GetPageData(page_id_t page_id) const -> const char *;
+
+  /** @return the number of pages in the mapping */
+  auto GetNumPages() const -> size_t { return num_pages_; }
+
+ private:
+  char *data_{nullptr};
+  size_t size_{0};
+  size_t num_pages_{0};
+};
+
 }  // namespace bustub
@@ -0,0 +1,145 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring_disk_manager.h
+//
+// Identification: src/include/storage/disk/io_uring_disk_manager.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/uio.h>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace bustub {
+
+/**
+ * IoUringDiskManager reads and writes pages with positioned I/O on a file descriptor opened with O_DIRECT, so pages
+ * bypass the kernel page cache that the buffer pool already duplicates.
+ *
+ * Page I/O is submitted to an io_uring instance and completed by a reaper thread. Any number of threads, e.g. the
+ * instances of a parallel buffer pool, can have I/Os in flight at the same time, up to IO_URING_QUEUE_DEPTH in total;
+ * there is no latch around the file. When io_uring is unavailable, pages are read and written with pread/pwrite
+ * directly on the calling thread, and ReadPageAsync() falls back to the I/O thread pool of DiskManager. When the file
+ * system does not support O_DIRECT, the file is opened without it.
+ *
+ * O_DIRECT requires page buffers aligned to DIRECT_IO_ALIGNMENT. Unaligned buffers are copied through an aligned
+ * bounce buffer. The log file is still handled by DiskManager.
+ */
+class IoUringDiskManager : public DiskManager {
+ public:
+  /**
+   * Creates a new disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param use_io_uring false to always use the pread/pwrite fallback
+   */
+  explicit IoUringDiskManager(const std::string &db_file, bool use_io_uring = true);
+
+  ~IoUringDiskManager() override;
+
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override;
+
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  void ReadPageAsync(page_id_t page_id, char *page_data, std::function<void(bool)> done) override;
+
+  /** Submits every page of the run at once and waits for all of them. */
+  auto WritePages(page_id_t first_page_id, const char *const *pages_data, size_t num_pages) -> bool override;
+
+  /** @return true if page I/O goes through io_uring, false if it uses the pread/pwrite fallback */
+  auto UsesIoUring() const -> bool { return ring_fd_ >= 0; }
+
+  /** @return true if the database file was opened with O_DIRECT */
+  auto UsesDirectIo() const -> bool { return direct_io_; }
+
+ private:
+  /** One page read or write, from submission until its completion callback runs. */
+  struct IoRequest {
+    bool is_write_;
+    page_id_t page_id_;
+    /** The caller's buffer. */
+    char *data_;
+    /** The buffer handed to the kernel: data_ itself, or a bounce buffer if data_ is not aligned for O_DIRECT. */
+    char *io_buf_;
+    /** Bytes transferred so far; short transfers are resubmitted for the rest of the page. */
+    size_t done_{0};
+    struct iovec iov_;
+    /** True if the reaper checks the checksum of the page before calling back; synchronous reads check their own. */
+    bool verify_{false};
+    /** Called with false if a write failed, or if the page a read got did not match its checksum. */
+    std::function<void(bool)> callback_;
+    /**
+     * Set on every submission and read by the reaper. The ring already orders the two, but this makes the ordering
+     * visible to the thread sanitizer, which does not see through the kernel.
+     */
+    std::atomic<bool> submitted_{false};
+  };
+
+  /** Create the ring, map its queues and start the reaper thread. @return false if io_uring is unavailable */
+  auto SetUpRing() -> bool;
+  /** Wait for all I/Os in flight, stop the reaper thread and unmap the ring. */
+  void TearDownRing();
+  /** Queue a request, waiting while IO_URING_QUEUE_DEPTH requests are in flight. The callback runs on the reaper. */
+  void Submit(IoRequest *request);
+  /** Push the rest of a request, or a no-op that stops the reaper if request is nullptr, and submit it. */
+  void PushRequest(IoRequest *request);
+  /** Body of the reaper thread: complete requests until the stop no-op arrives. */
+  void RunReaper();
+  /** Handle the completion of a request that transferred res bytes, or failed with -res. */
+  void CompleteRequest(IoRequest *request, int res);
+
+  auto NewRequest(bool is_write, page_id_t page_id, char *data, std::function<void(bool)> callback) -> IoRequest *;
+  /** Pread/pwrite fallback for a single page. @return false if a write failed */
+  auto TransferPage(bool is_write, page_id_t page_id, char *data) -> bool;
+  /** @return data if it can be used for I/O as is, otherwise an aligned bounce buffer (holding a copy for writes) */
+  auto AcquireIoBuffer(bool is_write, char *data) -> char *;
+  /** Copy a read back out of the bounce buffer, if any, and return the bounce buffer. */
+  void ReleaseIoBuffer(bool is_write, char *data, char *io_buf);
+
+  bool direct_io_{false};
+
+  /** io_uring file descriptor, -1 if io_uring is not used. */
+  int ring_fd_{-1};
+  unsigned sq_entries_{0};
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  io_uring_cqe *cqes_{nullptr};
+  std::thread reaper_thread_;
+
+  /** Protects the submission queue and in_flight_. */
+  std::mutex sq_latch_;
+  /** Signalled whenever a request finishes. */
+  std::condition_variable sq_cv_;
+  size_t in_flight_{0};
+
+  std::mutex bounce_latch_;
+  std::vector<char *> free_bounce_buffers_;
+};
+
+}  // namespace bustub
@@ -10,14 +10,19 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <functional>
+#include <mutex>
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -28,35 +33,68 @@ namespace bustub {
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) Keys are unique, unless the tree allows duplicate keys: then every key
+ *     is stored once, with a posting list of its values if it has several
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * The tree is safe to use from many threads at once. Lookups crab down with read latches, taking the latch of a child
+ * before releasing the one of its parent. Writers first descend optimistically the same way and take the write latch
+ * of the leaf only; most inserts and removes change nothing but that leaf. When the leaf would split or underflow, the
+ * writer lets go and descends again with write latches, releasing the latches above each node that is certain not
+ * to split or merge. root_page_id_ has a latch of its own, which acts as the parent of the root page.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
   using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  using PostingPage = BPlusTreePostingPage<ValueType>;
 
  public:
+  /**
+   * @param leaf_max_size a leaf splits when it reaches this many entries, or earlier when its keys fill the page
+   * @param internal_max_size an internal page splits when it would get more than this many children
+   * @param header_page_id page that records the root page id of the tree under its name, or INVALID_PAGE_ID to keep
+   * the root page id in memory only
+   * @param unique_keys false to allow several values per key, as a secondary index on a column with repeated values
+   * needs; the values of a key must then be distinct
+   */
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE,
+                     page_id_t header_page_id = HEADER_PAGE_ID, bool unique_keys = true);
 
   // Returns true if this B+ tree has no keys and values.
   auto IsEmpty() const -> bool;
 
-  // Insert a key-value pair into this B+ tree.
+  // Insert a key-value pair into this B+ tree. Returns false if the key is already there and keys are unique.
   auto Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr) -> bool;
 
-  // Remove a key and its value from this B+ tree.
+  // Remove a key and all its values from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
-  // return the value associated with a given key
+  // Remove one value of a key from this B+ tree, and the key with it if it was the last one.
+  void Remove(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+
+  /**
+   * Build the empty tree bottom-up from entries in key order, e.g. read from an IndexEntrySorter. Leaves are filled
+   * one after the other and each internal level is built in one pass over the level below, rather than descending
+   * from the root for every entry. Of entries with equal keys, only the first is kept if keys are unique.
+   * @param next produces the next entry; returns false when there are none left
+   * @param fill_factor share of each page to fill, leaving room for inserts before pages split
+   * @return false if the tree is not empty
+   */
+  auto BulkLoad(const std::function<bool(MappingType *)> &next, double fill_factor = INDEX_FILL_FACTOR) -> bool;
+
+  // return the values associated with a given key
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr) -> bool;
 
   // return the page id of the root node
   auto GetRootPageId() -> page_id_t;
 
+  // return the ids of the first pages of the extents the tree has reserved, in order
+  auto GetExtents() -> std::vector<page_id_t>;
+
   // index iterator
   auto Begin() -> INDEXITERATOR_TYPE;
   auto Begin(const KeyType &key) -> INDEXITERATOR_TYPE;
@@ -75,6 +113,81 @@ class BPlusTree {
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
 
  private:
+  enum class Operation { INSERT, REMOVE };
+
+  /**
+   * The latches a pessimistic writer holds: the root latch, for as long as the root may change, and the write guards
+   * of the nodes on the path to the leaf that may still split or merge, top-down. Everything is released when the
+   * context goes out of scope.
+   */
+  class Context {
+   public:
+    explicit Context(ReaderWriterLatch *root_latch) : root_latch_(root_latch) { root_latch_->WLock(); }
+    ~Context() { ReleaseRootLatch(); }
+
+    Context(const Context &) = delete;
+    auto operator=(const Context &) -> Context & = delete;
+
+    auto HoldsRootLatch() const -> bool { return root_latch_ != nullptr; }
+
+    void ReleaseRootLatch() {
+      if (root_latch_ != nullptr) {
+        root_latch_->WUnlock();
+        root_latch_ = nullptr;
+      }
+    }
+
+    /** Release the root latch and all guards, when the writer reaches a node that will absorb the change. */
+    void ReleaseAncestors() {
+      ReleaseRootLatch();
+      write_set_.clear();
+    }
+
+    std::vector<WritePageGuard> write_set_;
+
+   private:
+    ReaderWriterLatch *root_latch_;
+  };
+
+  // latched page access, throwing when the buffer pool has no frame for the page
+  auto FetchBasic(page_id_t page_id) -> BasicPageGuard;
+  auto FetchRead(page_id_t page_id) -> ReadPageGuard;
+  auto FetchWrite(page_id_t page_id) -> WritePageGuard;
+  // a new node, in the current extent of the tree if the buffer pool supports extents
+  auto NewNode(page_id_t *page_id) -> BasicPageGuard;
+
+  // @return true if an operation on key cannot make the page split or merge
+  auto IsSafe(const BPlusTreePage *page, Operation op, bool is_root, const KeyType &key) const -> bool;
+
+  // Crab down to the leaf covering key, or the leftmost leaf if key is nullptr, with read latches.
+  auto FindLeafRead(const KeyType *key) -> ReadPageGuard;
+  // Crab down with read latches and write-latch the leaf. Returns an invalid guard if the tree is empty.
+  auto FindLeafOptimistic(const KeyType &key, bool *is_root) -> WritePageGuard;
+  // Crab down with write latches, keeping the ones a split or merge may need in the context.
+  void FindLeafPessimistic(const KeyType &key, Operation op, Context *ctx);
+
+  // insertion
+  auto InsertPessimistic(const KeyType &key, const ValueType &value) -> bool;
+  void InsertIntoParent(Context *ctx, size_t level, const KeyType &key, page_id_t new_page_id);
+
+  // deletion; a null value removes the key with all its values
+  void RemoveValue(const KeyType &key, const ValueType *value);
+  auto RemovePessimistic(const KeyType &key, const ValueType *value) -> bool;
+  // Take the value off the key in the leaf if that leaves the entry of the key in place. Returns true if the entry
+  // has to go.
+  auto RemoveFromEntry(WritePageGuard *leaf_guard, int index, const ValueType *value) -> bool;
+  // Remove the entry at index from the leaf, with its posting list. Returns the new size of the leaf.
+  auto RemoveEntry(LeafPage *leaf, int index) -> int;
+  auto LatchSibling(Context *ctx, size_t level, bool wait, WritePageGuard *sibling) -> bool;
+  void CoalesceOrRedistribute(Context *ctx, size_t level, WritePageGuard sibling_guard);
+
+  // posting lists of keys with several values
+  auto IsPostingList(const ValueType &value) const -> bool { return !unique_keys_ && IsPostingListRef(value); }
+  void CollectValues(const ValueType &value, std::vector<ValueType> *result);
+  void AppendToPostingList(LeafPage *leaf, int index, const ValueType &value);
+  void RemoveFromPostingList(LeafPage *leaf, int index, const ValueType &value);
+  void DeletePostingList(page_id_t page_id);
+
   void UpdateRootPageId(int insert_record = 0);
 
   /* Debug Routines for FREE!! */
@@ -89,6 +202,14 @@ class BPlusTree {
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  page_id_t header_page_id_;
+  bool unique_keys_;
+  ReaderWriterLatch root_latch_;
+  // Protects the extents. The next page of the current extent is equal to extent_end_ once the extent is full.
+  std::mutex extent_latch_;
+  std::vector<page_id_t> extents_;
+  page_id_t next_extent_page_id_{INVALID_PAGE_ID};
+  page_id_t extent_end_{INVALID_PAGE_ID};
 };
 
 }  // namespace bustub
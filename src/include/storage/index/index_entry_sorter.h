@@ -0,0 +1,102 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_entry_sorter.h
+//
+// Identification: src/include/storage/index/index_entry_sorter.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define INDEX_ENTRY_SORTER_TYPE IndexEntrySorter<KeyType, ValueType, KeyComparator>
+
+/**
+ * IndexEntrySorter sorts the (key, value) entries of an index build by key, so that BPlusTree::BulkLoad() can build
+ * the tree bottom-up. Entries are collected in memory up to a budget; past it, each full buffer is sorted and spilled
+ * as a run of temporary pages, and the runs are merged as the entries are read back (an external merge sort). Entries
+ * with equal keys come out in the order they were added.
+ *
+ * Runs are written and read through the buffer pool as scan pages, so they do not push the working set out of the
+ * pool, and each page of a run is deleted once the merge is past it. The merge keeps one page of every run pinned, so
+ * the buffer pool must have a frame for each run: with the default budget, a pool of 128 frames sorts 8 GB of entries.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class IndexEntrySorter {
+ public:
+  /**
+   * @param bpm buffer pool for the spilled runs
+   * @param comparator comparator of the keys
+   * @param memory_budget bytes of entries kept in memory before a run is spilled
+   */
+  IndexEntrySorter(BufferPoolManager *bpm, const KeyComparator &comparator, size_t memory_budget = INDEX_SORT_MEMORY);
+
+  /** Delete the pages of the runs that were not read back. */
+  ~IndexEntrySorter();
+
+  IndexEntrySorter(const IndexEntrySorter &) = delete;
+  auto operator=(const IndexEntrySorter &) -> IndexEntrySorter & = delete;
+
+  /** Add an entry. Must not be called after Finish(). */
+  void Add(const KeyType &key, const ValueType &value);
+
+  /** Sort what is left in memory and prepare the merge. Call it once, after the last Add(). */
+  void Finish();
+
+  /**
+   * Read the next entry in key order. Finish() must have been called.
+   * @param[out] item the entry
+   * @return false if all entries have been read
+   */
+  auto Next(MappingType *item) -> bool;
+
+  /** @return the number of runs spilled to pages, 0 if the entries fit in memory */
+  auto GetNumRuns() const -> size_t { return runs_.size(); }
+
+ private:
+  /** A sorted run on disk, and how far the merge has read it. */
+  struct Run {
+    std::vector<page_id_t> pages_;
+    size_t size_{0};
+    size_t next_{0};
+    size_t deleted_pages_{0};
+    ReadPageGuard guard_;
+  };
+
+  /** Sort the buffer and write it out as a run. */
+  void Spill();
+
+  /** Point the run at its next entry, fetching its next page if needed. @return false if the run is exhausted */
+  auto Advance(Run *run) -> bool;
+
+  /** @return true if entry a comes out after entry b; the merge heap keeps the smallest entry on top */
+  auto After(const std::pair<MappingType, size_t> &a, const std::pair<MappingType, size_t> &b) const -> bool;
+
+  static constexpr size_t ENTRIES_PER_PAGE = BUSTUB_PAGE_SIZE / sizeof(MappingType);
+
+  BufferPoolManager *bpm_;
+  KeyComparator comparator_;
+  size_t max_buffered_;
+  bool finished_{false};
+
+  std::vector<MappingType> buffer_;
+  size_t buffer_next_{0};
+
+  std::vector<Run> runs_;
+  // Heap of the next entry of every run that is not exhausted, tagged with the index of the run.
+  std::vector<std::pair<MappingType, size_t>> heap_;
+};
+
+}  // namespace bustub
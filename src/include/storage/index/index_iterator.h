@@ -14,30 +14,75 @@
  */
 #pragma once
 #include "storage/page/b_plus_tree_leaf_page.h"
+#include "storage/page/b_plus_tree_posting_page.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+/**
+ * IndexIterator walks the leaves of a BPlusTree in key order. It holds the read latch of the leaf it is on and moves
+ * to the next leaf by latching it before it lets go of the current one, the same left-to-right order every latch on
+ * leaf siblings is taken in, so the leaf under an iterator can be neither changed nor merged away. A thread must
+ * therefore not modify the tree while it holds an iterator that is not at the end.
+ *
+ * In a tree that allows duplicate keys, the iterator yields every value of a key in turn, reading its posting list
+ * while it holds the leaf.
+ *
+ * Whenever the iterator moves onto a leaf, it prefetches the next one, and READ_AHEAD_PAGES leaves from there on if
+ * the next leaf directly follows the current one on disk, so that a cold range scan does not wait on every leaf.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
  public:
-  // you may define your own constructor based on your member variables
+  /** Construct the end iterator. */
   IndexIterator();
+  /**
+   * @param bpm the buffer pool of the tree
+   * @param guard the read-latched leaf to start on
+   * @param index the position in the leaf to start at; positions past the end of the leaf continue on the next one
+   * @param postings true if values of the leaves may refer to posting lists
+   */
+  IndexIterator(BufferPoolManager *bpm, ReadPageGuard guard, int index, bool postings = false);
   ~IndexIterator();  // NOLINT
 
+  IndexIterator(IndexIterator &&that) noexcept = default;
+  auto operator=(IndexIterator &&that) noexcept -> IndexIterator & = default;
+
   auto IsEnd() -> bool;
 
   auto operator*() -> const MappingType &;
 
   auto operator++() -> IndexIterator &;
 
-  auto operator==(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  auto operator==(const IndexIterator &itr) const -> bool {
+    return page_id_ == itr.page_id_ && index_ == itr.index_ && posting_page_id_ == itr.posting_page_id_ &&
+           posting_index_ == itr.posting_index_;
+  }
 
-  auto operator!=(const IndexIterator &itr) const -> bool { throw std::runtime_error("unimplemented"); }
+  auto operator!=(const IndexIterator &itr) const -> bool { return !(*this == itr); }
 
  private:
-  // add your own private member variables here
+  /** Move on to the next leaf that has an entry at index_, or to the end, and open the posting list of the entry. */
+  void SkipExhaustedLeaves();
+
+  /** Prefetch the leaves after the one the iterator is on. */
+  void ReadAhead();
+
+  /** Move on to the page of the posting list at page_id. */
+  void FetchPostingPage(page_id_t page_id);
+
+  BufferPoolManager *bpm_{nullptr};
+  ReadPageGuard guard_;
+  page_id_t page_id_{INVALID_PAGE_ID};
+  int index_{0};
+  bool postings_{false};
+  // The page of the posting list of the current entry that the iterator is on, if the entry has one.
+  ReadPageGuard posting_guard_;
+  page_id_t posting_page_id_{INVALID_PAGE_ID};
+  int posting_index_{0};
+  // The entry the iterator is on, as operator*() last put it together.
+  MappingType item_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,229 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// normalized_key.h
+//
+// Identification: src/include/storage/index/normalized_key.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "catalog/schema.h"
+#include "common/exception.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * NormalizedKey holds the columns of a key encoded one after the other so that memcmp() orders two keys the way
+ * comparing their columns one by one does. NormalizedComparator compares keys so, without deserializing a Value per
+ * column or dispatching on its type.
+ *
+ * Every type sorts its nulls first:
+ * - Integers and booleans are stored big-endian with the sign bit flipped. Their null is the smallest value.
+ * - Decimals are stored big-endian, with the sign bit flipped if positive and every bit flipped if negative. Their
+ *   null is the lowest double.
+ * - Timestamps are stored big-endian plus one, which wraps their null (the largest value) around to zero.
+ * - Varchars start with a byte that is 0 for null and 1 otherwise, then their bytes with every 0 escaped as 0 0xFF,
+ *   then 0 0, so that a string sorts before the longer strings it is a prefix of.
+ *
+ * The rest of the key is zero. Setting a key that does not fit in KeySize bytes throws.
+ */
+template <size_t KeySize>
+class NormalizedKey {
+ public:
+  inline void SetFromKey(const Tuple &tuple, const Schema &schema) {
+    memset(data_, 0, KeySize);
+    size_t offset = 0;
+    for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+      Encode(tuple.GetValue(&schema, i), &offset);
+    }
+  }
+
+  // NOTE: for test purpose only
+  // a key of one BIGINT column, or one INTEGER column for keys of less than 8 bytes
+  inline void SetFromInteger(int64_t key) {
+    memset(data_, 0, KeySize);
+    size_t offset = 0;
+    if constexpr (KeySize >= sizeof(int64_t)) {
+      Encode(Value(TypeId::BIGINT, key), &offset);
+    } else {
+      Encode(Value(TypeId::INTEGER, static_cast<int32_t>(key)), &offset);
+    }
+  }
+
+  inline auto ToValue(Schema *schema, uint32_t column_idx) const -> Value {
+    size_t offset = 0;
+    for (uint32_t i = 0; i < column_idx; i++) {
+      Decode(schema->GetColumn(i).GetType(), &offset);
+    }
+    return Decode(schema->GetColumn(column_idx).GetType(), &offset);
+  }
+
+  // NOTE: for test purpose only
+  // decode the key as SetFromInteger() encodes it
+  inline auto ToString() const -> int64_t {
+    size_t offset = 0;
+    if constexpr (KeySize >= sizeof(int64_t)) {
+      return Decode(TypeId::BIGINT, &offset).template GetAs<int64_t>();
+    } else {
+      return Decode(TypeId::INTEGER, &offset).template GetAs<int32_t>();
+    }
+  }
+
+  // NOTE: for test purpose only
+  friend auto operator<<(std::ostream &os, const NormalizedKey &key) -> std::ostream & {
+    os << key.ToString();
+    return os;
+  }
+
+  // actual location of data, extends past the end.
+  char data_[KeySize];
+
+ private:
+  inline void Put(uint8_t byte, size_t *offset) {
+    if (*offset == KeySize) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "NormalizedKey: key longer than " + std::to_string(KeySize));
+    }
+    data_[(*offset)++] = static_cast<char>(byte);
+  }
+
+  inline void PutBigEndian(uint64_t bits, size_t size, size_t *offset) {
+    for (size_t i = size; i > 0; i--) {
+      Put(static_cast<uint8_t>(bits >> ((i - 1) * 8)), offset);
+    }
+  }
+
+  inline auto Get(size_t *offset) const -> uint8_t {
+    return *offset == KeySize ? 0 : static_cast<uint8_t>(data_[(*offset)++]);
+  }
+
+  inline auto GetBigEndian(size_t size, size_t *offset) const -> uint64_t {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < size; i++) {
+      bits = (bits << 8) | Get(offset);
+    }
+    return bits;
+  }
+
+  inline void Encode(const Value &value, size_t *offset) {
+    switch (value.GetTypeId()) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        PutBigEndian(static_cast<uint8_t>(value.GetAs<int8_t>()) ^ 0x80U, 1, offset);
+        break;
+      case TypeId::SMALLINT:
+        PutBigEndian(static_cast<uint16_t>(value.GetAs<int16_t>()) ^ 0x8000U, 2, offset);
+        break;
+      case TypeId::INTEGER:
+        PutBigEndian(static_cast<uint32_t>(value.GetAs<int32_t>()) ^ 0x80000000U, 4, offset);
+        break;
+      case TypeId::BIGINT:
+        PutBigEndian(static_cast<uint64_t>(value.GetAs<int64_t>()) ^ (1ULL << 63), 8, offset);
+        break;
+      case TypeId::DECIMAL: {
+        // -0.0 equals 0.0, so it has to encode the same.
+        double d = value.GetAs<double>() == 0 ? 0 : value.GetAs<double>();
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof(bits));
+        PutBigEndian((bits >> 63) != 0 ? ~bits : bits ^ (1ULL << 63), 8, offset);
+        break;
+      }
+      case TypeId::TIMESTAMP:
+        PutBigEndian(value.GetAs<uint64_t>() + 1, 8, offset);
+        break;
+      case TypeId::VARCHAR: {
+        if (value.IsNull()) {
+          Put(0, offset);
+          break;
+        }
+        Put(1, offset);
+        const char *bytes = value.GetData();
+        for (uint32_t i = 0; i + 1 < value.GetLength(); i++) {
+          Put(bytes[i], offset);
+          if (bytes[i] == 0) {
+            Put(0xFF, offset);
+          }
+        }
+        Put(0, offset);
+        Put(0, offset);
+        break;
+      }
+      default:
+        throw Exception(ExceptionType::MISMATCH_TYPE, "NormalizedKey: type cannot be indexed");
+    }
+  }
+
+  inline auto Decode(TypeId type, size_t *offset) const -> Value {
+    switch (type) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        return {type, static_cast<int8_t>(GetBigEndian(1, offset) ^ 0x80U)};
+      case TypeId::SMALLINT:
+        return {type, static_cast<int16_t>(GetBigEndian(2, offset) ^ 0x8000U)};
+      case TypeId::INTEGER:
+        return {type, static_cast<int32_t>(GetBigEndian(4, offset) ^ 0x80000000U)};
+      case TypeId::BIGINT:
+        return {type, static_cast<int64_t>(GetBigEndian(8, offset) ^ (1ULL << 63))};
+      case TypeId::DECIMAL: {
+        uint64_t bits = GetBigEndian(8, offset);
+        bits = (bits >> 63) != 0 ? bits ^ (1ULL << 63) : ~bits;
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        return {type, d};
+      }
+      case TypeId::TIMESTAMP:
+        return {type, GetBigEndian(8, offset) - 1};
+      case TypeId::VARCHAR: {
+        if (Get(offset) == 0) {
+          return {type, nullptr, 0, false};
+        }
+        std::string str;
+        while (true) {
+          uint8_t byte = Get(offset);
+          if (byte == 0 && Get(offset) == 0) {
+            break;
+          }
+          str.push_back(static_cast<char>(byte));
+        }
+        return {type, str};
+      }
+      default:
+        throw Exception(ExceptionType::MISMATCH_TYPE, "NormalizedKey: type cannot be indexed");
+    }
+  }
+};
+
+/**
+ * Function object that compares normalized keys byte by byte.
+ */
+template <size_t KeySize>
+class NormalizedComparator {
+ public:
+  inline auto operator()(const NormalizedKey<KeySize> &lhs, const NormalizedKey<KeySize> &rhs) const -> int {
+    int cmp = memcmp(lhs.data_, rhs.data_, KeySize);
+    return cmp < 0 ? -1 : (cmp > 0 ? 1 : 0);
+  }
+
+  // The keys carry their order, so the schema is not needed.
+  explicit NormalizedComparator(Schema *key_schema) {}
+};
+
+/** Comparators whose keys are ordered as memcmp() orders their bytes, so that pages may compare the bytes directly. */
+template <typename KeyComparator>
+struct IsBinaryComparable : std::false_type {};
+
+template <size_t KeySize>
+struct IsBinaryComparable<NormalizedComparator<KeySize>> : std::true_type {};
+
+}  // namespace bustub
@@ -41,6 +41,27 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   auto KeyAt(int index) const -> KeyType;
   void SetKeyAt(int index, const KeyType &key);
   auto ValueAt(int index) const -> ValueType;
+  void SetValueAt(int index, const ValueType &value);
+
+  // @return the index of the child pointer value, or -1 if this page does not point to it
+  auto ValueIndex(const ValueType &value) const -> int;
+  // @return the child pointer whose subtree covers key
+  auto Lookup(const KeyType &key, const KeyComparator &comparator) const -> ValueType;
+
+  // insertion
+  void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
+  // Insert new_key/new_value right after old_value into a page that is not full. Returns the new size.
+  auto InsertNodeAfter(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value) -> int;
+  // Insert new_key/new_value right after old_value into a full page and move the upper half of the entries to an
+  // empty recipient. Returns the key that separates the two pages, which moves up to their parent.
+  auto InsertAndSplit(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value,
+                      BPlusTreeInternalPage *recipient) -> KeyType;
+
+  // deletion; middle_key is the key in the parent that separates this page from recipient
+  void Remove(int index);
+  void MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key);
+  void MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key);
+  void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key);
 
  private:
   // Flexible array member for page data.
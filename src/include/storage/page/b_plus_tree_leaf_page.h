@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -18,26 +19,47 @@
 namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 28
-#define LEAF_PAGE_SIZE ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
+#define LEAF_PAGE_HEADER_SIZE 40
+// The most entries a leaf can hold, all with keys of zero bytes.
+#define LEAF_PAGE_SIZE ((BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (sizeof(ValueType) + 2 * sizeof(uint16_t)))
 
 /**
  * Store indexed key and record id(record id = page id combined with slot id,
  * see include/common/rid.h for detailed implementation) together within leaf
- * page. Only support unique key.
+ * page. Keys are unique within the tree; in a tree that allows duplicate keys,
+ * the value of a key with several values refers to its posting list (see
+ * b_plus_tree_posting_page.h).
  *
- * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ * Keys are variable-length: a key is stored without the zero bytes that pad
+ * it to sizeof(KeyType), and without the prefix that all keys of the page
+ * share, which is stored once. Slots of fixed size grow from the header and
+ * hold the values and where the rest of each key is; the key bytes grow from
+ * the end of the page.
  *
- *  Header format (size in byte, 28 bytes in total):
+ * Leaf page format (slots are stored in key order):
+ *  --------------------------------------------------------------------------
+ * | HEADER | SLOT(1) | SLOT(2) | ... | SLOT(n) | FREE | KEY BYTES | PREFIX |
+ *  --------------------------------------------------------------------------
+ *
+ *  Slot format: | KeyOffset (2) | KeyLength (2) | RID (8) |
+ *
+ *  Header format (size in byte, 40 bytes in total):
  *  ---------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * | ParentPageId (4) | PageId (4) | NextPageId (4)
- *  -----------------------------------------------
+ *  ---------------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | NextPageId (4) | PrefixLength (2) |
+ *  ---------------------------------------------------------------------
+ *  -----------------------------------------------------
+ * | PrefixOffset (2) | FreeEnd (4) | KeyBytes (4) |
+ *  -----------------------------------------------------
+ *
+ * Whether a page is full or underflows depends on its bytes as well as on its
+ * size: a page splits when a key does not fit, or when it reaches its max
+ * size, and underflows when it is under its min size and uses less than a
+ * quarter of a page. Space is counted uncompressed (the "logical" size) as well:
+ * a page never holds more than a split can share out between two pages
+ * without prefix compression.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
@@ -49,10 +71,80 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   auto GetNextPageId() const -> page_id_t;
   void SetNextPageId(page_id_t next_page_id);
   auto KeyAt(int index) const -> KeyType;
+  auto ValueAt(int index) const -> ValueType;
+  void SetValueAt(int index, const ValueType &value);
+  auto GetItem(int index) const -> MappingType;
+  // @return the index of the first key not less than key, or GetSize() if there is none
+  auto KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int;
+  // @return the index of key, or -1 if it is not in the page
+  auto FindKey(const KeyType &key, const KeyComparator &comparator) const -> int;
+  // @return the bytes the page uses, header included
+  auto GetUsedBytes() const -> size_t;
+  // @return the length of the prefix that the keys of the page share
+  auto GetPrefixLength() const -> size_t { return prefix_length_; }
+
+  // size checks
+  // @return true if key can be inserted without a split, filling at most fill_factor of the page
+  auto CanInsert(const KeyType &key, double fill_factor = 1.0) const -> bool;
+  // @return true if the page is under both its min size and its min bytes
+  auto IsUnderflow() const -> bool;
+  // @return true if the page underflows once the entry at index is removed
+  auto UnderflowsWithout(int index) const -> bool;
+  // @return true if the entries of both pages fit in one
+  auto CanMergeWith(const BPlusTreeLeafPage *other) const -> bool;
+
+  // insert and delete methods
+  // Insert a key that is not in the page yet into a page that has room for it. Returns the new size.
+  auto Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) -> int;
+  auto Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const -> bool;
+  // Returns the new size, which is unchanged if the key was not in the page.
+  auto RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) -> int;
+
+  // Split and Merge utility methods
+  // Insert a key that does not fit, moving the upper entries to recipient.
+  void InsertAndSplit(const KeyType &key, const ValueType &value, const KeyComparator &comparator,
+                      BPlusTreeLeafPage *recipient);
+  void MoveAllTo(BPlusTreeLeafPage *recipient);
+  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
+  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
 
  private:
+  struct Slot {
+    uint16_t offset_;
+    uint16_t length_;
+    ValueType value_;
+  };
+
+  static_assert(BUSTUB_PAGE_SIZE <= (1 << 16), "key offsets of leaf pages are 16 bits");
+
+  static constexpr size_t SLOT_SIZE = sizeof(Slot);
+  static constexpr size_t MAX_ENTRY_SIZE = SLOT_SIZE + sizeof(KeyType);
+  // Logical bytes a page may hold: either half of a split fits in a page even without prefix compression.
+  static constexpr size_t LOGICAL_CAPACITY = 2 * (BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) - 3 * MAX_ENTRY_SIZE;
+  // A page under its min size underflows below these logical bytes. A sibling that the page cannot merge with has
+  // enough bytes to lend it this many and still stay above them.
+  static constexpr size_t MIN_LOGICAL_BYTES = (BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE - MAX_ENTRY_SIZE) / 4;
+
+  auto Data() const -> const char * { return reinterpret_cast<const char *>(this); }
+  auto Data() -> char * { return reinterpret_cast<char *>(this); }
+  auto LogicalSize() const -> size_t { return GetSize() * SLOT_SIZE + key_bytes_; }
+  // Compare the key at index with a key of length significant bytes that starts with the prefix of the page.
+  auto CompareSuffix(int index, const char *key, size_t length) const -> int;
+  // @return true if the entries fit in one page
+  auto Fits(const MappingType *items, size_t count) const -> bool;
+  // Insert at index, compacting the key bytes or shortening the prefix if needed.
+  void InsertAt(int index, const KeyType &key, const ValueType &value);
+  void RemoveAt(int index);
+  auto Items() const -> std::vector<MappingType>;
+  // Lay the page out anew with the entries, which must fit.
+  void Rebuild(const MappingType *items, size_t count);
+
   page_id_t next_page_id_;
+  uint16_t prefix_length_;
+  uint16_t prefix_offset_;
+  uint32_t free_end_;
+  uint32_t key_bytes_;
   // Flexible array member for page data.
-  MappingType array_[1];
+  Slot slots_[1];
 };
 }  // namespace bustub
@@ -0,0 +1,74 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_posting_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_posting_page.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include "common/config.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+#define POSTING_PAGE_HEADER_SIZE 8
+
+/**
+ * In a B+ tree that allows duplicate keys, the values of a key that has more than one are kept in a posting list: a
+ * chain of posting pages, which the leaf entry of the key refers to in place of a value (see PostingListRef()). New
+ * values go to the first page of the chain, and a new page is put in front of it when it is full, so every page but
+ * the first is full. Posting pages are only reached through the entry of their key, so the latch of the leaf covers
+ * them as well.
+ *
+ * Posting page format:
+ *  ---------------------------------------------------------------------
+ * | NextPageId (4) | CurrentSize (4) | VALUE(1) | VALUE(2) | ... | VALUE(n)
+ *  ---------------------------------------------------------------------
+ */
+template <typename ValueType>
+class BPlusTreePostingPage {
+ public:
+  static constexpr int CAPACITY = (BUSTUB_PAGE_SIZE - POSTING_PAGE_HEADER_SIZE) / sizeof(ValueType);
+
+  // After creating a new posting page from buffer pool, must call initialize method to set default values
+  void Init(page_id_t next_page_id = INVALID_PAGE_ID);
+
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+  auto GetSize() const -> int { return size_; }
+  auto IsFull() const -> bool { return size_ == CAPACITY; }
+
+  auto ValueAt(int index) const -> ValueType { return array_[index]; }
+  void SetValueAt(int index, const ValueType &value) { array_[index] = value; }
+
+  // Add a value to a page that is not full.
+  void Append(const ValueType &value);
+  // Remove the last value and return it.
+  auto PopBack() -> ValueType;
+  // @return the index of value in the page, or -1 if it is not there
+  auto IndexOf(const ValueType &value) const -> int;
+
+ private:
+  page_id_t next_page_id_;
+  int size_;
+  // Flexible array member for page data.
+  ValueType array_[1];
+};
+
+/**
+ * The page id that marks a leaf value as a reference to a posting list, with the page id of the first page of the
+ * list in its slot number. Values stored in a tree that allows duplicate keys must not have it.
+ */
+static constexpr page_id_t POSTING_LIST_PAGE_ID = -2;
+
+inline auto IsPostingListRef(const RID &value) -> bool { return value.GetPageId() == POSTING_LIST_PAGE_ID; }
+
+inline auto PostingListRef(page_id_t page_id) -> RID { return {POSTING_LIST_PAGE_ID, static_cast<uint32_t>(page_id)}; }
+
+inline auto PostingListPageId(const RID &ref) -> page_id_t { return static_cast<page_id_t>(ref.GetSlotNum()); }
+
+}  // namespace bustub
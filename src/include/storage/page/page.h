@@ -12,10 +12,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 
 #include "common/config.h"
+#include "common/macros.h"
 #include "common/rwlatch.h"
 
 namespace bustub {
@@ -30,27 +32,45 @@ class Page {
   friend class BufferPoolManagerInstance;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. Allocates zeroed page data of its own. */
+  Page() : data_(new char[BUSTUB_PAGE_SIZE]{}), owns_data_(true) {}
 
-  /** Default destructor. */
-  ~Page() = default;
+  /**
+   * Constructor for a buffer pool frame, whose data lives in the frame arena of the buffer pool.
+   * @param data zeroed page data, which must outlive the page
+   */
+  explicit Page(char *data) : data_(data) {}
+
+  /** Destructor. Frees the page data if the page allocated it. */
+  ~Page() {
+    if (owns_data_) {
+      delete[] data_;
+    }
+  }
+
+  DISALLOW_COPY_AND_MOVE(Page);
 
   /** @return the actual data contained within this page */
   inline auto GetData() -> char * { return data_; }
 
+  /** @return the actual data contained within this page */
+  inline auto GetData() const -> const char * { return data_; }
+
   /** @return the page id of this page */
-  inline auto GetPageId() -> page_id_t { return page_id_; }
+  inline auto GetPageId() const -> page_id_t { return page_id_.load(std::memory_order_acquire); }
 
   /** @return the pin count of this page */
-  inline auto GetPinCount() -> int { return pin_count_; }
+  inline auto GetPinCount() -> int { return pin_count_.load(std::memory_order_acquire); }
 
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
-  inline auto IsDirty() -> bool { return is_dirty_; }
+  inline auto IsDirty() -> bool { return is_dirty_.load(std::memory_order_acquire); }
 
   /** Acquire the page write latch. */
   inline void WLatch() { rwlatch_.WLock(); }
 
+  /** Acquire the page write latch if no one holds it. @return true if the latch was acquired */
+  inline auto TryWLatch() -> bool { return rwlatch_.TryWLock(); }
+
   /** Release the page write latch. */
   inline void WUnlatch() { rwlatch_.WUnlock(); }
 
@@ -60,6 +80,17 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Start an optimistic read of the page, without taking its latch. See OptimisticLatch for the protocol. The caller
+   * must hold a pin, so that the frame keeps the page.
+   * @param[out] version the version to pass to ValidateOptimisticRead()
+   * @return false if the page is write-latched
+   */
+  inline auto TryOptimisticRead(uint64_t *version) const -> bool { return rwlatch_.TryOptimisticRead(version); }
+
+  /** @return true if the page was not write-latched since TryOptimisticRead() returned version */
+  inline auto ValidateOptimisticRead(uint64_t version) const -> bool { return rwlatch_.Validate(version); }
+
   /** @return the page LSN. */
   inline auto GetLSN() -> lsn_t { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -79,15 +110,20 @@ class Page {
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, BUSTUB_PAGE_SIZE); }
 
   /** The actual data that is stored within a page. */
-  char data_[BUSTUB_PAGE_SIZE]{};
-  /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  char *data_;
+  /** True if data_ was allocated by the page. */
+  bool owns_data_{false};
+  /** The ID of this page. Read without the buffer pool latch on the hit path, so it is atomic. */
+  std::atomic<page_id_t> page_id_ = INVALID_PAGE_ID;
+  /**
+   * The pin count of this page. Pinned lock-free on the hit path; the buffer pool sets it to -1 while it owns the
+   * frame exclusively (eviction, loading, deletion), which makes concurrent lock-free pin attempts fail.
+   */
+  std::atomic<int> pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
-  /** Page latch. */
-  ReaderWriterLatch rwlatch_;
+  std::atomic<bool> is_dirty_ = false;
+  /** Page latch. Writers must take it to modify the page, which is what lets optimistic reads validate. */
+  OptimisticLatch rwlatch_;
 };
 
 }  // namespace bustub
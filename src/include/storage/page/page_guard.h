@@ -0,0 +1,203 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <type_traits>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard holds a pin on a page and unpins it when it is dropped or destroyed, marking the page dirty if it was
+ * written through AsMut(). Guards are move-only: a moved-from guard holds nothing, so a pin is released exactly once
+ * however the guard leaves scope.
+ *
+ * A guard that holds no page (because the fetch failed, or it was moved from or dropped) is not valid; only
+ * IsValid(), Drop() and assignment may be called on it.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  auto operator=(const BasicPageGuard &) -> BasicPageGuard & = delete;
+
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** Drop the page this guard holds, then take over the one of that. */
+  auto operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard &;
+
+  ~BasicPageGuard() { Drop(); }
+
+  /** Unpin the page now, rather than when the guard is destroyed. Dropping an invalid guard does nothing. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  auto IsValid() const -> bool { return page_ != nullptr; }
+
+  /** Take the read latch of the page and hand the pin over to a ReadPageGuard. This guard is left invalid. */
+  auto UpgradeRead() -> ReadPageGuard;
+
+  /** Take the write latch of the page and hand the pin over to a WritePageGuard. This guard is left invalid. */
+  auto UpgradeWrite() -> WritePageGuard;
+
+  /**
+   * Like UpgradeWrite(), without waiting: if someone holds the latch of the page, this guard keeps its pin and an
+   * invalid guard is returned.
+   */
+  auto TryUpgradeWrite() -> WritePageGuard;
+
+  /**
+   * Start an optimistic read of the page. The guard's pin keeps the page in its frame; see OptimisticLatch for the
+   * protocol.
+   * @param[out] version the version to pass to ValidateOptimisticRead()
+   * @return false if the page is write-latched
+   */
+  auto TryOptimisticRead(uint64_t *version) const -> bool { return page_->TryOptimisticRead(version); }
+
+  /** @return true if the page was not write-latched since TryOptimisticRead() returned version */
+  auto ValidateOptimisticRead(uint64_t version) const -> bool { return page_->ValidateOptimisticRead(version); }
+
+  auto PageId() const -> page_id_t { return page_->GetPageId(); }
+
+  auto GetData() const -> const char * { return page_->GetData(); }
+
+  /**
+   * @return the page as a T: the Page itself for page classes derived from Page (e.g. TablePage), its data otherwise
+   * (e.g. BPlusTreePage)
+   */
+  template <class T>
+  auto As() const -> const T * {
+    if constexpr (std::is_base_of_v<Page, T>) {
+      return static_cast<const T *>(page_);
+    } else {
+      return reinterpret_cast<const T *>(page_->GetData());
+    }
+  }
+
+  auto GetDataMut() -> char * {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  /** Like As(), for writing: the page is marked dirty when the guard is dropped. */
+  template <class T>
+  auto AsMut() -> T * {
+    is_dirty_ = true;
+    if constexpr (std::is_base_of_v<Page, T>) {
+      return static_cast<T *>(page_);
+    } else {
+      return reinterpret_cast<T *>(page_->GetData());
+    }
+  }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/** ReadPageGuard holds a pin and the read latch on a page, and releases both (latch first) when it is dropped. */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /** @param page a page the caller has pinned and read-latched, or nullptr */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  auto operator=(const ReadPageGuard &) -> ReadPageGuard & = delete;
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  /** Drop the page this guard holds, then take over the one of that. */
+  auto operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard &;
+
+  ~ReadPageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now, rather than when the guard is destroyed. */
+  void Drop();
+
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  auto PageId() const -> page_id_t { return guard_.PageId(); }
+
+  auto GetData() const -> const char * { return guard_.GetData(); }
+
+  template <class T>
+  auto As() const -> const T * {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/** WritePageGuard holds a pin and the write latch on a page, and releases both (latch first) when it is dropped. */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /** @param page a page the caller has pinned and write-latched, or nullptr */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  auto operator=(const WritePageGuard &) -> WritePageGuard & = delete;
+
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  /** Drop the page this guard holds, then take over the one of that. */
+  auto operator=(WritePageGuard &&that) noexcept -> WritePageGuard &;
+
+  ~WritePageGuard() { Drop(); }
+
+  /** Unlatch and unpin the page now, rather than when the guard is destroyed. */
+  void Drop();
+
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  auto PageId() const -> page_id_t { return guard_.PageId(); }
+
+  auto GetData() const -> const char * { return guard_.GetData(); }
+
+  template <class T>
+  auto As() const -> const T * {
+    return guard_.As<T>();
+  }
+
+  auto GetDataMut() -> char * { return guard_.GetDataMut(); }
+
+  template <class T>
+  auto AsMut() -> T * {
+    return guard_.AsMut<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
@@ -12,6 +12,9 @@
 
 #pragma once
 
+#include <mutex>  // NOLINT
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -23,6 +26,10 @@ namespace bustub {
 /**
  * TableHeap represents a physical table on disk.
  * This is just a doubly-linked list of pages.
+ *
+ * The table reserves page ids in extents of EXTENT_PAGES consecutive pages and fills each extent before reserving
+ * the next one, so that its pages are contiguous on disk rather than interleaved with those of other tables and
+ * indexes, and the read-ahead of a scan turns into sequential I/O.
  */
 class TableHeap {
   friend class TableIterator;
@@ -108,11 +115,28 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /** @return the ids of the first pages of the extents this table has reserved, in order */
+  auto GetExtents() -> std::vector<page_id_t>;
+
  private:
+  /**
+   * Create a page for the table, in its current extent if the buffer pool supports extents.
+   * @param[out] page_id id of the new page
+   * @return a guard holding the new page, or an invalid guard if no new page could be created
+   */
+  auto NewTablePage(page_id_t *page_id) -> BasicPageGuard;
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+
+  /** Protects the extents. */
+  std::mutex extent_latch_;
+  std::vector<page_id_t> extents_;
+  /** The next page of the current extent, equal to extent_end_ once the extent is full. */
+  page_id_t next_extent_page_id_{INVALID_PAGE_ID};
+  page_id_t extent_end_{INVALID_PAGE_ID};
 };
 
 }  // namespace bustub
@@ -31,14 +31,7 @@ class TableIterator {
  public:
   TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
 
-  TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
-
-  ~TableIterator() { delete tuple_; }
-
-  inline auto operator==(const TableIterator &itr) const -> bool {
-    return tuple_->rid_.Get() == itr.tuple_->rid_.Get();
-  }
+  inline auto operator==(const TableIterator &itr) const -> bool { return tuple_.rid_.Get() == itr.tuple_.rid_.Get(); }
 
   inline auto operator!=(const TableIterator &itr) const -> bool { return !(*this == itr); }
 
@@ -50,16 +43,9 @@ class TableIterator {
 
   auto operator++(int) -> TableIterator;
 
-  auto operator=(const TableIterator &other) -> TableIterator & {
-    table_heap_ = other.table_heap_;
-    *tuple_ = *other.tuple_;
-    txn_ = other.txn_;
-    return *this;
-  }
-
  private:
   TableHeap *table_heap_;
-  Tuple *tuple_;
+  Tuple tuple_;
   Transaction *txn_;
 };
 
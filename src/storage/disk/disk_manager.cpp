@@ -10,16 +10,25 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
 #include <cstring>
 #include <iostream>
 #include <mutex>  // NOLINT
+#include <shared_mutex>
 #include <string>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/util/crc32c.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
@@ -50,26 +59,82 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
   }
 
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  bool created = false;
   db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
   // directory or file does not exist
   if (!db_io_.is_open()) {
     db_io_.clear();
+    created = true;
     // create a new file
     db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
     if (!db_io_.is_open()) {
       throw Exception("can't open db file");
     }
   }
+  // The stream flushes after every write, so writes through the descriptor never race with buffered stream data.
+  db_fd_ = open(db_file.c_str(), O_RDWR);
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  try {
+    OpenChecksumFile(db_file, created, false);
+    OpenFreeSpaceMap(db_file, created);
+  } catch (Exception &e) {
+    close(db_fd_);
+    if (checksum_fd_ >= 0) {
+      close(checksum_fd_);
+    }
+    throw;
+  }
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() {
+  StopIoWorkers();
+  if (db_fd_ >= 0) {
+    {
+      std::scoped_lock scoped_db_io_latch(db_io_latch_);
+      CloseWriteQueue();
+    }
+    close(db_fd_);
+  }
+  if (checksum_fd_ >= 0) {
+    close(checksum_fd_);
+  }
+  if (fsm_fd_ >= 0) {
+    close(fsm_fd_);
+  }
+}
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
+  StopIoWorkers();
+  // Before the file is marked clean.
+  SyncFreeSpaceMap();
   {
     std::scoped_lock scoped_db_io_latch(db_io_latch_);
     db_io_.close();
+    if (db_fd_ >= 0) {
+      CloseWriteQueue();
+      close(db_fd_);
+      db_fd_ = -1;
+    }
+  }
+  {
+    std::scoped_lock lock(checksum_latch_);
+    if (checksum_fd_ >= 0) {
+      close(checksum_fd_);
+      checksum_fd_ = -1;
+    }
+  }
+  {
+    std::scoped_lock lock(fsm_latch_);
+    if (fsm_fd_ >= 0) {
+      close(fsm_fd_);
+      fsm_fd_ = -1;
+    }
   }
   log_io_.close();
 }
@@ -77,34 +142,67 @@ void DiskManager::ShutDown() {
 /**
  * Write the contents of the specified page into disk file
  */
-void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
+auto DiskManager::WritePage(page_id_t page_id, const char *page_data) -> bool {
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  if (write_combining_) {
+    auto &buffer = write_queue_[page_id];
+    if (buffer == nullptr) {
+      buffer = std::make_unique<char[]>(BUSTUB_PAGE_SIZE);
+    }
+    memcpy(buffer.get(), page_data, BUSTUB_PAGE_SIZE);
+    if (write_queue_.size() >= WRITE_COMBINE_PAGES) {
+      // Whatever cannot be written stays queued, this page included, and is tried again with the next batch.
+      WriteQueuedPages();
+    }
+    return true;
+  }
+  std::shared_lock order_lock(write_order_latch_);
+  BeginUnorderedWrite();
+  PageChecksum replaced;
+  RecordChecksums(page_id, &page_data, 1, &replaced);
+  if (db_fd_ >= 0) {
+    return WritePagesLocked(page_id, &page_data, 1, &replaced) == 1;
+  }
   size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
   // set write cursor to offset
   num_writes_ += 1;
+  stats_.RecordWrite(BUSTUB_PAGE_SIZE);
   db_io_.seekp(offset);
   db_io_.write(page_data, BUSTUB_PAGE_SIZE);
   // check for I/O error
   if (db_io_.bad()) {
     LOG_DEBUG("I/O error while writing");
-    return;
+    db_io_.clear();
+    RestoreChecksums(page_id, &replaced, 1);
+    return false;
   }
   // needs to flush to keep disk file in sync
   db_io_.flush();
+  return true;
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * BUSTUB_PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
+  {
+    std::scoped_lock scoped_db_io_latch(db_io_latch_);
+    if (auto queued = write_queue_.find(page_id); queued != write_queue_.end()) {
+      memcpy(page_data, queued->second.get(), BUSTUB_PAGE_SIZE);
+      return;
+    }
+    // 64-bit arithmetic: pages past the 2 GB mark would overflow an int offset.
+    auto offset = static_cast<int64_t>(page_id) * BUSTUB_PAGE_SIZE;
+    // check if read beyond file length
+    if (offset > GetFileSize(file_name_)) {
+      LOG_DEBUG("I/O error reading past end of file");
+      // std::cerr << "I/O error while reading" << std::endl;
+      // Pages past the end of the file, e.g. ones truncated by Compact(), read as zeros.
+      memset(page_data, 0, BUSTUB_PAGE_SIZE);
+      return;
+    }
     // set read cursor to offset
+    stats_.RecordRead(BUSTUB_PAGE_SIZE);
     db_io_.seekp(offset);
     db_io_.read(page_data, BUSTUB_PAGE_SIZE);
     if (db_io_.bad()) {
@@ -120,6 +218,641 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
       memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
     }
   }
+  VerifyChecksum(page_id, page_data);
+}
+
+/**
+ * Queue a page read to the I/O threads
+ */
+void DiskManager::ReadPageAsync(page_id_t page_id, char *page_data, std::function<void(bool)> done) {
+  {
+    std::scoped_lock lock(io_queue_latch_);
+    if (io_workers_.empty()) {
+      for (int i = 0; i < DISK_IO_WORKERS; i++) {
+        io_workers_.emplace_back(&DiskManager::RunIoWorker, this);
+      }
+    }
+    io_queue_.emplace_back([this, page_id, page_data, done = std::move(done)]() {
+      bool verified = true;
+      try {
+        ReadPage(page_id, page_data);
+      } catch (Exception &e) {
+        verified = false;
+      }
+      done(verified);
+    });
+  }
+  io_queue_cv_.notify_one();
+}
+
+void DiskManager::RunIoWorker() {
+  while (true) {
+    std::function<void()> request;
+    {
+      std::unique_lock lock(io_queue_latch_);
+      io_queue_cv_.wait(lock, [this] { return io_workers_stopping_ || !io_queue_.empty(); });
+      if (io_queue_.empty()) {
+        return;
+      }
+      request = std::move(io_queue_.front());
+      io_queue_.pop_front();
+    }
+    request();
+  }
+}
+
+void DiskManager::StopIoWorkers() {
+  std::vector<std::thread> workers;
+  {
+    std::scoped_lock lock(io_queue_latch_);
+    io_workers_stopping_ = true;
+    workers.swap(io_workers_);
+  }
+  io_queue_cv_.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  std::scoped_lock lock(io_queue_latch_);
+  io_workers_stopping_ = false;
+}
+
+/**
+ * Write a run of consecutive pages with as few vectored writes as IOV_MAX allows
+ */
+auto DiskManager::WritePages(page_id_t first_page_id, const char *const *pages_data, size_t num_pages) -> bool {
+  if (db_fd_ < 0) {
+    bool written = true;
+    for (size_t i = 0; i < num_pages; i++) {
+      written = WritePage(first_page_id + static_cast<page_id_t>(i), pages_data[i]) && written;
+    }
+    return written;
+  }
+
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  // Queued copies of these pages are older; writing them later would undo this write.
+  write_queue_.erase(write_queue_.lower_bound(first_page_id),
+                     write_queue_.lower_bound(first_page_id + static_cast<page_id_t>(num_pages)));
+  std::shared_lock order_lock(write_order_latch_);
+  BeginUnorderedWrite();
+  std::vector<PageChecksum> replaced(num_pages);
+  RecordChecksums(first_page_id, pages_data, num_pages, replaced.data());
+  return WritePagesLocked(first_page_id, pages_data, num_pages, replaced.data()) == num_pages;
+}
+
+auto DiskManager::WritePagesLocked(page_id_t first_page_id, const char *const *pages_data, size_t num_pages,
+                                   const PageChecksum *replaced) -> size_t {
+  std::vector<struct iovec> iov;
+  size_t done = 0;
+  while (done < num_pages) {
+    size_t batch = std::min<size_t>(num_pages - done, IOV_MAX);
+    iov.resize(batch);
+    for (size_t i = 0; i < batch; i++) {
+      iov[i].iov_base = const_cast<char *>(pages_data[done + i]);  // NOLINT
+      iov[i].iov_len = BUSTUB_PAGE_SIZE;
+    }
+    auto offset = static_cast<off_t>(first_page_id + done) * BUSTUB_PAGE_SIZE;
+    // pwritev may write less than asked for; continue from wherever it stopped.
+    size_t iov_index = 0;
+    while (iov_index < batch) {
+      ssize_t written = pwritev(db_fd_, iov.data() + iov_index, static_cast<int>(batch - iov_index), offset);
+      if (written < 0 && errno == EINTR) {
+        continue;
+      }
+      if (written <= 0) {
+        LOG_DEBUG("I/O error while writing");
+        // The page the write stopped in may be torn; it and the ones after it are as they were, or unreadable.
+        const size_t num_written = done + iov_index;
+        num_writes_ += static_cast<int>(num_written);
+        stats_.RecordWrite(num_written * BUSTUB_PAGE_SIZE);
+        RestoreChecksums(first_page_id + static_cast<page_id_t>(num_written), replaced + num_written,
+                         num_pages - num_written);
+        return num_written;
+      }
+      offset += written;
+      while (iov_index < batch && static_cast<size_t>(written) >= iov[iov_index].iov_len) {
+        written -= static_cast<ssize_t>(iov[iov_index].iov_len);
+        iov_index++;
+      }
+      if (iov_index < batch) {
+        iov[iov_index].iov_base = static_cast<char *>(iov[iov_index].iov_base) + written;
+        iov[iov_index].iov_len -= written;
+      }
+    }
+    done += batch;
+  }
+  num_writes_ += static_cast<int>(num_pages);
+  stats_.RecordWrite(num_pages * BUSTUB_PAGE_SIZE);
+  return num_pages;
+}
+
+/**
+ * Write the queue in runs of consecutive pages, as one batch with its checksums synced first
+ */
+auto DiskManager::WriteQueuedPages() -> bool {
+  if (write_queue_.empty() || db_fd_ < 0) {
+    return true;
+  }
+  std::vector<std::pair<page_id_t, std::vector<const char *>>> runs;
+  for (auto &[page_id, buffer] : write_queue_) {
+    if (runs.empty() || page_id != runs.back().first + static_cast<page_id_t>(runs.back().second.size())) {
+      runs.emplace_back(page_id, std::vector<const char *>());
+    }
+    runs.back().second.push_back(buffer.get());
+  }
+  std::vector<PageChecksum> replaced(write_queue_.size());
+  size_t recorded = 0;
+  for (auto &[first_page_id, run] : runs) {
+    RecordChecksums(first_page_id, run.data(), run.size(), replaced.data() + recorded);
+    recorded += run.size();
+  }
+  // With the checksums on disk first, a page the batch tears in a crash matches neither of its checksums.
+  if (checksum_fd_ >= 0 && fdatasync(checksum_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing checksums");
+    recorded = 0;
+    for (auto &[first_page_id, run] : runs) {
+      RestoreChecksums(first_page_id, replaced.data() + recorded, run.size());
+      recorded += run.size();
+    }
+    return false;
+  }
+  std::vector<size_t> num_written(runs.size());
+  bool written = true;
+  recorded = 0;
+  for (size_t i = 0; i < runs.size(); i++) {
+    auto &[first_page_id, run] = runs[i];
+    num_written[i] = WritePagesLocked(first_page_id, run.data(), run.size(), replaced.data() + recorded);
+    written = written && num_written[i] == run.size();
+    recorded += run.size();
+  }
+  // A later batch may write these pages again, and the entries only remember the version before that one.
+  if (fdatasync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+    // Whether any of the batch made it to disk is unknown, so all of it is written again with the next one.
+    return false;
+  }
+  // Pages that were not written stay queued for the next batch.
+  for (size_t i = 0; i < runs.size(); i++) {
+    for (size_t j = 0; j < num_written[i]; j++) {
+      write_queue_.erase(runs[i].first + static_cast<page_id_t>(j));
+    }
+  }
+  return written;
+}
+
+void DiskManager::SetWriteCombining(bool enabled) {
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  if (db_fd_ < 0) {
+    return;
+  }
+  if (!enabled) {
+    WriteQueuedPages();
+  }
+  write_combining_ = enabled;
+}
+
+auto DiskManager::GetNumQueuedWrites() -> size_t {
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  return write_queue_.size();
+}
+
+/**
+ * Flush the db file to stable storage
+ */
+void DiskManager::Sync() {
+  // The map goes first: a page that the map has as allocated after a crash at worst leaks, but one it has as free
+  // although the pages synced below use it would be handed out twice.
+  SyncFreeSpaceMap();
+  {
+    std::scoped_lock scoped_db_io_latch(db_io_latch_);
+    bool synced = WriteQueuedPages();
+    // Keep unordered writes out until their pages and checksums are durable, and the mark can be cleared.
+    std::unique_lock order_lock(write_order_latch_);
+    if (db_fd_ >= 0 && fsync(db_fd_) != 0) {
+      LOG_DEBUG("I/O error while syncing");
+      synced = false;
+    }
+    if (checksum_fd_ >= 0 && fsync(checksum_fd_) != 0) {
+      LOG_DEBUG("I/O error while syncing checksums");
+      synced = false;
+    }
+    if (synced && checksum_fd_ >= 0 && unordered_writes_.load()) {
+      std::scoped_lock header_lock(checksum_header_latch_);
+      if (WriteChecksumHeader(0)) {
+        unordered_writes_.store(false);
+      }
+    }
+  }
+}
+
+/**
+ * Set the bit of the page in the free-space map
+ */
+auto DiskManager::DeallocatePage(page_id_t page_id) -> bool {
+  if (page_id < 0) {
+    return false;
+  }
+  std::scoped_lock lock(db_io_latch_, fsm_latch_);
+  size_t word = static_cast<size_t>(page_id) / 64;
+  uint64_t bit = uint64_t{1} << (static_cast<size_t>(page_id) % 64);
+  if (free_pages_.size() <= word) {
+    // Grow by whole bitmap pages.
+    const size_t words_per_page = BUSTUB_PAGE_SIZE / sizeof(uint64_t);
+    free_pages_.resize((word / words_per_page + 1) * words_per_page);
+  }
+  if ((free_pages_[word] & bit) != 0) {
+    return false;
+  }
+  // A free page's data does not matter, so a queued write of it need not happen.
+  write_queue_.erase(page_id);
+  free_pages_[word] |= bit;
+  num_free_pages_++;
+  PersistFreePagesWord(word);
+  return true;
+}
+
+/**
+ * Find and clear the lowest bit of the free-space map that belongs to the instance
+ */
+auto DiskManager::AllocateFreePage(uint32_t num_instances, uint32_t instance_index) -> page_id_t {
+  std::scoped_lock lock(fsm_latch_);
+  if (num_free_pages_ == 0) {
+    return INVALID_PAGE_ID;
+  }
+  for (size_t word = 0; word < free_pages_.size(); word++) {
+    uint64_t bits = free_pages_[word];
+    while (bits != 0) {
+      auto bit = static_cast<size_t>(__builtin_ctzll(bits));
+      bits &= bits - 1;
+      auto page_id = static_cast<page_id_t>(word * 64 + bit);
+      if (static_cast<uint32_t>(page_id) % num_instances == instance_index) {
+        free_pages_[word] &= ~(uint64_t{1} << bit);
+        num_free_pages_--;
+        PersistFreePagesWord(word);
+        return page_id;
+      }
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+auto DiskManager::IsFreePage(page_id_t page_id) -> bool {
+  std::scoped_lock lock(fsm_latch_);
+  auto word = static_cast<size_t>(page_id) / 64;
+  return page_id >= 0 && word < free_pages_.size() &&
+         (free_pages_[word] & (uint64_t{1} << (static_cast<size_t>(page_id) % 64))) != 0;
+}
+
+auto DiskManager::GetNumFreePages() -> size_t {
+  std::scoped_lock lock(fsm_latch_);
+  return num_free_pages_;
+}
+
+/**
+ * Truncate the free pages at the end of the db file
+ */
+auto DiskManager::Compact() -> size_t {
+  // Holding fsm_latch_ keeps the pages at the end free until the file is truncated.
+  std::scoped_lock lock(db_io_latch_, fsm_latch_);
+  if (db_fd_ < 0) {
+    return 0;
+  }
+  // Queued pages may lie past the end of the file, and must not be written after it is truncated.
+  if (!WriteQueuedPages()) {
+    return 0;
+  }
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) != 0) {
+    return 0;
+  }
+  auto num_pages = (static_cast<size_t>(stat_buf.st_size) + BUSTUB_PAGE_SIZE - 1) / BUSTUB_PAGE_SIZE;
+  auto is_free = [this](size_t page_id) {
+    return page_id / 64 < free_pages_.size() && (free_pages_[page_id / 64] & (uint64_t{1} << (page_id % 64))) != 0;
+  };
+  size_t new_num_pages = num_pages;
+  while (new_num_pages > 0 && is_free(new_num_pages - 1)) {
+    new_num_pages--;
+  }
+  if (new_num_pages == num_pages) {
+    return 0;
+  }
+  if (ftruncate(db_fd_, static_cast<off_t>(new_num_pages * BUSTUB_PAGE_SIZE)) != 0) {
+    LOG_DEBUG("I/O error while truncating db file");
+    return 0;
+  }
+  // A page past the end of the file reads as zeros, which must not be checked against the checksum of its old data.
+  std::scoped_lock checksum_lock(checksum_latch_);
+  if (checksums_.size() > new_num_pages) {
+    checksums_.resize(new_num_pages);
+    auto checksum_size = static_cast<off_t>((new_num_pages + 1) * sizeof(PageChecksum));
+    if (checksum_fd_ >= 0 && ftruncate(checksum_fd_, checksum_size) != 0) {
+      LOG_DEBUG("I/O error while truncating checksum file");
+    }
+  }
+  return num_pages - new_num_pages;
+}
+
+/**
+ * Open the free-space map that belongs to db_file and load it
+ */
+void DiskManager::OpenFreeSpaceMap(const std::string &db_file, bool truncate) {
+  fsm_name_ = SidecarFileName(db_file, ".fsm");
+  fsm_fd_ = open(fsm_name_.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+  if (fsm_fd_ < 0) {
+    throw Exception("can't open free-space map");
+  }
+  struct stat stat_buf;
+  if (fstat(fsm_fd_, &stat_buf) != 0) {
+    throw Exception("can't stat free-space map");
+  }
+  free_pages_.resize(static_cast<size_t>(stat_buf.st_size) / sizeof(uint64_t));
+  size_t bytes = free_pages_.size() * sizeof(uint64_t);
+  size_t done = 0;
+  while (done < bytes) {
+    ssize_t res = pread(fsm_fd_, reinterpret_cast<char *>(free_pages_.data()) + done, bytes - done, done);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      throw Exception("can't read free-space map");
+    }
+    done += res;
+  }
+  num_free_pages_ = 0;
+  for (auto word : free_pages_) {
+    num_free_pages_ += __builtin_popcountll(word);
+  }
+}
+
+void DiskManager::SyncFreeSpaceMap() {
+  std::scoped_lock lock(fsm_latch_);
+  if (fsm_fd_ >= 0 && fsync(fsm_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing the free-space map");
+  }
+}
+
+void DiskManager::PersistFreePagesWord(size_t word) {
+  if (fsm_fd_ < 0) {
+    return;
+  }
+  auto offset = static_cast<off_t>(word * sizeof(uint64_t));
+  if (pwrite(fsm_fd_, &free_pages_[word], sizeof(uint64_t), offset) != static_cast<ssize_t>(sizeof(uint64_t))) {
+    LOG_DEBUG("I/O error while writing the free-space map");
+  }
+}
+
+void DiskManager::RemoveSidecarFiles(const std::string &db_file) {
+  remove(SidecarFileName(db_file, ".crc").c_str());
+  remove(SidecarFileName(db_file, ".fsm").c_str());
+}
+
+auto DiskManager::SidecarFileName(const std::string &db_file, const char *extension) -> std::string {
+  std::string::size_type n = db_file.rfind('.');
+  return (n == std::string::npos ? db_file : db_file.substr(0, n)) + extension;
+}
+
+/**
+ * Open the checksum file that belongs to db_file and load it
+ */
+void DiskManager::OpenChecksumFile(const std::string &db_file, bool truncate, bool read_only) {
+  checksum_name_ = SidecarFileName(db_file, ".crc");
+  int flags = read_only ? O_RDONLY : O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0);
+  checksum_fd_ = open(checksum_name_.c_str(), flags, 0644);
+  if (checksum_fd_ < 0) {
+    if (!read_only) {
+      throw Exception("can't open checksum file");
+    }
+    // A read-only database without checksums is not verified.
+    return;
+  }
+  struct stat stat_buf;
+  if (fstat(checksum_fd_, &stat_buf) != 0) {
+    throw Exception("can't stat checksum file");
+  }
+  // The first entry records the page size the database was created with.
+  size_t num_entries = static_cast<size_t>(stat_buf.st_size) / sizeof(PageChecksum);
+  if (num_entries == 0) {
+    if (!read_only && !WriteChecksumHeader(0)) {
+      throw Exception("can't write checksum file");
+    }
+    return;
+  }
+  std::vector<PageChecksum> entries(num_entries);
+  size_t bytes = num_entries * sizeof(PageChecksum);
+  size_t done = 0;
+  while (done < bytes) {
+    ssize_t res = pread(checksum_fd_, reinterpret_cast<char *>(entries.data()) + done, bytes - done, done);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      throw Exception("can't read checksum file");
+    }
+    done += res;
+  }
+  if (entries[0].magic_ != CHECKSUM_FILE_MAGIC) {
+    close(checksum_fd_);
+    checksum_fd_ = -1;
+    throw Exception(ExceptionType::CORRUPTION, checksum_name_ + " is not a checksum file, or one of an older format");
+  }
+  if (entries[0].checksum_ != static_cast<uint32_t>(BUSTUB_PAGE_SIZE)) {
+    close(checksum_fd_);
+    checksum_fd_ = -1;
+    throw Exception(ExceptionType::MISMATCH_TYPE, db_file + " was created with " + std::to_string(entries[0].checksum_) +
+                                                      "-byte pages, but pages are " +
+                                                      std::to_string(BUSTUB_PAGE_SIZE) + " bytes");
+  }
+  checksums_.assign(entries.begin() + 1, entries.end());
+  if (read_only) {
+    return;
+  }
+  std::scoped_lock lock(checksum_latch_);
+  if (entries[0].previous_magic_ != CHECKSUM_CLEAN_MAGIC) {
+    ResolveChecksums(entries[0].previous_magic_ == CHECKSUM_UNORDERED_MAGIC);
+  }
+  // Until the database is shut down cleanly, the header says it was not.
+  if (!WriteChecksumHeader(0)) {
+    throw Exception("can't write checksum file");
+  }
+}
+
+/**
+ * Read every page that has a checksum and keep the checksum of the version it holds
+ */
+void DiskManager::ResolveChecksums(bool unordered) {
+  int fd = open(file_name_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  auto page = std::make_unique<char[]>(BUSTUB_PAGE_SIZE);
+  for (size_t page_id = 0; page_id < checksums_.size(); page_id++) {
+    auto &entry = checksums_[page_id];
+    if (entry.magic_ != CHECKSUM_MAGIC) {
+      continue;
+    }
+    // Pages past the end of the file read as zeros.
+    memset(page.get(), 0, BUSTUB_PAGE_SIZE);
+    auto offset = static_cast<off_t>(page_id) * BUSTUB_PAGE_SIZE;
+    size_t done = 0;
+    while (done < BUSTUB_PAGE_SIZE) {
+      ssize_t res = pread(fd, page.get() + done, BUSTUB_PAGE_SIZE - done, offset + static_cast<off_t>(done));
+      if (res < 0 && errno == EINTR) {
+        continue;
+      }
+      if (res <= 0) {
+        break;
+      }
+      done += res;
+    }
+    uint32_t checksum = Crc32c::Compute(page.get(), BUSTUB_PAGE_SIZE);
+    if (checksum == entry.checksum_) {
+      entry.previous_magic_ = 0;
+    } else if (entry.previous_magic_ == CHECKSUM_MAGIC && checksum == entry.previous_checksum_) {
+      entry.checksum_ = entry.previous_checksum_;
+      entry.previous_magic_ = 0;
+    } else if (std::all_of(page.get(), page.get() + BUSTUB_PAGE_SIZE, [](char c) { return c == 0; })) {
+      // The first write of the page never made it to disk.
+      entry = PageChecksum{0, 0, 0, 0};
+    } else if (unordered) {
+      // The page may have been written after the last sync while its checksum never made it to disk.
+      LOG_WARN("page %zu matches neither of its checksums after a crash, taking it as it is", page_id);
+      entry = PageChecksum{checksum, CHECKSUM_MAGIC, 0, 0};
+    }
+    // Otherwise the page is torn, and reading it reports so.
+  }
+  close(fd);
+  PersistChecksums(0, checksums_.size());
+}
+
+void DiskManager::CloseWriteQueue() {
+  if (!WriteQueuedPages()) {
+    LOG_WARN("%zu queued page writes failed at shutdown", write_queue_.size());
+    return;
+  }
+  MarkCleanShutdown();
+}
+
+void DiskManager::MarkCleanShutdown() {
+  if (checksum_fd_ < 0) {
+    return;
+  }
+  std::unique_lock order_lock(write_order_latch_);
+  if (fdatasync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing");
+    return;
+  }
+  // Syncing the header syncs the entries written before it.
+  std::scoped_lock header_lock(checksum_header_latch_);
+  if (!WriteChecksumHeader(CHECKSUM_CLEAN_MAGIC)) {
+    LOG_DEBUG("I/O error while writing checksums");
+  }
+}
+
+auto DiskManager::WriteChecksumHeader(uint32_t state_magic) -> bool {
+  const PageChecksum header{static_cast<uint32_t>(BUSTUB_PAGE_SIZE), CHECKSUM_FILE_MAGIC, 0, state_magic};
+  return pwrite(checksum_fd_, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+         fdatasync(checksum_fd_) == 0;
+}
+
+void DiskManager::BeginUnorderedWrite() {
+  if (unordered_writes_.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::scoped_lock lock(checksum_header_latch_);
+  if (checksum_fd_ < 0 || unordered_writes_.load()) {
+    return;
+  }
+  if (!WriteChecksumHeader(CHECKSUM_UNORDERED_MAGIC)) {
+    LOG_DEBUG("I/O error while writing checksums");
+  }
+  unordered_writes_.store(true, std::memory_order_release);
+}
+
+/**
+ * Record the checksums of the pages in memory and in the checksum file, keeping the checksums they replace
+ */
+void DiskManager::RecordChecksums(page_id_t first_page_id, const char *const *pages_data, size_t num_pages,
+                                  PageChecksum *replaced) {
+  std::vector<uint32_t> checksums(num_pages);
+  for (size_t i = 0; i < num_pages; i++) {
+    checksums[i] = Crc32c::Compute(pages_data[i], BUSTUB_PAGE_SIZE);
+  }
+
+  std::scoped_lock lock(checksum_latch_);
+  auto first = static_cast<size_t>(first_page_id);
+  if (checksums_.size() < first + num_pages) {
+    checksums_.resize(first + num_pages);
+  }
+  for (size_t i = 0; i < num_pages; i++) {
+    auto &entry = checksums_[first + i];
+    if (replaced != nullptr) {
+      replaced[i] = entry;
+    }
+    if (entry.magic_ == CHECKSUM_MAGIC && entry.checksum_ != checksums[i]) {
+      entry.previous_checksum_ = entry.checksum_;
+      entry.previous_magic_ = CHECKSUM_MAGIC;
+    }
+    entry.checksum_ = checksums[i];
+    entry.magic_ = CHECKSUM_MAGIC;
+  }
+  // The file is written under the latch as well, so that it ends up with the same entries as memory.
+  PersistChecksums(first, num_pages);
+}
+
+void DiskManager::RestoreChecksums(page_id_t first_page_id, const PageChecksum *entries, size_t num_pages) {
+  std::scoped_lock lock(checksum_latch_);
+  auto first = static_cast<size_t>(first_page_id);
+  // Compact() may have cut the entries off in the meantime, along with the pages.
+  if (first >= checksums_.size()) {
+    return;
+  }
+  num_pages = std::min(num_pages, checksums_.size() - first);
+  std::copy(entries, entries + num_pages, checksums_.begin() + first);
+  PersistChecksums(first, num_pages);
+}
+
+void DiskManager::PersistChecksums(size_t first, size_t num_pages) {
+  if (checksum_fd_ < 0) {
+    return;
+  }
+  const auto *data = reinterpret_cast<const char *>(checksums_.data() + first);
+  size_t bytes = num_pages * sizeof(PageChecksum);
+  auto offset = static_cast<off_t>((first + 1) * sizeof(PageChecksum));
+  size_t done = 0;
+  while (done < bytes) {
+    ssize_t res = pwrite(checksum_fd_, data + done, bytes - done, offset + done);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      LOG_DEBUG("I/O error while writing checksums");
+      break;
+    }
+    done += res;
+  }
+}
+
+auto DiskManager::ChecksumMatches(page_id_t page_id, const char *page_data) -> bool {
+  if (!verify_page_checksums.load(std::memory_order_relaxed)) {
+    return true;
+  }
+  PageChecksum entry{0, 0, 0, 0};
+  {
+    std::scoped_lock lock(checksum_latch_);
+    if (page_id >= 0 && static_cast<size_t>(page_id) < checksums_.size()) {
+      entry = checksums_[page_id];
+    }
+  }
+  if (entry.magic_ != CHECKSUM_MAGIC) {
+    return true;
+  }
+  uint32_t checksum = Crc32c::Compute(page_data, BUSTUB_PAGE_SIZE);
+  return checksum == entry.checksum_ || (entry.previous_magic_ == CHECKSUM_MAGIC && checksum == entry.previous_checksum_);
+}
+
+void DiskManager::VerifyChecksum(page_id_t page_id, const char *page_data) {
+  if (!ChecksumMatches(page_id, page_data)) {
+    throw Exception(ExceptionType::CORRUPTION, "page " + std::to_string(page_id) + " does not match its checksum");
+  }
 }
 
 /**
@@ -161,7 +894,7 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-auto DiskManager::ReadLog(char *log_data, int size, int offset) -> bool {
+auto DiskManager::ReadLog(char *log_data, int size, int64_t offset) -> bool {
   if (offset >= GetFileSize(log_name_)) {
     // LOG_DEBUG("end of log file");
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
@@ -202,10 +935,10 @@ auto DiskManager::GetFlushState() const -> bool { return flush_log_; }
 /**
  * Private helper function to get disk file size
  */
-auto DiskManager::GetFileSize(const std::string &file_name) -> int {
+auto DiskManager::GetFileSize(const std::string &file_name) -> int64_t {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+  return rc == 0 ? static_cast<int64_t>(stat_buf.st_size) : -1;
 }
 
 }  // namespace bustub
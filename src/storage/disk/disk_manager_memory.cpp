@@ -12,6 +12,10 @@
 
 #include "storage/disk/disk_manager_memory.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <cassert>
 #include <cstddef>
 #include <cstring>
@@ -32,11 +36,13 @@ DiskManagerMemory::DiskManagerMemory(size_t pages) { memory_ = new char[pages *
 /**
  * Write the contents of the specified page into disk file
  */
-void DiskManagerMemory::WritePage(page_id_t page_id, const char *page_data) {
+auto DiskManagerMemory::WritePage(page_id_t page_id, const char *page_data) -> bool {
   size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
   // set write cursor to offset
   num_writes_ += 1;
+  stats_.RecordWrite(BUSTUB_PAGE_SIZE);
   memcpy(memory_ + offset, page_data, BUSTUB_PAGE_SIZE);
+  return true;
 }
 
 /**
@@ -44,7 +50,86 @@ void DiskManagerMemory::WritePage(page_id_t page_id, const char *page_data) {
  */
 void DiskManagerMemory::ReadPage(page_id_t page_id, char *page_data) {
   int64_t offset = static_cast<int64_t>(page_id) * BUSTUB_PAGE_SIZE;
+  stats_.RecordRead(BUSTUB_PAGE_SIZE);
   memcpy(page_data, memory_ + offset, BUSTUB_PAGE_SIZE);
 }
 
+/**
+ * Constructor: map the whole db file read-only
+ */
+DiskManagerMmap::DiskManagerMmap(const std::string &db_file) {
+  file_name_ = db_file;
+  int fd = open(db_file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw Exception("can't open db file");
+  }
+  struct stat stat_buf;
+  if (fstat(fd, &stat_buf) != 0) {
+    close(fd);
+    throw Exception("can't stat db file");
+  }
+  size_ = static_cast<size_t>(stat_buf.st_size);
+  num_pages_ = size_ / BUSTUB_PAGE_SIZE;
+  if (size_ > 0) {
+    void *data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      throw Exception("can't map db file");
+    }
+    data_ = static_cast<char *>(data);
+  }
+  // The mapping keeps the file open.
+  close(fd);
+  try {
+    OpenChecksumFile(db_file, false, true);
+  } catch (Exception &e) {
+    if (data_ != nullptr) {
+      munmap(data_, size_);
+    }
+    throw;
+  }
+}
+
+DiskManagerMmap::~DiskManagerMmap() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+}
+
+auto DiskManagerMmap::WritePage(page_id_t page_id, const char *page_data) -> bool {
+  throw Exception(ExceptionType::INVALID, "can't write page " + std::to_string(page_id) + ", db file is read-only");
+}
+
+/**
+ * Copy the specified page out of the mapping
+ */
+void DiskManagerMmap::ReadPage(page_id_t page_id, char *page_data) {
+  const char *data = GetPageData(page_id);
+  if (data == nullptr) {
+    LOG_DEBUG("I/O error reading past end of file");
+    memset(page_data, 0, BUSTUB_PAGE_SIZE);
+    return;
+  }
+  stats_.RecordRead(BUSTUB_PAGE_SIZE);
+  memcpy(page_data, data, BUSTUB_PAGE_SIZE);
+  VerifyChecksum(page_id, page_data);
+}
+
+void DiskManagerMmap::ReadPageAsync(page_id_t page_id, char *page_data, std::function<void(bool)> done) {
+  bool verified = true;
+  try {
+    ReadPage(page_id, page_data);
+  } catch (Exception &e) {
+    verified = false;
+  }
+  done(verified);
+}
+
+auto DiskManagerMmap::GetPageData(page_id_t page_id) const -> const char * {
+  if (page_id < 0 || static_cast<size_t>(page_id) >= num_pages_) {
+    return nullptr;
+  }
+  return data_ + static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
+}
+
 }  // namespace bustub
@@ -0,0 +1,430 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring_disk_manager.cpp
+//
+// Identification: src/storage/disk/io_uring_disk_manager.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/io_uring_disk_manager.h"
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <future>  // NOLINT
+#include <memory>
+#include <shared_mutex>
+#include <utility>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+
+auto IoUringSetup(unsigned entries, io_uring_params *params) -> int {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+auto IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) -> int {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+}  // namespace
+
+IoUringDiskManager::IoUringDiskManager(const std::string &db_file, bool use_io_uring) : DiskManager(db_file) {
+  // DiskManager created the file and opened it for the log and for buffered I/O; reopen it for direct I/O.
+  int fd = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+  direct_io_ = fd >= 0;
+  if (fd < 0) {
+    LOG_DEBUG("O_DIRECT is not supported, falling back to buffered I/O");
+    fd = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+      throw Exception("can't open db file");
+    }
+  }
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+  db_fd_ = fd;
+
+  if (use_io_uring && !SetUpRing()) {
+    LOG_DEBUG("io_uring is not available, falling back to pread/pwrite");
+  }
+}
+
+IoUringDiskManager::~IoUringDiskManager() {
+  // Queued asynchronous reads of the fallback call ReadPage(), which must still be ours.
+  StopIoWorkers();
+  TearDownRing();
+  for (char *buffer : free_bounce_buffers_) {
+    std::free(buffer);  // NOLINT
+  }
+}
+
+auto IoUringDiskManager::SetUpRing() -> bool {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = IoUringSetup(IO_URING_QUEUE_DEPTH, &params);
+  if (ring_fd < 0) {
+    return false;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+
+  void *sq_ring = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                       IORING_OFF_SQ_RING);
+  void *cq_ring = sq_ring;
+  if (sq_ring != MAP_FAILED && !single_mmap) {
+    cq_ring = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                   IORING_OFF_CQ_RING);
+  }
+  void *sqes = MAP_FAILED;
+  if (cq_ring != MAP_FAILED) {
+    sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  }
+  if (sqes == MAP_FAILED) {
+    if (cq_ring != MAP_FAILED && cq_ring != sq_ring) {
+      munmap(cq_ring, cq_ring_size_);
+    }
+    if (sq_ring != MAP_FAILED) {
+      munmap(sq_ring, sq_ring_size_);
+    }
+    close(ring_fd);
+    return false;
+  }
+
+  auto *sq = static_cast<char *>(sq_ring);
+  auto *cq = static_cast<char *>(cq_ring);
+  sq_ring_ = sq_ring;
+  cq_ring_ = cq_ring;
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+  sq_entries_ = params.sq_entries;
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+  ring_fd_ = ring_fd;
+  reaper_thread_ = std::thread(&IoUringDiskManager::RunReaper, this);
+  return true;
+}
+
+void IoUringDiskManager::TearDownRing() {
+  if (ring_fd_ < 0) {
+    return;
+  }
+  {
+    std::unique_lock lock(sq_latch_);
+    sq_cv_.wait(lock, [this] { return in_flight_ == 0; });
+    PushRequest(nullptr);
+  }
+  reaper_thread_.join();
+  munmap(sqes_, sqes_size_);
+  if (cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  munmap(sq_ring_, sq_ring_size_);
+  close(ring_fd_);
+  ring_fd_ = -1;
+}
+
+void IoUringDiskManager::Submit(IoRequest *request) {
+  std::unique_lock lock(sq_latch_);
+  sq_cv_.wait(lock, [this] { return in_flight_ < sq_entries_; });
+  in_flight_++;
+  PushRequest(request);
+}
+
+void IoUringDiskManager::PushRequest(IoRequest *request) {
+  // Every submission is handed to the kernel right away, so the submission queue never holds more than one entry.
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  if (request == nullptr) {
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = 0;
+  } else {
+    request->iov_.iov_base = request->io_buf_ + request->done_;
+    request->iov_.iov_len = BUSTUB_PAGE_SIZE - request->done_;
+    sqe->opcode = request->is_write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = db_fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(&request->iov_);
+    sqe->len = 1;
+    sqe->off = static_cast<uint64_t>(request->page_id_) * BUSTUB_PAGE_SIZE + request->done_;
+    sqe->user_data = reinterpret_cast<uint64_t>(request);
+    request->submitted_.store(true, std::memory_order_release);
+  }
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+  while (IoUringEnter(ring_fd_, 1, 0, 0) < 0) {
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      LOG_DEBUG("io_uring_enter failed to submit");
+      break;
+    }
+  }
+}
+
+void IoUringDiskManager::RunReaper() {
+  while (true) {
+    if (IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+      LOG_DEBUG("io_uring_enter failed to wait");
+    }
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    bool stop = false;
+    for (; head != tail; head++) {
+      const io_uring_cqe &cqe = cqes_[head & *cq_mask_];
+      if (cqe.user_data == 0) {
+        stop = true;
+      } else {
+        CompleteRequest(reinterpret_cast<IoRequest *>(cqe.user_data), cqe.res);
+      }
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    if (stop) {
+      return;
+    }
+  }
+}
+
+void IoUringDiskManager::CompleteRequest(IoRequest *request, int res) {
+  request->submitted_.load(std::memory_order_acquire);
+  if (res == -EINTR || res == -EAGAIN) {
+    std::scoped_lock lock(sq_latch_);
+    PushRequest(request);
+    return;
+  }
+  if (res > 0) {
+    request->done_ += res;
+    if (request->done_ < BUSTUB_PAGE_SIZE) {
+      std::scoped_lock lock(sq_latch_);
+      PushRequest(request);
+      return;
+    }
+  } else if (res < 0 || request->is_write_) {
+    LOG_DEBUG(request->is_write_ ? "I/O error while writing" : "I/O error while reading");
+  }
+  // A read that stopped early ran past the end of the file.
+  if (!request->is_write_ && request->done_ < BUSTUB_PAGE_SIZE) {
+    memset(request->io_buf_ + request->done_, 0, BUSTUB_PAGE_SIZE - request->done_);
+  }
+
+  ReleaseIoBuffer(request->is_write_, request->data_, request->io_buf_);
+  if (request->verify_) {
+    // Only ReadPageAsync() verifies on completion; synchronous reads and writes are counted by their caller.
+    stats_.RecordRead(BUSTUB_PAGE_SIZE);
+  }
+  bool succeeded = request->is_write_ ? request->done_ == BUSTUB_PAGE_SIZE
+                                      : !request->verify_ || ChecksumMatches(request->page_id_, request->data_);
+  std::function<void(bool)> callback = std::move(request->callback_);
+  delete request;
+  callback(succeeded);
+  // Notify under the latch: once in_flight_ drops to zero the destructor may run and destroy the condition variable.
+  std::scoped_lock lock(sq_latch_);
+  in_flight_--;
+  sq_cv_.notify_all();
+}
+
+auto IoUringDiskManager::NewRequest(bool is_write, page_id_t page_id, char *data, std::function<void(bool)> callback)
+    -> IoRequest * {
+  auto *request = new IoRequest();
+  request->is_write_ = is_write;
+  request->page_id_ = page_id;
+  request->data_ = data;
+  request->io_buf_ = AcquireIoBuffer(is_write, data);
+  request->callback_ = std::move(callback);
+  return request;
+}
+
+/**
+ * Write the contents of the specified page into disk file
+ */
+auto IoUringDiskManager::WritePage(page_id_t page_id, const char *page_data) -> bool {
+  auto *data = const_cast<char *>(page_data);  // NOLINT
+  std::shared_lock order_lock(write_order_latch_);
+  BeginUnorderedWrite();
+  PageChecksum replaced;
+  RecordChecksums(page_id, &page_data, 1, &replaced);
+  bool written;
+  if (ring_fd_ < 0) {
+    written = TransferPage(true, page_id, data);
+  } else {
+    auto done = std::make_shared<std::promise<bool>>();
+    auto future = done->get_future();
+    Submit(NewRequest(true, page_id, data, [done](bool succeeded) { done->set_value(succeeded); }));
+    written = future.get();
+  }
+  if (!written) {
+    RestoreChecksums(page_id, &replaced, 1);
+    return false;
+  }
+  stats_.RecordWrite(BUSTUB_PAGE_SIZE);
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  num_writes_ += 1;
+  return true;
+}
+
+/**
+ * Read the contents of the specified page into the given memory area
+ */
+void IoUringDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  stats_.RecordRead(BUSTUB_PAGE_SIZE);
+  if (ring_fd_ < 0) {
+    TransferPage(false, page_id, page_data);
+  } else {
+    auto read = std::make_shared<std::promise<void>>();
+    auto future = read->get_future();
+    Submit(NewRequest(false, page_id, page_data, [read](bool) { read->set_value(); }));
+    future.wait();
+  }
+  VerifyChecksum(page_id, page_data);
+}
+
+/**
+ * Submit a page read to the ring, done runs on the reaper thread
+ */
+void IoUringDiskManager::ReadPageAsync(page_id_t page_id, char *page_data, std::function<void(bool)> done) {
+  if (ring_fd_ < 0) {
+    DiskManager::ReadPageAsync(page_id, page_data, std::move(done));
+    return;
+  }
+  auto *request = NewRequest(false, page_id, page_data, std::move(done));
+  request->verify_ = true;
+  Submit(request);
+}
+
+/**
+ * Write a run of consecutive pages, keeping all of them in flight at once
+ */
+auto IoUringDiskManager::WritePages(page_id_t first_page_id, const char *const *pages_data, size_t num_pages)
+    -> bool {
+  if (ring_fd_ < 0 && !direct_io_) {
+    // Buffered fallback: DiskManager writes the run with pwritev.
+    return DiskManager::WritePages(first_page_id, pages_data, num_pages);
+  }
+  std::shared_lock order_lock(write_order_latch_);
+  BeginUnorderedWrite();
+  std::vector<PageChecksum> replaced(num_pages);
+  RecordChecksums(first_page_id, pages_data, num_pages, replaced.data());
+  // The pages are written independently, so each one that failed gets its checksum back.
+  auto failed = std::make_shared<std::vector<std::atomic<bool>>>(num_pages);
+  if (ring_fd_ < 0) {
+    for (size_t i = 0; i < num_pages; i++) {
+      auto *data = const_cast<char *>(pages_data[i]);  // NOLINT
+      (*failed)[i] = !TransferPage(true, first_page_id + static_cast<page_id_t>(i), data);
+    }
+  } else if (num_pages > 0) {
+    auto written = std::make_shared<std::promise<void>>();
+    auto remaining = std::make_shared<std::atomic<size_t>>(num_pages);
+    auto future = written->get_future();
+    for (size_t i = 0; i < num_pages; i++) {
+      auto *data = const_cast<char *>(pages_data[i]);  // NOLINT
+      Submit(NewRequest(true, first_page_id + static_cast<page_id_t>(i), data,
+                        [written, remaining, failed, i](bool succeeded) {
+                          (*failed)[i] = !succeeded;
+                          if (remaining->fetch_sub(1) == 1) {
+                            written->set_value();
+                          }
+                        }));
+    }
+    future.wait();
+  }
+  size_t num_written = 0;
+  for (size_t i = 0; i < num_pages; i++) {
+    if ((*failed)[i]) {
+      RestoreChecksums(first_page_id + static_cast<page_id_t>(i), &replaced[i], 1);
+    } else {
+      num_written++;
+    }
+  }
+  stats_.RecordWrite(num_written * BUSTUB_PAGE_SIZE);
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  num_writes_ += static_cast<int>(num_written);
+  return num_written == num_pages;
+}
+
+auto IoUringDiskManager::TransferPage(bool is_write, page_id_t page_id, char *data) -> bool {
+  char *io_buf = AcquireIoBuffer(is_write, data);
+  auto offset = static_cast<off_t>(page_id) * BUSTUB_PAGE_SIZE;
+  size_t done = 0;
+  while (done < BUSTUB_PAGE_SIZE) {
+    ssize_t res = is_write ? pwrite(db_fd_, io_buf + done, BUSTUB_PAGE_SIZE - done, offset + done)
+                           : pread(db_fd_, io_buf + done, BUSTUB_PAGE_SIZE - done, offset + done);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      if (res < 0 || is_write) {
+        LOG_DEBUG(is_write ? "I/O error while writing" : "I/O error while reading");
+      }
+      break;
+    }
+    done += res;
+  }
+  // A read that stopped early ran past the end of the file.
+  if (!is_write && done < BUSTUB_PAGE_SIZE) {
+    memset(io_buf + done, 0, BUSTUB_PAGE_SIZE - done);
+  }
+  ReleaseIoBuffer(is_write, data, io_buf);
+  return !is_write || done == BUSTUB_PAGE_SIZE;
+}
+
+auto IoUringDiskManager::AcquireIoBuffer(bool is_write, char *data) -> char * {
+  if (!direct_io_ || reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT == 0) {
+    return data;
+  }
+  char *buffer = nullptr;
+  {
+    std::scoped_lock lock(bounce_latch_);
+    if (!free_bounce_buffers_.empty()) {
+      buffer = free_bounce_buffers_.back();
+      free_bounce_buffers_.pop_back();
+    }
+  }
+  if (buffer == nullptr) {
+    buffer = static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, BUSTUB_PAGE_SIZE));
+    if (buffer == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "can't allocate an I/O buffer");
+    }
+  }
+  if (is_write) {
+    memcpy(buffer, data, BUSTUB_PAGE_SIZE);
+  }
+  return buffer;
+}
+
+void IoUringDiskManager::ReleaseIoBuffer(bool is_write, char *data, char *io_buf) {
+  if (io_buf == data) {
+    return;
+  }
+  if (!is_write) {
+    memcpy(data, io_buf, BUSTUB_PAGE_SIZE);
+  }
+  std::scoped_lock lock(bounce_latch_);
+  free_bounce_buffers_.push_back(io_buf);
+}
+
+}  // namespace bustub
@@ -1,7 +1,11 @@
+#include <algorithm>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/macros.h"
 #include "common/rid.h"
 #include "storage/index/b_plus_tree.h"
 #include "storage/page/header_page.h"
@@ -9,30 +13,51 @@
 namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, page_id_t header_page_id, bool unique_keys)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      internal_max_size_(internal_max_size),
+      header_page_id_(header_page_id),
+      unique_keys_(unique_keys) {
+  BUSTUB_ASSERT(leaf_max_size_ >= 2, "a leaf must hold at least two entries before it splits");
+  BUSTUB_ASSERT(internal_max_size_ >= 3, "an internal page must hold at least three children");
+}
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return true; }
+auto BPLUSTREE_TYPE::IsEmpty() const -> bool {
+  auto &root_latch = const_cast<ReaderWriterLatch &>(root_latch_);
+  root_latch.RLock();
+  bool empty = root_page_id_ == INVALID_PAGE_ID;
+  root_latch.RUnlock();
+  return empty;
+}
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 /*
- * Return the only value that associated with input key
+ * Return the values associated with input key
  * This method is used for point query
  * @return : true means key exists
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) -> bool {
-  return false;
+  auto guard = FindLeafRead(&key);
+  if (!guard.IsValid()) {
+    return false;
+  }
+  const auto *leaf = guard.template As<LeafPage>();
+  int index = leaf->FindKey(key, comparator_);
+  if (index < 0) {
+    return false;
+  }
+  CollectValues(leaf->ValueAt(index), result);
+  return true;
 }
 
 /*****************************************************************************
@@ -42,12 +67,109 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  * Insert constant key & value pair into b+ tree
  * if current tree is empty, start new tree, update root page id and insert
  * entry, otherwise insert into leaf page.
- * @return: since we only support unique key, if user try to insert duplicate
- * keys return false, otherwise return true.
+ * @return: if keys are unique and user try to insert duplicate keys return
+ * false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
-  return false;
+  bool is_root;
+  auto leaf_guard = FindLeafOptimistic(key, &is_root);
+  if (leaf_guard.IsValid()) {
+    const auto *leaf = leaf_guard.template As<LeafPage>();
+    int index = leaf->FindKey(key, comparator_);
+    if (index >= 0) {
+      if (unique_keys_) {
+        return false;
+      }
+      // Another value of a key only goes to its posting list: the leaf keeps its size.
+      AppendToPostingList(leaf_guard.template AsMut<LeafPage>(), index, value);
+      return true;
+    }
+    if (IsSafe(leaf, Operation::INSERT, is_root, key)) {
+      leaf_guard.template AsMut<LeafPage>()->Insert(key, value, comparator_);
+      return true;
+    }
+    // The leaf would split: start over, latching everything the split may reach.
+    leaf_guard.Drop();
+  }
+  return InsertPessimistic(key, value);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::InsertPessimistic(const KeyType &key, const ValueType &value) -> bool {
+  Context ctx(&root_latch_);
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    // Start a new tree with a leaf as its root.
+    page_id_t page_id;
+    auto guard = NewNode(&page_id);
+    auto *root = guard.template AsMut<LeafPage>();
+    root->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+    root->Insert(key, value, comparator_);
+    root_page_id_ = page_id;
+    UpdateRootPageId(1);
+    return true;
+  }
+
+  FindLeafPessimistic(key, Operation::INSERT, &ctx);
+  auto &leaf_guard = ctx.write_set_.back();
+  int index = leaf_guard.template As<LeafPage>()->FindKey(key, comparator_);
+  if (index >= 0) {
+    if (unique_keys_) {
+      return false;
+    }
+    AppendToPostingList(leaf_guard.template AsMut<LeafPage>(), index, value);
+    return true;
+  }
+  auto *leaf = leaf_guard.template AsMut<LeafPage>();
+  if (leaf->CanInsert(key)) {
+    leaf->Insert(key, value, comparator_);
+    return true;
+  }
+
+  // The new leaf is not reachable until it is linked in, so it needs no latch.
+  page_id_t new_page_id;
+  auto new_guard = NewNode(&new_page_id);
+  auto *new_leaf = new_guard.template AsMut<LeafPage>();
+  new_leaf->Init(new_page_id, INVALID_PAGE_ID, leaf_max_size_);
+  leaf->InsertAndSplit(key, value, comparator_, new_leaf);
+  new_leaf->SetNextPageId(leaf->GetNextPageId());
+  leaf->SetNextPageId(new_page_id);
+  InsertIntoParent(&ctx, ctx.write_set_.size() - 1, new_leaf->KeyAt(0), new_page_id);
+  return true;
+}
+
+/*
+ * Insert the separator key of a split node at level of the write set, and the
+ * new page to its right, into the parent of the node. The parent splits in
+ * turn if it is full; a split root makes the tree grow by a level.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::InsertIntoParent(Context *ctx, size_t level, const KeyType &key, page_id_t new_page_id) {
+  page_id_t old_page_id = ctx->write_set_[level].PageId();
+  if (level == 0) {
+    // Every latched node but the topmost is unsafe; a topmost node that splits is the root.
+    BUSTUB_ASSERT(ctx->HoldsRootLatch(), "only the root splits without a latched parent");
+    page_id_t root_page_id;
+    auto root_guard = NewNode(&root_page_id);
+    auto *root = root_guard.template AsMut<InternalPage>();
+    root->Init(root_page_id, INVALID_PAGE_ID, internal_max_size_);
+    root->PopulateNewRoot(old_page_id, key, new_page_id);
+    root_page_id_ = root_page_id;
+    UpdateRootPageId();
+    return;
+  }
+
+  auto *parent = ctx->write_set_[level - 1].template AsMut<InternalPage>();
+  if (parent->GetSize() < internal_max_size_) {
+    parent->InsertNodeAfter(old_page_id, key, new_page_id);
+    return;
+  }
+  page_id_t sibling_page_id;
+  auto sibling_guard = NewNode(&sibling_page_id);
+  auto *sibling = sibling_guard.template AsMut<InternalPage>();
+  sibling->Init(sibling_page_id, INVALID_PAGE_ID, internal_max_size_);
+  KeyType middle_key = parent->InsertAndSplit(old_page_id, key, new_page_id, sibling);
+  InsertIntoParent(ctx, level - 1, middle_key, sibling_page_id);
 }
 
 /*****************************************************************************
@@ -61,7 +183,429 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  * necessary.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  RemoveValue(key, nullptr);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::Remove(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  RemoveValue(key, &value);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RemoveValue(const KeyType &key, const ValueType *value) {
+  bool is_root;
+  auto leaf_guard = FindLeafOptimistic(key, &is_root);
+  if (!leaf_guard.IsValid()) {
+    return;
+  }
+  int index = leaf_guard.template As<LeafPage>()->FindKey(key, comparator_);
+  if (index < 0 || !RemoveFromEntry(&leaf_guard, index, value)) {
+    return;
+  }
+  if (IsSafe(leaf_guard.template As<LeafPage>(), Operation::REMOVE, is_root, key)) {
+    RemoveEntry(leaf_guard.template AsMut<LeafPage>(), index);
+    return;
+  }
+  leaf_guard.Drop();
+  while (!RemovePessimistic(key, value)) {
+    std::this_thread::yield();
+  }
+}
+
+/*
+ * @return false if the remove has to be retried, because the leaf underflows and
+ * its left sibling is latched by someone else. Leaf latches are taken left to
+ * right everywhere else (see IndexIterator), so waiting for it could deadlock.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RemovePessimistic(const KeyType &key, const ValueType *value) -> bool {
+  Context ctx(&root_latch_);
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    return true;
+  }
+  FindLeafPessimistic(key, Operation::REMOVE, &ctx);
+  size_t level = ctx.write_set_.size() - 1;
+  auto &leaf_guard = ctx.write_set_[level];
+  int index = leaf_guard.template As<LeafPage>()->FindKey(key, comparator_);
+  if (index < 0 || !RemoveFromEntry(&leaf_guard, index, value)) {
+    return true;
+  }
+
+  // A leaf that is the topmost latched node is the root, or was found safe on the way down.
+  if (level == 0) {
+    auto *root = leaf_guard.template AsMut<LeafPage>();
+    if (RemoveEntry(root, index) == 0 && ctx.HoldsRootLatch()) {
+      page_id_t old_root_page_id = root_page_id_;
+      root_page_id_ = INVALID_PAGE_ID;
+      UpdateRootPageId();
+      leaf_guard.Drop();
+      buffer_pool_manager_->DeletePage(old_root_page_id);
+    }
+    return true;
+  }
+
+  // Latch the sibling before changing anything, so that a busy left sibling leaves the tree as it was.
+  const auto *leaf = leaf_guard.template As<LeafPage>();
+  WritePageGuard sibling_guard;
+  bool underflow = leaf->UnderflowsWithout(index);
+  if (underflow && !LatchSibling(&ctx, level, false, &sibling_guard)) {
+    return false;
+  }
+  RemoveEntry(leaf_guard.template AsMut<LeafPage>(), index);
+  if (underflow) {
+    CoalesceOrRedistribute(&ctx, level, std::move(sibling_guard));
+  }
+  return true;
+}
+
+/*
+ * Taking one value of a key that has a posting list leaves at least one value
+ * in the list, so only the list changes; the entry of the key only goes away
+ * with its last value, or when value is null.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RemoveFromEntry(WritePageGuard *leaf_guard, int index, const ValueType *value) -> bool {
+  ValueType existing = leaf_guard->template As<LeafPage>()->ValueAt(index);
+  if (value == nullptr) {
+    return true;
+  }
+  if (IsPostingList(existing)) {
+    RemoveFromPostingList(leaf_guard->template AsMut<LeafPage>(), index, *value);
+    return false;
+  }
+  return existing == *value;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RemoveEntry(LeafPage *leaf, int index) -> int {
+  ValueType value = leaf->ValueAt(index);
+  if (IsPostingList(value)) {
+    DeletePostingList(PostingListPageId(value));
+  }
+  return leaf->RemoveAndDeleteRecord(leaf->KeyAt(index), comparator_);
+}
+
+/*
+ * Latch the sibling that the node at level of the write set merges with or
+ * borrows from: its right sibling, or its left one if it is the last child.
+ * @return false if wait is false and the left sibling is latched by someone else
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::LatchSibling(Context *ctx, size_t level, bool wait, WritePageGuard *sibling) -> bool {
+  const auto *parent = ctx->write_set_[level - 1].template As<InternalPage>();
+  int index = parent->ValueIndex(ctx->write_set_[level].PageId());
+  if (index + 1 < parent->GetSize()) {
+    *sibling = FetchWrite(parent->ValueAt(index + 1));
+    return true;
+  }
+  auto guard = FetchBasic(parent->ValueAt(index - 1));
+  *sibling = wait ? guard.UpgradeWrite() : guard.TryUpgradeWrite();
+  return sibling->IsValid();
+}
+
+/*
+ * The node at level of the write set has underflowed. Merge it with its
+ * sibling if both fit in one page, which removes an entry from the parent and
+ * may make it underflow in turn, or else borrow one entry from the sibling.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CoalesceOrRedistribute(Context *ctx, size_t level, WritePageGuard sibling_guard) {
+  auto &parent_guard = ctx->write_set_[level - 1];
+  auto &node_guard = ctx->write_set_[level];
+  auto *parent = parent_guard.template AsMut<InternalPage>();
+  int index = parent->ValueIndex(node_guard.PageId());
+  int sibling_index = parent->ValueIndex(sibling_guard.PageId());
+  auto *node = node_guard.template AsMut<BPlusTreePage>();
+  auto *sibling = sibling_guard.template AsMut<BPlusTreePage>();
+  bool is_leaf = node->IsLeafPage();
+
+  bool coalesce = is_leaf ? reinterpret_cast<LeafPage *>(node)->CanMergeWith(reinterpret_cast<LeafPage *>(sibling))
+                          : node->GetSize() + sibling->GetSize() <= internal_max_size_;
+  if (coalesce) {
+    // Coalesce: the right page of the two moves into the left one and goes away.
+    bool sibling_is_right = sibling_index > index;
+    auto &left_guard = sibling_is_right ? node_guard : sibling_guard;
+    auto &right_guard = sibling_is_right ? sibling_guard : node_guard;
+    int right_index = std::max(index, sibling_index);
+    if (is_leaf) {
+      right_guard.template AsMut<LeafPage>()->MoveAllTo(left_guard.template AsMut<LeafPage>());
+    } else {
+      right_guard.template AsMut<InternalPage>()->MoveAllTo(left_guard.template AsMut<InternalPage>(),
+                                                            parent->KeyAt(right_index));
+    }
+    parent->Remove(right_index);
+    page_id_t right_page_id = right_guard.PageId();
+    right_guard.Drop();
+    buffer_pool_manager_->DeletePage(right_page_id);
+
+    // A parent that is the topmost latched node was found safe, or is the root, which may run below the minimum size.
+    if (level - 1 == 0) {
+      if (ctx->HoldsRootLatch() && parent->GetSize() == 1) {
+        // The root is left with a single child, which becomes the new root.
+        page_id_t old_root_page_id = root_page_id_;
+        root_page_id_ = parent->ValueAt(0);
+        UpdateRootPageId();
+        parent_guard.Drop();
+        buffer_pool_manager_->DeletePage(old_root_page_id);
+      }
+      return;
+    }
+    if (parent->GetSize() < parent->GetMinSize()) {
+      WritePageGuard parent_sibling_guard;
+      LatchSibling(ctx, level - 1, true, &parent_sibling_guard);
+      CoalesceOrRedistribute(ctx, level - 1, std::move(parent_sibling_guard));
+    }
+    return;
+  }
+
+  // Redistribute: borrow the entries of the sibling that are closest to the node, and fix the separator in the parent.
+  // A leaf borrows until it no longer underflows, which may take more than one entry when keys differ in length.
+  if (is_leaf) {
+    auto *leaf = reinterpret_cast<LeafPage *>(node);
+    auto *sibling_leaf = reinterpret_cast<LeafPage *>(sibling);
+    if (sibling_index > index) {
+      while (leaf->IsUnderflow() && !sibling_leaf->UnderflowsWithout(0) && leaf->CanInsert(sibling_leaf->KeyAt(0))) {
+        sibling_leaf->MoveFirstToEndOf(leaf);
+      }
+      parent->SetKeyAt(sibling_index, sibling_leaf->KeyAt(0));
+    } else {
+      int last = sibling_leaf->GetSize() - 1;
+      while (leaf->IsUnderflow() && !sibling_leaf->UnderflowsWithout(last) &&
+             leaf->CanInsert(sibling_leaf->KeyAt(last))) {
+        sibling_leaf->MoveLastToFrontOf(leaf);
+        last--;
+      }
+      parent->SetKeyAt(index, leaf->KeyAt(0));
+    }
+    return;
+  }
+  auto *internal = reinterpret_cast<InternalPage *>(node);
+  auto *sibling_internal = reinterpret_cast<InternalPage *>(sibling);
+  if (sibling_index > index) {
+    KeyType new_separator = sibling_internal->KeyAt(1);
+    sibling_internal->MoveFirstToEndOf(internal, parent->KeyAt(sibling_index));
+    parent->SetKeyAt(sibling_index, new_separator);
+  } else {
+    KeyType new_separator = sibling_internal->KeyAt(sibling_internal->GetSize() - 1);
+    sibling_internal->MoveLastToFrontOf(internal, parent->KeyAt(index));
+    parent->SetKeyAt(index, new_separator);
+  }
+}
+
+/*****************************************************************************
+ * POSTING LISTS
+ *****************************************************************************/
+/*
+ * The caller holds the latch of the leaf whose entry refers to the posting
+ * list, which covers the pages of the list. Their own latches are taken
+ * after it, like the latch of a leaf after its parent's.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::CollectValues(const ValueType &value, std::vector<ValueType> *result) {
+  if (!IsPostingList(value)) {
+    result->push_back(value);
+    return;
+  }
+  page_id_t page_id = PostingListPageId(value);
+  while (page_id != INVALID_PAGE_ID) {
+    auto guard = FetchRead(page_id);
+    const auto *page = guard.template As<PostingPage>();
+    for (int i = 0; i < page->GetSize(); i++) {
+      result->push_back(page->ValueAt(i));
+    }
+    page_id = page->GetNextPageId();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::AppendToPostingList(LeafPage *leaf, int index, const ValueType &value) {
+  ValueType existing = leaf->ValueAt(index);
+  if (IsPostingList(existing)) {
+    auto guard = FetchWrite(PostingListPageId(existing));
+    if (!guard.template As<PostingPage>()->IsFull()) {
+      guard.template AsMut<PostingPage>()->Append(value);
+      return;
+    }
+  }
+  // Start the list with the value the entry held, or put a new page in front of the full first page.
+  page_id_t page_id;
+  auto guard = NewNode(&page_id);
+  auto *page = guard.template AsMut<PostingPage>();
+  if (IsPostingList(existing)) {
+    page->Init(PostingListPageId(existing));
+  } else {
+    page->Init();
+    page->Append(existing);
+  }
+  page->Append(value);
+  leaf->SetValueAt(index, PostingListRef(page_id));
+}
+
+/*
+ * The hole the value leaves is filled with the last value of the first page,
+ * the only one that is not full. A list left with one value is folded back
+ * into the entry of the key.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RemoveFromPostingList(LeafPage *leaf, int index, const ValueType &value) {
+  auto head_guard = FetchWrite(PostingListPageId(leaf->ValueAt(index)));
+  WritePageGuard found_guard;
+  int slot = head_guard.template As<PostingPage>()->IndexOf(value);
+  page_id_t page_id = head_guard.template As<PostingPage>()->GetNextPageId();
+  while (slot < 0 && page_id != INVALID_PAGE_ID) {
+    found_guard = FetchWrite(page_id);
+    slot = found_guard.template As<PostingPage>()->IndexOf(value);
+    page_id = found_guard.template As<PostingPage>()->GetNextPageId();
+  }
+  if (slot < 0) {
+    return;
+  }
+
+  auto *head = head_guard.template AsMut<PostingPage>();
+  ValueType last = head->PopBack();
+  if (found_guard.IsValid()) {
+    found_guard.template AsMut<PostingPage>()->SetValueAt(slot, last);
+  } else if (slot < head->GetSize()) {
+    head->SetValueAt(slot, last);
+  }
+  if (head->GetSize() == 0) {
+    leaf->SetValueAt(index, PostingListRef(head->GetNextPageId()));
+  } else if (head->GetSize() == 1 && head->GetNextPageId() == INVALID_PAGE_ID) {
+    leaf->SetValueAt(index, head->ValueAt(0));
+  } else {
+    return;
+  }
+  page_id_t head_page_id = head_guard.PageId();
+  head_guard.Drop();
+  buffer_pool_manager_->DeletePage(head_page_id);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DeletePostingList(page_id_t page_id) {
+  while (page_id != INVALID_PAGE_ID) {
+    page_id_t next_page_id = FetchRead(page_id).template As<PostingPage>()->GetNextPageId();
+    buffer_pool_manager_->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+/*
+ * Pages are filled to the fill factor, but never below the minimum size: the
+ * last page of a level, which gets what is left over, evens out with the page
+ * before it, or merges into it if the two hold less than two minimum pages.
+ * Leaves are filled to the fill factor of their bytes as well, and to at least
+ * half of them; the last leaf only borrows what it needs not to underflow.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoad(const std::function<bool(MappingType *)> &next, double fill_factor) -> bool {
+  // The new pages are not reachable before the root page id is set, so they need no latches.
+  Context ctx(&root_latch_);
+  if (root_page_id_ != INVALID_PAGE_ID) {
+    return false;
+  }
+  int internal_min_size = (internal_max_size_ + 1) / 2;
+  int leaf_fill = std::clamp(static_cast<int>(fill_factor * (leaf_max_size_ - 1)), std::max(leaf_max_size_ / 2, 1),
+                             leaf_max_size_ - 1);
+  int internal_fill =
+      std::clamp(static_cast<int>(fill_factor * internal_max_size_), internal_min_size, internal_max_size_);
+  double leaf_byte_fill = std::clamp(fill_factor, 0.5, 1.0);
+
+  // The first key and the page id of every page of the level built last.
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  BasicPageGuard prev_guard;
+  BasicPageGuard leaf_guard;
+  MappingType item;
+  while (next(&item)) {
+    if (leaf_guard.IsValid()) {
+      const auto *leaf = leaf_guard.template As<LeafPage>();
+      int cmp = comparator_(item.first, leaf->KeyAt(leaf->GetSize() - 1));
+      BUSTUB_ASSERT(cmp >= 0, "bulk load entries must be in key order");
+      if (cmp == 0) {
+        if (!unique_keys_) {
+          AppendToPostingList(leaf_guard.template AsMut<LeafPage>(), leaf->GetSize() - 1, item.second);
+        }
+        continue;
+      }
+    }
+    if (!leaf_guard.IsValid() || leaf_guard.template As<LeafPage>()->GetSize() == leaf_fill ||
+        !leaf_guard.template As<LeafPage>()->CanInsert(item.first, leaf_byte_fill)) {
+      page_id_t page_id;
+      auto guard = NewNode(&page_id);
+      guard.template AsMut<LeafPage>()->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+      if (leaf_guard.IsValid()) {
+        leaf_guard.template AsMut<LeafPage>()->SetNextPageId(page_id);
+      }
+      prev_guard = std::move(leaf_guard);
+      leaf_guard = std::move(guard);
+      level.emplace_back(item.first, page_id);
+    }
+    leaf_guard.template AsMut<LeafPage>()->Insert(item.first, item.second, comparator_);
+  }
+  if (level.empty()) {
+    return true;
+  }
+
+  if (prev_guard.IsValid() && leaf_guard.template As<LeafPage>()->IsUnderflow()) {
+    auto *prev = prev_guard.template AsMut<LeafPage>();
+    auto *last = leaf_guard.template AsMut<LeafPage>();
+    while (last->IsUnderflow() && !prev->UnderflowsWithout(prev->GetSize() - 1) &&
+           last->CanInsert(prev->KeyAt(prev->GetSize() - 1))) {
+      prev->MoveLastToFrontOf(last);
+    }
+    if (!last->IsUnderflow()) {
+      level.back().first = last->KeyAt(0);
+    } else {
+      last->MoveAllTo(prev);
+      leaf_guard.Drop();
+      buffer_pool_manager_->DeletePage(level.back().second);
+      level.pop_back();
+    }
+  }
+  prev_guard.Drop();
+  leaf_guard.Drop();
+
+  while (level.size() > 1) {
+    // Cut the level into pages of internal_fill children, evening out the last two.
+    std::vector<size_t> sizes(level.size() / internal_fill, internal_fill);
+    size_t rest = level.size() % internal_fill;
+    if (rest > 0) {
+      if (sizes.empty() || rest >= static_cast<size_t>(internal_min_size)) {
+        sizes.push_back(rest);
+      } else if (internal_fill + rest >= 2 * static_cast<size_t>(internal_min_size)) {
+        size_t total = internal_fill + rest;
+        sizes.back() = total - total / 2;
+        sizes.push_back(total / 2);
+      } else {
+        sizes.back() += rest;
+      }
+    }
+
+    std::vector<std::pair<KeyType, page_id_t>> parents;
+    size_t begin = 0;
+    for (size_t size : sizes) {
+      page_id_t page_id;
+      auto guard = NewNode(&page_id);
+      auto *internal = guard.template AsMut<InternalPage>();
+      internal->Init(page_id, INVALID_PAGE_ID, internal_max_size_);
+      for (size_t i = 0; i < size; i++) {
+        internal->SetKeyAt(i, level[begin + i].first);
+        internal->SetValueAt(i, level[begin + i].second);
+      }
+      internal->SetSize(size);
+      parents.emplace_back(level[begin].first, page_id);
+      begin += size;
+    }
+    level = std::move(parents);
+  }
+
+  root_page_id_ = level[0].second;
+  UpdateRootPageId(1);
+  return true;
+}
 
 /*****************************************************************************
  * INDEX ITERATOR
@@ -72,7 +616,13 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
+  auto guard = FindLeafRead(nullptr);
+  if (!guard.IsValid()) {
+    return INDEXITERATOR_TYPE();
+  }
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, std::move(guard), 0, !unique_keys_);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -80,7 +630,14 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE()
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
+  auto guard = FindLeafRead(&key);
+  if (!guard.IsValid()) {
+    return INDEXITERATOR_TYPE();
+  }
+  int index = guard.template As<LeafPage>()->KeyIndex(key, comparator_);
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, std::move(guard), index, !unique_keys_);
+}
 
 /*
  * Input parameter is void, construct an index iterator representing the end
@@ -94,7 +651,186 @@ auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE();
  * @return Page id of the root of this tree
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t { return 0; }
+auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t {
+  root_latch_.RLock();
+  page_id_t root_page_id = root_page_id_;
+  root_latch_.RUnlock();
+  return root_page_id;
+}
+
+/*****************************************************************************
+ * DESCENT
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FetchBasic(page_id_t page_id) -> BasicPageGuard {
+  auto guard = buffer_pool_manager_->FetchPageBasic(page_id, AccessType::Index);
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: no frame for page " + std::to_string(page_id));
+  }
+  return guard;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FetchRead(page_id_t page_id) -> ReadPageGuard {
+  auto guard = buffer_pool_manager_->FetchPageRead(page_id, AccessType::Index);
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: no frame for page " + std::to_string(page_id));
+  }
+  return guard;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FetchWrite(page_id_t page_id) -> WritePageGuard {
+  auto guard = buffer_pool_manager_->FetchPageWrite(page_id, AccessType::Index);
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: no frame for page " + std::to_string(page_id));
+  }
+  return guard;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetExtents() -> std::vector<page_id_t> {
+  std::scoped_lock lock(extent_latch_);
+  return extents_;
+}
+
+/*
+ * Like the pages of a table heap, the nodes of the tree are taken from extents of EXTENT_PAGES consecutive page ids
+ * reserved for this index, so that a bulk loaded leaf level sits in order on disk and a range scan over it reads
+ * sequentially instead of hopping between pages interleaved with other objects.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::NewNode(page_id_t *page_id) -> BasicPageGuard {
+  BasicPageGuard guard;
+  {
+    std::scoped_lock lock(extent_latch_);
+    if (next_extent_page_id_ == extent_end_) {
+      page_id_t first = buffer_pool_manager_->AllocateExtent(EXTENT_PAGES);
+      if (first != INVALID_PAGE_ID) {
+        extents_.push_back(first);
+        next_extent_page_id_ = first;
+        extent_end_ = first + EXTENT_PAGES;
+      }
+    }
+    if (next_extent_page_id_ != extent_end_) {
+      auto *page = buffer_pool_manager_->NewPageAt(next_extent_page_id_, AccessType::Index);
+      guard = BasicPageGuard(buffer_pool_manager_, page);
+      if (guard.IsValid()) {
+        // A page that could not be created is tried again by the next call.
+        *page_id = next_extent_page_id_++;
+      }
+    } else {
+      guard = buffer_pool_manager_->NewPageGuarded(page_id, AccessType::Index);
+    }
+  }
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: no frame for a new page");
+  }
+  return guard;
+}
+
+/*
+ * A node is safe for an operation if the operation cannot make it split
+ * (insert) or underflow (remove), so that nothing above it changes. The root
+ * has no lower bound on its size: it only goes away when it is a leaf that
+ * loses its last entry, or an internal page left with a single child. Whether
+ * a leaf splits or underflows depends on the length of the key.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::IsSafe(const BPlusTreePage *page, Operation op, bool is_root, const KeyType &key) const
+    -> bool {
+  if (page->IsLeafPage()) {
+    const auto *leaf = reinterpret_cast<const LeafPage *>(page);
+    if (op == Operation::INSERT) {
+      return leaf->CanInsert(key);
+    }
+    if (is_root) {
+      return leaf->GetSize() > 1;
+    }
+    int index = leaf->FindKey(key, comparator_);
+    return index < 0 || !leaf->UnderflowsWithout(index);
+  }
+  if (op == Operation::INSERT) {
+    return page->GetSize() < page->GetMaxSize();
+  }
+  return is_root ? page->GetSize() > 2 : page->GetSize() > page->GetMinSize();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafRead(const KeyType *key) -> ReadPageGuard {
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return {};
+  }
+  page_id_t root_page_id = root_page_id_;
+  auto guard = buffer_pool_manager_->FetchPageRead(root_page_id, AccessType::Index);
+  root_latch_.RUnlock();
+  if (!guard.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: no frame for page " + std::to_string(root_page_id));
+  }
+  while (!guard.template As<BPlusTreePage>()->IsLeafPage()) {
+    const auto *internal = guard.template As<InternalPage>();
+    // The child is latched before the assignment unlatches its parent.
+    guard = FetchRead(key == nullptr ? internal->ValueAt(0) : internal->Lookup(*key, comparator_));
+  }
+  return guard;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafOptimistic(const KeyType &key, bool *is_root) -> WritePageGuard {
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return {};
+  }
+  page_id_t root_page_id = root_page_id_;
+  auto guard = buffer_pool_manager_->FetchPageBasic(root_page_id, AccessType::Index);
+  if (!guard.IsValid()) {
+    root_latch_.RUnlock();
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: no frame for page " + std::to_string(root_page_id));
+  }
+  *is_root = true;
+  ReadPageGuard parent;
+  while (true) {
+    // A page does not change type while it is in the tree, so the type can be read before the page is latched;
+    // the latch of the parent keeps it in the tree.
+    if (guard.template As<BPlusTreePage>()->IsLeafPage()) {
+      auto leaf = guard.UpgradeWrite();
+      if (*is_root) {
+        root_latch_.RUnlock();
+      }
+      return leaf;
+    }
+    auto node = guard.UpgradeRead();
+    if (*is_root) {
+      root_latch_.RUnlock();
+      *is_root = false;
+    }
+    parent = std::move(node);
+    guard = FetchBasic(parent.template As<InternalPage>()->Lookup(key, comparator_));
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::FindLeafPessimistic(const KeyType &key, Operation op, Context *ctx) {
+  auto guard = FetchWrite(root_page_id_);
+  bool is_root = true;
+  while (true) {
+    const auto *page = guard.template As<BPlusTreePage>();
+    if (IsSafe(page, op, is_root, key)) {
+      ctx->ReleaseAncestors();
+    }
+    if (page->IsLeafPage()) {
+      ctx->write_set_.push_back(std::move(guard));
+      return;
+    }
+    page_id_t child_page_id = reinterpret_cast<const InternalPage *>(page)->Lookup(key, comparator_);
+    ctx->write_set_.push_back(std::move(guard));
+    guard = FetchWrite(child_page_id);
+    is_root = false;
+  }
+}
 
 /*****************************************************************************
  * UTILITIES AND DEBUG
@@ -109,15 +845,16 @@ auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t { return 0; }
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record != 0) {
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  } else {
+  if (header_page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+  auto guard = FetchWrite(header_page_id_);
+  auto *header_page = guard.template AsMut<HeaderPage>();
+  // A tree that was emptied and grows again still has its record.
+  if (insert_record == 0 || !header_page->InsertRecord(index_name_, root_page_id_)) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
@@ -220,12 +957,6 @@ void BPLUSTREE_TYPE::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::o
       out << leaf_prefix << leaf->GetPageId() << " -> " << leaf_prefix << leaf->GetNextPageId() << ";\n";
       out << "{rank=same " << leaf_prefix << leaf->GetPageId() << " " << leaf_prefix << leaf->GetNextPageId() << "};\n";
     }
-
-    // Print parent links if there is a parent
-    if (leaf->GetParentPageId() != INVALID_PAGE_ID) {
-      out << internal_prefix << leaf->GetParentPageId() << ":p" << leaf->GetPageId() << " -> " << leaf_prefix
-          << leaf->GetPageId() << ";\n";
-    }
   } else {
     auto *inner = reinterpret_cast<InternalPage *>(page);
     // Print node name
@@ -252,14 +983,12 @@ void BPLUSTREE_TYPE::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::o
     out << "</TR>";
     // Print table end
     out << "</TABLE>>];\n";
-    // Print Parent link
-    if (inner->GetParentPageId() != INVALID_PAGE_ID) {
-      out << internal_prefix << inner->GetParentPageId() << ":p" << inner->GetPageId() << " -> " << internal_prefix
-          << inner->GetPageId() << ";\n";
-    }
     // Print leaves
     for (int i = 0; i < inner->GetSize(); i++) {
       auto child_page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(inner->ValueAt(i))->GetData());
+      // Print the link to the child; pages do not keep their parent page id
+      out << internal_prefix << inner->GetPageId() << ":p" << child_page->GetPageId() << " -> "
+          << (child_page->IsLeafPage() ? leaf_prefix : internal_prefix) << child_page->GetPageId() << ";\n";
       ToGraph(child_page, bpm, out);
       if (i > 0) {
         auto sibling_page = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(inner->ValueAt(i - 1))->GetData());
@@ -286,8 +1015,7 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
   if (page->IsLeafPage()) {
     auto *leaf = reinterpret_cast<LeafPage *>(page);
-    std::cout << "Leaf Page: " << leaf->GetPageId() << " parent: " << leaf->GetParentPageId()
-              << " next: " << leaf->GetNextPageId() << std::endl;
+    std::cout << "Leaf Page: " << leaf->GetPageId() << " next: " << leaf->GetNextPageId() << std::endl;
     for (int i = 0; i < leaf->GetSize(); i++) {
       std::cout << leaf->KeyAt(i) << ",";
     }
@@ -295,7 +1023,7 @@ void BPLUSTREE_TYPE::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const
     std::cout << std::endl;
   } else {
     auto *internal = reinterpret_cast<InternalPage *>(page);
-    std::cout << "Internal Page: " << internal->GetPageId() << " parent: " << internal->GetParentPageId() << std::endl;
+    std::cout << "Internal Page: " << internal->GetPageId() << std::endl;
     for (int i = 0; i < internal->GetSize(); i++) {
       std::cout << internal->KeyAt(i) << ": " << internal->ValueAt(i) << ",";
     }
@@ -314,4 +1042,10 @@ template class BPlusTree<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTree<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
 
+template class BPlusTree<NormalizedKey<4>, RID, NormalizedComparator<4>>;
+template class BPlusTree<NormalizedKey<8>, RID, NormalizedComparator<8>>;
+template class BPlusTree<NormalizedKey<16>, RID, NormalizedComparator<16>>;
+template class BPlusTree<NormalizedKey<32>, RID, NormalizedComparator<32>>;
+template class BPlusTree<NormalizedKey<64>, RID, NormalizedComparator<64>>;
+
 }  // namespace bustub
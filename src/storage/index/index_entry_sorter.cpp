@@ -0,0 +1,165 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_entry_sorter.cpp
+//
+// Identification: src/storage/index/index_entry_sorter.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/index_entry_sorter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
+#include "common/rid.h"
+
+namespace bustub {
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEX_ENTRY_SORTER_TYPE::IndexEntrySorter(BufferPoolManager *bpm, const KeyComparator &comparator,
+                                          size_t memory_budget)
+    : bpm_(bpm), comparator_(comparator), max_buffered_(std::max<size_t>(memory_budget / sizeof(MappingType), 1)) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEX_ENTRY_SORTER_TYPE::~IndexEntrySorter() {
+  for (auto &run : runs_) {
+    run.guard_.Drop();
+    for (size_t i = run.deleted_pages_; i < run.pages_.size(); i++) {
+      bpm_->DeletePage(run.pages_[i]);
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEX_ENTRY_SORTER_TYPE::Add(const KeyType &key, const ValueType &value) {
+  BUSTUB_ASSERT(!finished_, "entries must be added before Finish()");
+  buffer_.emplace_back(key, value);
+  if (buffer_.size() == max_buffered_) {
+    Spill();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEX_ENTRY_SORTER_TYPE::Spill() {
+  std::stable_sort(buffer_.begin(), buffer_.end(),
+                   [this](const MappingType &a, const MappingType &b) { return comparator_(a.first, b.first) < 0; });
+  Run run;
+  run.size_ = buffer_.size();
+  for (size_t begin = 0; begin < buffer_.size(); begin += ENTRIES_PER_PAGE) {
+    page_id_t page_id;
+    auto guard = bpm_->NewPageGuarded(&page_id, AccessType::Scan);
+    if (!guard.IsValid()) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "IndexEntrySorter: no frame to spill a run");
+    }
+    size_t count = std::min(ENTRIES_PER_PAGE, buffer_.size() - begin);
+    memcpy(guard.GetDataMut(), buffer_.data() + begin, count * sizeof(MappingType));
+    run.pages_.push_back(page_id);
+  }
+  runs_.push_back(std::move(run));
+  buffer_.clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEX_ENTRY_SORTER_TYPE::Finish() {
+  BUSTUB_ASSERT(!finished_, "Finish() must be called once");
+  finished_ = true;
+  if (runs_.empty()) {
+    // Everything fits in memory: no merge needed.
+    std::stable_sort(buffer_.begin(), buffer_.end(),
+                     [this](const MappingType &a, const MappingType &b) { return comparator_(a.first, b.first) < 0; });
+    return;
+  }
+  if (!buffer_.empty()) {
+    Spill();
+  }
+  buffer_.shrink_to_fit();
+  for (size_t i = 0; i < runs_.size(); i++) {
+    if (Advance(&runs_[i])) {
+      const auto *entries = runs_[i].guard_.template As<MappingType>();
+      heap_.emplace_back(entries[(runs_[i].next_ - 1) % ENTRIES_PER_PAGE], i);
+    }
+  }
+  std::make_heap(heap_.begin(), heap_.end(), [this](const auto &a, const auto &b) { return After(a, b); });
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEX_ENTRY_SORTER_TYPE::Next(MappingType *item) -> bool {
+  BUSTUB_ASSERT(finished_, "Finish() must be called before Next()");
+  if (runs_.empty()) {
+    if (buffer_next_ == buffer_.size()) {
+      return false;
+    }
+    *item = buffer_[buffer_next_++];
+    return true;
+  }
+
+  if (heap_.empty()) {
+    return false;
+  }
+  auto after = [this](const auto &a, const auto &b) { return After(a, b); };
+  std::pop_heap(heap_.begin(), heap_.end(), after);
+  *item = heap_.back().first;
+  size_t run_index = heap_.back().second;
+  heap_.pop_back();
+  auto &run = runs_[run_index];
+  if (Advance(&run)) {
+    const auto *entries = run.guard_.template As<MappingType>();
+    heap_.emplace_back(entries[(run.next_ - 1) % ENTRIES_PER_PAGE], run_index);
+    std::push_heap(heap_.begin(), heap_.end(), after);
+  }
+  return true;
+}
+
+/*
+ * next_ counts the entries of the run handed to the heap so far, so the entry
+ * the heap holds for a run is next_ - 1. Moving past the last entry of a page
+ * deletes the page: the heap holds a copy of everything read from it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEX_ENTRY_SORTER_TYPE::Advance(Run *run) -> bool {
+  if (run->next_ == run->size_ || run->next_ % ENTRIES_PER_PAGE == 0) {
+    if (run->guard_.IsValid()) {
+      run->guard_.Drop();
+      bpm_->DeletePage(run->pages_[run->deleted_pages_++]);
+    }
+  }
+  if (run->next_ == run->size_) {
+    return false;
+  }
+  if (run->next_ % ENTRIES_PER_PAGE == 0) {
+    page_id_t page_id = run->pages_[run->next_ / ENTRIES_PER_PAGE];
+    run->guard_ = bpm_->FetchPageRead(page_id, AccessType::Scan);
+    if (!run->guard_.IsValid()) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "IndexEntrySorter: no frame to merge a run");
+    }
+  }
+  run->next_++;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEX_ENTRY_SORTER_TYPE::After(const std::pair<MappingType, size_t> &a,
+                                    const std::pair<MappingType, size_t> &b) const -> bool {
+  int cmp = comparator_(a.first.first, b.first.first);
+  // Earlier runs hold entries that were added earlier.
+  return cmp != 0 ? cmp > 0 : a.second > b.second;
+}
+
+template class IndexEntrySorter<GenericKey<4>, RID, GenericComparator<4>>;
+template class IndexEntrySorter<GenericKey<8>, RID, GenericComparator<8>>;
+template class IndexEntrySorter<GenericKey<16>, RID, GenericComparator<16>>;
+template class IndexEntrySorter<GenericKey<32>, RID, GenericComparator<32>>;
+template class IndexEntrySorter<GenericKey<64>, RID, GenericComparator<64>>;
+
+template class IndexEntrySorter<NormalizedKey<4>, RID, NormalizedComparator<4>>;
+template class IndexEntrySorter<NormalizedKey<8>, RID, NormalizedComparator<8>>;
+template class IndexEntrySorter<NormalizedKey<16>, RID, NormalizedComparator<16>>;
+template class IndexEntrySorter<NormalizedKey<32>, RID, NormalizedComparator<32>>;
+template class IndexEntrySorter<NormalizedKey<64>, RID, NormalizedComparator<64>>;
+
+}  // namespace bustub
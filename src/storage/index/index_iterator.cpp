@@ -2,29 +2,109 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <utility>
 
+#include "common/exception.h"
 #include "storage/index/index_iterator.h"
 
 namespace bustub {
 
-/*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
- */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator() = default;
 
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, ReadPageGuard guard, int index, bool postings)
+    : bpm_(bpm), guard_(std::move(guard)), page_id_(guard_.PageId()), index_(index), postings_(postings) {
+  if (guard_.IsValid()) {
+    ReadAhead();
+  }
+  SkipExhaustedLeaves();
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::~IndexIterator() = default;  // NOLINT
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::IsEnd() -> bool { throw std::runtime_error("unimplemented"); }
+auto INDEXITERATOR_TYPE::IsEnd() -> bool { return !guard_.IsValid(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator*() -> const MappingType & {
+  // Keys are stored compressed, so the entry is put together here.
+  item_ = guard_.template As<B_PLUS_TREE_LEAF_PAGE_TYPE>()->GetItem(index_);
+  if (posting_guard_.IsValid()) {
+    item_.second = posting_guard_.template As<BPlusTreePostingPage<ValueType>>()->ValueAt(posting_index_);
+  }
+  return item_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
+  if (posting_guard_.IsValid()) {
+    const auto *page = posting_guard_.template As<BPlusTreePostingPage<ValueType>>();
+    if (++posting_index_ < page->GetSize()) {
+      return *this;
+    }
+    if (page->GetNextPageId() != INVALID_PAGE_ID) {
+      FetchPostingPage(page->GetNextPageId());
+      return *this;
+    }
+    posting_guard_.Drop();
+    posting_page_id_ = INVALID_PAGE_ID;
+    posting_index_ = 0;
+  }
+  index_++;
+  SkipExhaustedLeaves();
+  return *this;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator*() -> const MappingType & { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  while (guard_.IsValid()) {
+    const auto *leaf = guard_.template As<B_PLUS_TREE_LEAF_PAGE_TYPE>();
+    if (index_ < leaf->GetSize()) {
+      if (postings_ && IsPostingListRef(leaf->ValueAt(index_))) {
+        FetchPostingPage(PostingListPageId(leaf->ValueAt(index_)));
+      }
+      return;
+    }
+    page_id_t next_page_id = leaf->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      guard_.Drop();
+      page_id_ = INVALID_PAGE_ID;
+      index_ = 0;
+      return;
+    }
+    // The next leaf is latched before the assignment unlatches this one.
+    guard_ = bpm_->FetchPageRead(next_page_id, AccessType::Index);
+    if (!guard_.IsValid()) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "IndexIterator: no frame for the next leaf");
+    }
+    page_id_ = next_page_id;
+    index_ = 0;
+    ReadAhead();
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & { throw std::runtime_error("unimplemented"); }
+void INDEXITERATOR_TYPE::ReadAhead() {
+  page_id_t next_page_id = guard_.template As<B_PLUS_TREE_LEAF_PAGE_TYPE>()->GetNextPageId();
+  if (next_page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  // Leaves that follow each other on disk, like the ones a bulk load lays out in the extents of the tree, are read
+  // ahead as a run; otherwise only the next leaf is known.
+  bpm_->Prefetch(next_page_id, next_page_id == page_id_ + 1 ? READ_AHEAD_PAGES : 1, AccessType::Index);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::FetchPostingPage(page_id_t page_id) {
+  posting_guard_ = bpm_->FetchPageRead(page_id, AccessType::Index);
+  if (!posting_guard_.IsValid()) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "IndexIterator: no frame for a posting page");
+  }
+  posting_page_id_ = page_id;
+  posting_index_ = 0;
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
@@ -36,4 +116,14 @@ template class IndexIterator<GenericKey<32>, RID, GenericComparator<32>>;
 
 template class IndexIterator<GenericKey<64>, RID, GenericComparator<64>>;
 
+template class IndexIterator<NormalizedKey<4>, RID, NormalizedComparator<4>>;
+
+template class IndexIterator<NormalizedKey<8>, RID, NormalizedComparator<8>>;
+
+template class IndexIterator<NormalizedKey<16>, RID, NormalizedComparator<16>>;
+
+template class IndexIterator<NormalizedKey<32>, RID, NormalizedComparator<32>>;
+
+template class IndexIterator<NormalizedKey<64>, RID, NormalizedComparator<64>>;
+
 }  // namespace bustub
@@ -9,14 +9,46 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 
 #include "common/exception.h"
+#include "common/macros.h"
 #include "common/rid.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
 
+namespace {
+
+/** @return the length of key without the zero bytes at its end */
+template <typename KeyType>
+auto KeyLength(const KeyType &key) -> size_t {
+  const auto *bytes = reinterpret_cast<const char *>(&key);
+  size_t length = sizeof(KeyType);
+  while (length > 0 && bytes[length - 1] == 0) {
+    length--;
+  }
+  return length;
+}
+
+auto CommonPrefixLength(const char *a, size_t a_length, const char *b, size_t b_length) -> size_t {
+  size_t length = std::min(a_length, b_length);
+  size_t i = 0;
+  while (i < length && a[i] == b[i]) {
+    i++;
+  }
+  return i;
+}
+
+/** @return the bytes of a page that holds count keys of key_bytes bytes in all, which share a prefix of prefix bytes */
+auto PackedSize(size_t count, size_t slot_size, size_t key_bytes, size_t prefix) -> size_t {
+  return LEAF_PAGE_HEADER_SIZE + count * slot_size + prefix + key_bytes - count * prefix;
+}
+
+}  // namespace
+
 /*****************************************************************************
  * HELPER METHODS AND UTILITIES
  *****************************************************************************/
@@ -27,31 +59,398 @@ namespace bustub {
  * next page id and set max size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {
+  SetPageType(IndexPageType::LEAF_PAGE);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetMaxSize(max_size);
+  Rebuild(nullptr, 0);
+}
 
 /**
  * Helper methods to set/get next page id
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const -> page_id_t { return INVALID_PAGE_ID; }
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const -> page_id_t { return next_page_id_; }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
 
 /*
  * Helper method to find and return the key associated with input "index"(a.k.a
- * array offset)
+ * array offset): the prefix of the page, then the bytes of the slot, padded
+ * with zeros.
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType {
-  // replace with your own code
-  KeyType key{};
+  KeyType key;
+  auto *bytes = reinterpret_cast<char *>(&key);
+  const Slot &slot = slots_[index];
+  memcpy(bytes, Data() + prefix_offset_, prefix_length_);
+  memcpy(bytes + prefix_length_, Data() + slot.offset_, slot.length_);
+  memset(bytes + prefix_length_ + slot.length_, 0, sizeof(KeyType) - prefix_length_ - slot.length_);
   return key;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAt(int index) const -> ValueType { return slots_[index].value_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetValueAt(int index, const ValueType &value) { slots_[index].value_ = value; }
+
+/*
+ * Helper method to find and return the key & value pair associated with input
+ * "index"(a.k.a array offset)
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const -> MappingType { return {KeyAt(index), ValueAt(index)}; }
+
+/**
+ * Helper method to find the first index i so that array[i].first >= key.
+ * Keys that memcmp() orders are compared where they are stored: the key is
+ * compared with the prefix of the page once, and then with the rest of each
+ * key, rather than put together and handed to the comparator.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator) const -> int {
+  int lo = 0;
+  int hi = GetSize();
+  if constexpr (IsBinaryComparable<KeyComparator>::value) {
+    const auto *bytes = reinterpret_cast<const char *>(&key);
+    int cmp = memcmp(bytes, Data() + prefix_offset_, prefix_length_);
+    if (cmp != 0) {
+      return cmp < 0 ? 0 : GetSize();
+    }
+    size_t length = KeyLength(key);
+    while (lo < hi) {
+      int mid = lo + (hi - lo) / 2;
+      if (CompareSuffix(mid, bytes, length) < 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+  } else {
+    while (lo < hi) {
+      int mid = lo + (hi - lo) / 2;
+      if (comparator(KeyAt(mid), key) < 0) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+  }
+  return lo;
+}
+
+/*
+ * Keys are zero beyond their length, so of two keys that agree on the bytes
+ * of the shorter one, the longer one is larger.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::CompareSuffix(int index, const char *key, size_t length) const -> int {
+  const Slot &slot = slots_[index];
+  int cmp = memcmp(Data() + slot.offset_, key + prefix_length_, slot.length_);
+  if (cmp != 0) {
+    return cmp;
+  }
+  return prefix_length_ + slot.length_ < length ? -1 : 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::FindKey(const KeyType &key, const KeyComparator &comparator) const -> int {
+  int index = KeyIndex(key, comparator);
+  if (index == GetSize() || comparator(KeyAt(index), key) != 0) {
+    return -1;
+  }
+  return index;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::GetUsedBytes() const -> size_t {
+  return PackedSize(GetSize(), SLOT_SIZE, key_bytes_, prefix_length_);
+}
+
+/*****************************************************************************
+ * SIZE CHECKS
+ *****************************************************************************/
+/*
+ * The key fits if the page stays under its max size and its logical capacity,
+ * and the page, with the prefix the key leaves to it, is no larger than a page
+ * once its key bytes are compacted.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::CanInsert(const KeyType &key, double fill_factor) const -> bool {
+  size_t length = KeyLength(key);
+  size_t count = GetSize() + 1;
+  size_t prefix = GetSize() == 0 ? length
+                                 : CommonPrefixLength(Data() + prefix_offset_, prefix_length_,
+                                                      reinterpret_cast<const char *>(&key), length);
+  auto page_capacity = static_cast<double>(BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE);
+  return static_cast<int>(count) < GetMaxSize() &&
+         static_cast<double>(count * SLOT_SIZE + key_bytes_ + length) <= fill_factor * LOGICAL_CAPACITY &&
+         static_cast<double>(PackedSize(count, SLOT_SIZE, key_bytes_ + length, prefix) - LEAF_PAGE_HEADER_SIZE) <=
+             fill_factor * page_capacity;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::IsUnderflow() const -> bool {
+  return GetSize() < GetMinSize() && LogicalSize() < MIN_LOGICAL_BYTES;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::UnderflowsWithout(int index) const -> bool {
+  size_t entry_size = SLOT_SIZE + prefix_length_ + slots_[index].length_;
+  return GetSize() - 1 < GetMinSize() && LogicalSize() - entry_size < MIN_LOGICAL_BYTES;
+}
+
+/*
+ * The shared prefix of the stored prefixes may be shorter than the one the
+ * merged keys really share, so this errs on the side of not merging.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::CanMergeWith(const BPlusTreeLeafPage *other) const -> bool {
+  if (GetSize() == 0 || other->GetSize() == 0) {
+    return GetSize() + other->GetSize() < GetMaxSize();
+  }
+  size_t count = GetSize() + other->GetSize();
+  size_t key_bytes = key_bytes_ + other->key_bytes_;
+  size_t prefix = CommonPrefixLength(Data() + prefix_offset_, prefix_length_, other->Data() + other->prefix_offset_,
+                                     other->prefix_length_);
+  return static_cast<int>(count) < GetMaxSize() && count * SLOT_SIZE + key_bytes <= LOGICAL_CAPACITY &&
+         PackedSize(count, SLOT_SIZE, key_bytes, prefix) <= BUSTUB_PAGE_SIZE;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::Fits(const MappingType *items, size_t count) const -> bool {
+  if (static_cast<int>(count) >= GetMaxSize()) {
+    return false;
+  }
+  size_t key_bytes = 0;
+  size_t prefix = count == 0 ? 0 : KeyLength(items[0].first);
+  const auto *first = reinterpret_cast<const char *>(&items[0].first);
+  for (size_t i = 0; i < count; i++) {
+    size_t length = KeyLength(items[i].first);
+    key_bytes += length;
+    prefix = CommonPrefixLength(first, prefix, reinterpret_cast<const char *>(&items[i].first), length);
+  }
+  return count * SLOT_SIZE + key_bytes <= LOGICAL_CAPACITY &&
+         PackedSize(count, SLOT_SIZE, key_bytes, prefix) <= BUSTUB_PAGE_SIZE;
+}
+
+/*****************************************************************************
+ * LAYOUT
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::Items() const -> std::vector<MappingType> {
+  std::vector<MappingType> items;
+  items.reserve(GetSize());
+  for (int i = 0; i < GetSize(); i++) {
+    items.push_back(GetItem(i));
+  }
+  return items;
+}
+
+/*
+ * The prefix goes at the end of the page and the key bytes of the entries
+ * below it, in order, leaving no gaps.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Rebuild(const MappingType *items, size_t count) {
+  size_t prefix = count == 0 ? 0 : KeyLength(items[0].first);
+  const char *first = count == 0 ? nullptr : reinterpret_cast<const char *>(&items[0].first);
+  for (size_t i = 1; i < count; i++) {
+    prefix = CommonPrefixLength(first, prefix, reinterpret_cast<const char *>(&items[i].first),
+                                KeyLength(items[i].first));
+  }
+  free_end_ = BUSTUB_PAGE_SIZE - prefix;
+  if (prefix > 0) {
+    memcpy(Data() + free_end_, first, prefix);
+  }
+  prefix_length_ = prefix;
+  prefix_offset_ = free_end_;
+  key_bytes_ = 0;
+  for (size_t i = 0; i < count; i++) {
+    size_t length = KeyLength(items[i].first);
+    free_end_ -= length - prefix;
+    memcpy(Data() + free_end_, reinterpret_cast<const char *>(&items[i].first) + prefix, length - prefix);
+    slots_[i] = {static_cast<uint16_t>(free_end_), static_cast<uint16_t>(length - prefix), items[i].second};
+    key_bytes_ += length;
+  }
+  SetSize(count);
+  BUSTUB_ASSERT(LEAF_PAGE_HEADER_SIZE + count * SLOT_SIZE <= free_end_, "leaf page overflow");
+}
+
+/*
+ * The key bytes go in the free space between the slots and the key bytes
+ * already there. The page is laid out anew if the key does not start with
+ * the prefix of the page, or if the free space is too small because removed
+ * entries left their bytes behind.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::InsertAt(int index, const KeyType &key, const ValueType &value) {
+  size_t length = KeyLength(key);
+  const auto *bytes = reinterpret_cast<const char *>(&key);
+  size_t free_begin = LEAF_PAGE_HEADER_SIZE + (GetSize() + 1) * SLOT_SIZE;
+  if (GetSize() == 0 || length < prefix_length_ || memcmp(bytes, Data() + prefix_offset_, prefix_length_) != 0 ||
+      free_begin + length - prefix_length_ > free_end_) {
+    auto items = Items();
+    items.insert(items.begin() + index, {key, value});
+    Rebuild(items.data(), items.size());
+    return;
+  }
+  free_end_ -= length - prefix_length_;
+  memcpy(Data() + free_end_, bytes + prefix_length_, length - prefix_length_);
+  std::move_backward(slots_ + index, slots_ + GetSize(), slots_ + GetSize() + 1);
+  slots_[index] = {static_cast<uint16_t>(free_end_), static_cast<uint16_t>(length - prefix_length_), value};
+  key_bytes_ += length;
+  IncreaseSize(1);
+}
+
+/*
+ * The key bytes of the entry stay where they are until the page is laid out
+ * anew. The prefix stays too: it is still shared by the keys that are left.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAt(int index) {
+  key_bytes_ -= prefix_length_ + slots_[index].length_;
+  std::move(slots_ + index + 1, slots_ + GetSize(), slots_ + index);
+  IncreaseSize(-1);
+  if (GetSize() == 0) {
+    Rebuild(nullptr, 0);
+  }
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+/*
+ * Insert key & value pair into leaf page ordered by key
+ * @return page size after insertion
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator)
+    -> int {
+  InsertAt(KeyIndex(key, comparator), key, value);
+  return GetSize();
+}
+
+/*****************************************************************************
+ * SPLIT
+ *****************************************************************************/
+/*
+ * A page that reaches its max size splits in two halves of equal size, as
+ * long as both fit. Otherwise it splits in two halves of about equal logical
+ * size, which always fit by the choice of LOGICAL_CAPACITY.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::InsertAndSplit(const KeyType &key, const ValueType &value,
+                                                const KeyComparator &comparator, BPlusTreeLeafPage *recipient) {
+  auto items = Items();
+  items.insert(items.begin() + KeyIndex(key, comparator), {key, value});
+  size_t count = items.size();
+  size_t keep = count / 2;
+  if (static_cast<int>(count) < GetMaxSize() || !Fits(items.data(), keep) ||
+      !Fits(items.data() + keep, count - keep)) {
+    size_t total = 0;
+    for (const auto &item : items) {
+      total += SLOT_SIZE + KeyLength(item.first);
+    }
+    size_t kept_bytes = 0;
+    keep = 0;
+    while (keep < count - 1 && 2 * kept_bytes < total) {
+      kept_bytes += SLOT_SIZE + KeyLength(items[keep].first);
+      keep++;
+    }
+  }
+  Rebuild(items.data(), keep);
+  recipient->Rebuild(items.data() + keep, count - keep);
+}
+
+/*****************************************************************************
+ * LOOKUP
+ *****************************************************************************/
+/*
+ * For the given key, check to see whether it exists in the leaf page. If it
+ * does, then store its corresponding value in input "value" and return true.
+ * If the key does not exist, then return false
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const
+    -> bool {
+  int index = FindKey(key, comparator);
+  if (index < 0) {
+    return false;
+  }
+  *value = ValueAt(index);
+  return true;
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+/*
+ * First look through leaf page to see whether delete key exist or not. If
+ * exist, perform deletion, otherwise return immediately.
+ * @return  page size after deletion
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) -> int {
+  int index = FindKey(key, comparator);
+  if (index >= 0) {
+    RemoveAt(index);
+  }
+  return GetSize();
+}
+
+/*****************************************************************************
+ * MERGE
+ *****************************************************************************/
+/*
+ * Remove all of key & value pairs from this page to "recipient" page. Don't forget
+ * to update the next_page id in the sibling page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
+  auto items = recipient->Items();
+  auto moved = Items();
+  items.insert(items.end(), moved.begin(), moved.end());
+  recipient->Rebuild(items.data(), items.size());
+  recipient->SetNextPageId(GetNextPageId());
+  Rebuild(nullptr, 0);
+}
+
+/*****************************************************************************
+ * REDISTRIBUTE
+ *****************************************************************************/
+/*
+ * Remove the first key & value pair from this page to "recipient" page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
+  recipient->InsertAt(recipient->GetSize(), KeyAt(0), ValueAt(0));
+  RemoveAt(0);
+}
+
+/*
+ * Remove the last key & value pair from this page to "recipient" page.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
+  recipient->InsertAt(0, KeyAt(GetSize() - 1), ValueAt(GetSize() - 1));
+  RemoveAt(GetSize() - 1);
+}
+
 template class BPlusTreeLeafPage<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeLeafPage<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTreeLeafPage<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>;
+
+template class BPlusTreeLeafPage<NormalizedKey<4>, RID, NormalizedComparator<4>>;
+template class BPlusTreeLeafPage<NormalizedKey<8>, RID, NormalizedComparator<8>>;
+template class BPlusTreeLeafPage<NormalizedKey<16>, RID, NormalizedComparator<16>>;
+template class BPlusTreeLeafPage<NormalizedKey<32>, RID, NormalizedComparator<32>>;
+template class BPlusTreeLeafPage<NormalizedKey<64>, RID, NormalizedComparator<64>>;
 }  // namespace bustub
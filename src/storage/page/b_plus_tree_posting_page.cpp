@@ -0,0 +1,49 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_posting_page.cpp
+//
+// Identification: src/storage/page/b_plus_tree_posting_page.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/b_plus_tree_posting_page.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+template <typename ValueType>
+void BPlusTreePostingPage<ValueType>::Init(page_id_t next_page_id) {
+  next_page_id_ = next_page_id;
+  size_ = 0;
+}
+
+template <typename ValueType>
+void BPlusTreePostingPage<ValueType>::Append(const ValueType &value) {
+  BUSTUB_ASSERT(size_ < CAPACITY, "posting page is full");
+  array_[size_++] = value;
+}
+
+template <typename ValueType>
+auto BPlusTreePostingPage<ValueType>::PopBack() -> ValueType {
+  BUSTUB_ASSERT(size_ > 0, "posting page is empty");
+  return array_[--size_];
+}
+
+template <typename ValueType>
+auto BPlusTreePostingPage<ValueType>::IndexOf(const ValueType &value) const -> int {
+  for (int i = 0; i < size_; i++) {
+    if (array_[i] == value) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+template class BPlusTreePostingPage<RID>;
+
+}  // namespace bustub
@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <cassert>
+#include <utility>
 
 #include "common/exception.h"
 #include "concurrency/transaction.h"
@@ -19,9 +20,9 @@
 namespace bustub {
 
 TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+    : table_heap_(table_heap), tuple_(rid), txn_(txn) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
-    if (!table_heap_->GetTuple(tuple_->rid_, tuple_, txn_)) {
+    if (!table_heap_->GetTuple(tuple_.rid_, &tuple_, txn_)) {
       throw bustub::Exception("read non-existing tuple");
     }
   }
@@ -29,48 +30,44 @@ TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
 
 auto TableIterator::operator*() -> const Tuple & {
   assert(*this != table_heap_->End());
-  return *tuple_;
+  return tuple_;
 }
 
 auto TableIterator::operator->() -> Tuple * {
   assert(*this != table_heap_->End());
-  return tuple_;
+  return &tuple_;
 }
 
 auto TableIterator::operator++() -> TableIterator & {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  BUSTUB_ENSURE(cur_page != nullptr, "BPM full");  // all pages are pinned
+  auto cur_page_guard = buffer_pool_manager->FetchPageRead(tuple_.rid_.GetPageId(), AccessType::Scan);
+  BUSTUB_ENSURE(cur_page_guard.IsValid(), "BPM full");  // all pages are pinned
 
-  cur_page->RLatch();
   RID next_tuple_rid;
-  if (!cur_page->GetNextTupleRid(tuple_->rid_,
-                                 &next_tuple_rid)) {  // end of this page
-    while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
-      if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
+  if (!cur_page_guard.As<TablePage>()->GetNextTupleRid(tuple_.rid_,
+                                                       &next_tuple_rid)) {  // end of this page
+    while (cur_page_guard.As<TablePage>()->GetNextPageId() != INVALID_PAGE_ID) {
+      auto next_page_id = cur_page_guard.As<TablePage>()->GetNextPageId();
+      // Pages of a table are mostly allocated in page id order, so read ahead of the page we are moving to.
+      buffer_pool_manager->Prefetch(next_page_id + 1, READ_AHEAD_PAGES, AccessType::Scan);
+      auto next_page_guard = buffer_pool_manager->FetchPageRead(next_page_id, AccessType::Scan);
+      BUSTUB_ENSURE(next_page_guard.IsValid(), "BPM full");
+      cur_page_guard = std::move(next_page_guard);
+      if (cur_page_guard.As<TablePage>()->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
     }
   }
-  tuple_->rid_ = next_tuple_rid;
+  tuple_.rid_ = next_tuple_rid;
 
   if (*this != table_heap_->End()) {
-    // DO NOT ACQUIRE READ LOCK twice in a single thread otherwise it may deadlock.
-    // See https://users.rust-lang.org/t/how-bad-is-the-potential-deadlock-mentioned-in-rwlocks-document/67234
-    if (!table_heap_->GetTuple(tuple_->rid_, tuple_, txn_, false)) {
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
+    // The tuple is on the page we already hold pinned and read-latched, so read it from there instead of fetching the
+    // page again through TableHeap::GetTuple().
+    if (!cur_page_guard.As<TablePage>()->GetTuple(tuple_.rid_, &tuple_, txn_, table_heap_->lock_manager_)) {
       throw bustub::Exception("read non-existing tuple");
     }
   }
-  // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
+  // The guard releases the page once the tuple is copied.
   return *this;
 }
 
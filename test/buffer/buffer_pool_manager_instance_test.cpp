@@ -12,13 +12,27 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <csignal>
 #include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>  // NOLINT
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/exception.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 
@@ -84,6 +98,7 @@ TEST(BufferPoolManagerInstanceTest, BinaryDataTest) {
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
   remove("test.db");
+  DiskManager::RemoveSidecarFiles("test.db");
 
   delete bpm;
   delete disk_manager;
@@ -141,9 +156,748 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   // Shutdown the disk manager and remove the temporary file we created.
   disk_manager->ShutDown();
   remove("test.db");
+  DiskManager::RemoveSidecarFiles("test.db");
 
   delete bpm;
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentFetchTest) {
+  // Threads fetch and unpin a working set twice the size of the pool, so lock-free hits race with evictions.
+  const size_t buffer_pool_size = 16;
+  const size_t num_pages = 2 * buffer_pool_size;
+  const size_t num_threads = 4;
+  const size_t k = 2;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, tid]() {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+      for (int i = 0; i < 5000; i++) {
+        page_id_t page_id = dist(rng);
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(page_id, page->GetPageId());
+        EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(page_id).c_str()));
+        EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Every pin was returned, so the whole pool can be recycled again.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ScanResistanceTest) {
+  // A scan over many more pages than the pool holds must not push out a hot working set.
+  const size_t buffer_pool_size = 64;
+  const size_t num_hot_pages = 16;
+  const size_t num_scan_pages = 1000;
+  const size_t k = 2;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < num_hot_pages + num_scan_pages; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Pages [0, num_hot_pages) are looked up repeatedly, the rest are only ever scanned.
+  for (int round = 0; round < 3; round++) {
+    for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(num_hot_pages); page_id++) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id, AccessType::Lookup));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+  }
+  for (page_id_t page_id = num_hot_pages; page_id < static_cast<page_id_t>(num_hot_pages + num_scan_pages);
+       page_id++) {
+    auto *page = bpm->FetchPage(page_id, AccessType::Scan);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, page->GetPageId());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  std::unordered_set<page_id_t> resident;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    resident.insert(bpm->GetPages()[i].GetPageId());
+  }
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(num_hot_pages); page_id++) {
+    EXPECT_EQ(1U, resident.count(page_id)) << "hot page " << page_id << " was evicted by the scan";
+  }
+
+  // Scenario: a page the scan brought in stops being recycled by the ring once someone else uses it.
+  page_id_t last_scanned = num_hot_pages + num_scan_pages - 1;
+  ASSERT_NE(nullptr, bpm->FetchPage(last_scanned));
+  EXPECT_EQ(true, bpm->UnpinPage(last_scanned, false));
+  for (page_id_t page_id = num_hot_pages; page_id < static_cast<page_id_t>(2 * num_hot_pages + SCAN_RING_SIZE);
+       page_id++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id, AccessType::Scan));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  bool found = false;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    found = found || bpm->GetPages()[i].GetPageId() == last_scanned;
+  }
+  EXPECT_TRUE(found);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BackgroundFlushTest) {
+  const size_t buffer_pool_size = 16;
+  const size_t num_pages = 4 * buffer_pool_size;
+  const size_t num_threads = 4;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  // Scenario: once started, the flusher cleans every unpinned dirty page when asked to keep all frames clean.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  bpm->StartBackgroundFlusher(1.0);
+  auto all_clean_but_pinned = [bpm]() {
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      auto &page = bpm->GetPages()[i];
+      if (page.IsDirty() != (page.GetPageId() == 1)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  for (int i = 0; i < 1000 && !all_clean_but_pinned(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_TRUE(all_clean_but_pinned());
+  EXPECT_EQ(true, bpm->UnpinPage(1, false));
+
+  // Scenario: writers dirty pages concurrently with the flusher and with evictions; no update is lost.
+  for (size_t i = buffer_pool_size; i < num_pages; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    snprintf(bpm->FetchPage(page_id_temp)->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, tid]() {
+      // Each thread owns the pages congruent to tid and appends to them, so the final content is deterministic.
+      for (int round = 0; round < 20; round++) {
+        for (page_id_t page_id = tid; page_id < static_cast<page_id_t>(num_pages); page_id += num_threads) {
+          auto *page = bpm->FetchPage(page_id);
+          if (page == nullptr) {
+            page_id -= num_threads;
+            std::this_thread::yield();
+            continue;
+          }
+          page->WLatch();
+          page->GetData()[BUSTUB_PAGE_SIZE - 1 - round] = static_cast<char>('a' + round);
+          page->WUnlatch();
+          EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  bpm->StopBackgroundFlusher();
+
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(num_pages); page_id++) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(page_id).c_str()));
+    for (int round = 0; round < 20; round++) {
+      EXPECT_EQ(static_cast<char>('a' + round), page->GetData()[BUSTUB_PAGE_SIZE - 1 - round]);
+    }
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FlushAllPagesTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 10;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, page_id_temp != 3));
+  }
+  // Page 3 is clean, so the dirty pages form the runs [0, 3) and [4, 10). Page 5 stays pinned during the flush.
+  auto *pinned = bpm->FetchPage(5);
+  ASSERT_NE(nullptr, pinned);
+  int writes_before = disk_manager->GetNumWrites();
+
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes_before + static_cast<int>(buffer_pool_size) - 1, disk_manager->GetNumWrites());
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_FALSE(bpm->GetPages()[i].IsDirty());
+  }
+  EXPECT_EQ(1, pinned->GetPinCount());
+  EXPECT_EQ(true, bpm->UnpinPage(5, false));
+
+  char buf[BUSTUB_PAGE_SIZE];
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); page_id++) {
+    if (page_id == 3) {
+      continue;
+    }
+    disk_manager->ReadPage(page_id, buf);
+    EXPECT_EQ(0, strcmp(buf, ("page " + std::to_string(page_id)).c_str()));
+  }
+
+  // Scenario: a second flush has nothing to write.
+  bpm->FlushAllPages();
+  EXPECT_EQ(writes_before + static_cast<int>(buffer_pool_size) - 1, disk_manager->GetNumWrites());
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, WriteErrorTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 2;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  // Scenario: while the file cannot grow, pages cannot be written back. They stay dirty in their frames, so that
+  // flushing them fails and a miss that would have to evict one of them finds no frame.
+  rlimit old_limit;
+  ASSERT_EQ(0, getrlimit(RLIMIT_FSIZE, &old_limit));
+  auto old_handler = signal(SIGXFSZ, SIG_IGN);
+  rlimit limit = old_limit;
+  limit.rlim_cur = 0;
+  ASSERT_EQ(0, setrlimit(RLIMIT_FSIZE, &limit));
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_EQ(false, bpm->FlushPage(0));
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  // Scenario: the two pages form one run for FlushAllPages, and both stay dirty when it cannot be written.
+  bpm->FlushAllPages();
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_TRUE(bpm->GetPages()[i].IsDirty());
+  }
+  setrlimit(RLIMIT_FSIZE, &old_limit);
+  signal(SIGXFSZ, old_handler);
+
+  // Scenario: once the writes go through again, the pages are written back with what they held.
+  EXPECT_EQ(true, bpm->FlushPage(0));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); page_id++) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ReusePageTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+  page_id_t page_id_temp;
+  for (int i = 0; i < 8; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: deleted pages are handed out again, lowest id first, whether they were resident or not.
+  EXPECT_EQ(true, bpm->DeletePage(5));
+  EXPECT_EQ(true, bpm->DeletePage(2));
+  EXPECT_EQ(2U, disk_manager->GetNumFreePages());
+
+  // Scenario: pages that are free already or were never allocated cannot be deleted, so that no id is handed out
+  // twice.
+  EXPECT_EQ(false, bpm->DeletePage(5));
+  EXPECT_EQ(false, bpm->DeletePage(2));
+  EXPECT_EQ(false, bpm->DeletePage(8));
+  EXPECT_EQ(2U, disk_manager->GetNumFreePages());
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(2, page_id_temp);
+  EXPECT_EQ(true, bpm->UnpinPage(2, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(5, page_id_temp);
+  EXPECT_EQ(true, bpm->UnpinPage(5, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(8, page_id_temp);
+  EXPECT_EQ(true, bpm->UnpinPage(8, false));
+
+  // Scenario: a reused page is empty, even after it was evicted without being modified.
+  for (page_id_t page_id : {0, 1, 3, 4}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  for (page_id_t page_id : {2, 5}) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, page->GetData()[0]);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: the file shrinks once the pages at its end are deleted. Page 8 was never written.
+  bpm->FlushAllPages();
+  for (page_id_t page_id : {6, 7, 8}) {
+    EXPECT_EQ(true, bpm->DeletePage(page_id));
+  }
+  EXPECT_EQ(2U, disk_manager->Compact());
+  EXPECT_EQ(6 * BUSTUB_PAGE_SIZE, std::ifstream(db_name, std::ios::binary | std::ios::ate).tellg());
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, CorruptPageTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+  const int num_pages = 8;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+  page_id_t page_id_temp;
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+
+  // Flip a byte of page 6 on disk, behind the disk manager's back.
+  {
+    std::fstream file(db_name, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(6 * BUSTUB_PAGE_SIZE + 100);
+    file.put('x');
+  }
+
+  // Scenario: fetching the corrupted page throws and leaves the pool usable.
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+  for (int i = 0; i < num_pages; i++) {
+    bpm->NewPage(&page_id_temp);
+    bpm->UnpinPage(page_id_temp, false);
+  }
+  // Fetch the first pages, which evicts the last ones.
+  for (page_id_t page_id : {0, 1, 2, 3, 6, 7}) {
+    if (page_id == 6) {
+      EXPECT_THROW(bpm->FetchPage(6), Exception);
+      continue;
+    }
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: a prefetch of the corrupted page does not hand it out either.
+  bpm->Prefetch(4, 3, AccessType::Scan);
+  EXPECT_THROW(bpm->FetchPage(6, AccessType::Scan), Exception);
+  for (page_id_t page_id : {4, 5}) {
+    auto *page = bpm->FetchPage(page_id, AccessType::Scan);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_id)).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(true, bpm->DeletePage(6));
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const size_t buffer_pool_size = 16;
+  const size_t num_pages = 4 * buffer_pool_size;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: prefetched pages become resident, and fetching them right away waits for the reads to complete.
+  bpm->Prefetch(0, 8);
+  for (page_id_t page_id = 0; page_id < 8; page_id++) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(page_id).c_str()));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: pages that were never allocated are not read.
+  bpm->Prefetch(num_pages, 8);
+  std::unordered_set<page_id_t> resident;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    resident.insert(bpm->GetPages()[i].GetPageId());
+  }
+  EXPECT_EQ(0U, resident.count(num_pages));
+
+  // Scenario: a scan reads ahead while other threads fetch and flush the same pages.
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < 4; tid++) {
+    threads.emplace_back([bpm, tid]() {
+      for (int round = 0; round < 50; round++) {
+        for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(num_pages); page_id++) {
+          if (tid == 0) {
+            bpm->Prefetch(page_id + 1, READ_AHEAD_PAGES, AccessType::Scan);
+          }
+          if (tid == 3 && page_id % 8 == 0) {
+            bpm->FlushPage(page_id);
+          }
+          auto *page = bpm->FetchPage(page_id, tid == 0 ? AccessType::Scan : AccessType::Unknown);
+          if (page == nullptr) {
+            continue;
+          }
+          EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(page_id).c_str()));
+          EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Scenario: destroying the pool with reads in flight waits for them.
+  bpm->Prefetch(0, num_pages);
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ExtentPrefetchTest) {
+  const size_t buffer_pool_size = 8;
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  auto count_frames = [bpm](page_id_t page_id) {
+    size_t frames = 0;
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      frames += bpm->GetPages()[i].GetPageId() == page_id ? 1 : 0;
+    }
+    return frames;
+  };
+
+  // Scenario: reading ahead into an extent skips the pages that have not been created yet, and free pages.
+  page_id_t page_id_temp;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  EXPECT_EQ(true, bpm->DeletePage(page_id_temp));
+  const page_id_t first = bpm->AllocateExtent(4);
+  ASSERT_NE(nullptr, bpm->NewPageAt(first));
+  EXPECT_EQ(true, bpm->UnpinPage(first, false));
+  bpm->Prefetch(page_id_temp, 5);
+  bpm->FlushAllPages();
+  EXPECT_EQ(0, count_frames(page_id_temp));
+  EXPECT_EQ(1, count_frames(first));
+  for (page_id_t page_id = first + 1; page_id < first + 4; page_id++) {
+    EXPECT_EQ(0, count_frames(page_id));
+  }
+
+  // Scenario: a page fetched before it was created keeps a single frame once it is created, so that its data is not
+  // lost when the stale copy is evicted.
+  ASSERT_NE(nullptr, bpm->FetchPage(first + 1));
+  EXPECT_EQ(true, bpm->UnpinPage(first + 1, false));
+  auto *page = bpm->NewPageAt(first + 1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(1, count_frames(first + 1));
+  snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "created");
+  EXPECT_EQ(true, bpm->UnpinPage(first + 1, true));
+  for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+  page = bpm->FetchPage(first + 1);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("created", page->GetData());
+  EXPECT_EQ(true, bpm->UnpinPage(first + 1, false));
+
+  // Scenario: the id of a pinned page is not created again.
+  ASSERT_NE(nullptr, bpm->FetchPage(first + 2));
+  EXPECT_EQ(nullptr, bpm->NewPageAt(first + 2));
+  EXPECT_EQ(true, bpm->UnpinPage(first + 2, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, StatsTest) {
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_EQ(0U, bpm->GetStats().evictions_);
+
+  IoStats query_stats;
+  {
+    QueryIoScope io_scope(&query_stats);
+    // Scenario: a new page evicts dirty page 0, and fetching page 0 again misses and evicts the clean new page.
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+    ASSERT_NE(nullptr, bpm->FetchPage(0));
+    // Scenario: fetching it once more hits.
+    ASSERT_NE(nullptr, bpm->FetchPage(0));
+    EXPECT_EQ(true, bpm->UnpinPage(0, false));
+    EXPECT_EQ(true, bpm->UnpinPage(0, false));
+  }
+  // Scenario: I/O outside the scope is not the query's.
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(2U, stats.hits_);
+  EXPECT_EQ(1U, stats.misses_);
+  EXPECT_EQ(2U, stats.evictions_);
+  EXPECT_EQ(1U, stats.dirty_evictions_);
+  auto disk_stats = disk_manager->GetStats();
+  EXPECT_EQ(static_cast<uint64_t>(BUSTUB_PAGE_SIZE), disk_stats.read_bytes_);
+  EXPECT_EQ(static_cast<uint64_t>(BUSTUB_PAGE_SIZE), disk_stats.write_bytes_);
+
+  EXPECT_EQ(1U, query_stats.hits_);
+  EXPECT_EQ(1U, query_stats.misses_);
+  EXPECT_EQ(2U, query_stats.evictions_);
+  EXPECT_EQ(1U, query_stats.dirty_evictions_);
+  EXPECT_EQ(disk_stats.read_bytes_, query_stats.read_bytes_);
+  EXPECT_EQ(disk_stats.write_bytes_, query_stats.write_bytes_);
+  EXPECT_DOUBLE_EQ(0.5, query_stats.GetHitRatio());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+/**
+ * Dirty every frame of a pool of `pool_bytes` and flush it, either with FlushAllPages() or the old way, with one
+ * FlushPage() per frame in frame order. Returns the throughput in MB/s.
+ */
+auto FlushAllPagesBenchmarkCall(size_t pool_bytes, bool batched) -> double {
+  const std::string db_name = "flush_bench.db";
+  const size_t pool_size = pool_bytes / BUSTUB_PAGE_SIZE;
+
+  remove(db_name.c_str());
+  auto disk_manager = std::make_unique<DiskManager>(db_name);
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(pool_size, disk_manager.get(), 2);
+
+  // Hand the frames out in a shuffled order, as they would be after the pool has been running for a while, so that
+  // frame order and page order differ.
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id;
+  for (size_t i = 0; i < pool_size; i++) {
+    bpm->NewPage(&page_id);
+    page_ids.push_back(page_id);
+  }
+  std::shuffle(page_ids.begin(), page_ids.end(), std::mt19937(0));
+  for (auto id : page_ids) {
+    bpm->UnpinPage(id, false);
+    bpm->DeletePage(id);
+  }
+  for (size_t i = 0; i < pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    memset(page->GetData(), static_cast<int>(page_id), BUSTUB_PAGE_SIZE);
+    bpm->UnpinPage(page_id, true);
+  }
+  std::vector<page_id_t> frame_order;
+  for (size_t i = 0; i < pool_size; i++) {
+    frame_order.push_back(bpm->GetPages()[i].GetPageId());
+  }
+
+  auto clock_start = std::chrono::steady_clock::now();
+  if (batched) {
+    bpm->FlushAllPages();
+  } else {
+    for (auto id : frame_order) {
+      bpm->FlushPage(id);
+    }
+    disk_manager->Sync();
+  }
+  auto clock_end = std::chrono::steady_clock::now();
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("flush_bench.log");
+  DiskManager::RemoveSidecarFiles("flush_bench.db");
+  double seconds = std::chrono::duration<double>(clock_end - clock_start).count();
+  return static_cast<double>(pool_bytes) / (1 << 20) / seconds;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageIdLimitTest) {
+  const size_t buffer_pool_size = 4;
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Scenario: the last page id is handed out, and then allocation fails instead of wrapping around.
+  const auto max_page_id = std::numeric_limits<page_id_t>::max();
+  EXPECT_EQ(0, bpm->AllocateExtent(max_page_id - 1));
+  EXPECT_EQ(INVALID_PAGE_ID, bpm->AllocateExtent(2));
+  page_id_t page_id_temp;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(max_page_id - 1, page_id_temp);
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(INVALID_PAGE_ID, page_id_temp);
+
+  // Scenario: the frame a failed allocation claimed is handed back, and freed page ids are still reused.
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPageAt(static_cast<page_id_t>(i)));
+    EXPECT_EQ(true, bpm->UnpinPage(static_cast<page_id_t>(i), false));
+  }
+  EXPECT_EQ(true, bpm->DeletePage(2));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(2, page_id_temp);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerInstanceTest, DISABLED_FlushAllPagesBenchmark) {  // NOLINT
+  std::cout << "<<< BEGIN" << std::endl;
+  for (size_t pool_mb : {64, 256, 1024}) {
+    auto per_page = FlushAllPagesBenchmarkCall(pool_mb << 20, false);
+    auto batched = FlushAllPagesBenchmarkCall(pool_mb << 20, true);
+    std::cout << "pool=" << pool_mb << "MB per-page FlushPage: " << per_page << " MB/s, FlushAllPages: " << batched
+              << " MB/s" << std::endl;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+/**
+ * Have `num_threads` threads fetch and unpin random pages of a pool that holds all of them, so that every fetch is a
+ * hit, and return the fetches per second. With `serialize`, every fetch and unpin goes through one shared mutex, which
+ * is what a hit cost when it took the buffer pool latch.
+ */
+auto HitPathBenchmarkCall(size_t num_threads, bool serialize) -> double {
+  const size_t pool_size = 1024;
+  const size_t fetches_per_thread = 1000000;
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(pool_size, disk_manager.get(), 2);
+  page_id_t page_id;
+  for (size_t i = 0; i < pool_size; i++) {
+    bpm->NewPage(&page_id);
+    bpm->UnpinPage(page_id, false);
+  }
+
+  std::mutex serial_latch;
+  std::vector<std::thread> threads;
+  auto clock_start = std::chrono::steady_clock::now();
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid]() {
+      std::mt19937 rng(tid);
+      for (size_t i = 0; i < fetches_per_thread; i++) {
+        auto id = static_cast<page_id_t>(rng() % pool_size);
+        std::unique_lock<std::mutex> lock(serial_latch, std::defer_lock);
+        if (serialize) {
+          lock.lock();
+        }
+        bpm->FetchPage(id);
+        bpm->UnpinPage(id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto clock_end = std::chrono::steady_clock::now();
+  EXPECT_EQ(num_threads * fetches_per_thread, bpm->GetStats().hits_);
+  double seconds = std::chrono::duration<double>(clock_end - clock_start).count();
+  return static_cast<double>(num_threads * fetches_per_thread) / seconds;
+}
+
+TEST(BufferPoolManagerInstanceTest, DISABLED_HitPathBenchmark) {  // NOLINT
+  std::cout << "<<< BEGIN" << std::endl;
+  for (size_t num_threads : {1, 2, 4, 8, 16}) {
+    auto serialized = HitPathBenchmarkCall(num_threads, true);
+    auto lock_free = HitPathBenchmarkCall(num_threads, false);
+    std::cout << "threads=" << num_threads << " serialized: " << serialized / 1e6
+              << " M fetches/s, lock-free: " << lock_free / 1e6 << " M fetches/s" << std::endl;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
 }  // namespace bustub
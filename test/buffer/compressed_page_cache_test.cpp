@@ -0,0 +1,133 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache_test.cpp
+//
+// Identification: test/buffer/compressed_page_cache_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/compressed_page_cache.h"
+
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(CompressedPageCacheTest, BasicTest) {
+  char page[BUSTUB_PAGE_SIZE] = {0};
+  char output[BUSTUB_PAGE_SIZE];
+  CompressedPageCache cache(1024);
+
+  // Scenario: a page comes back as it went in, and only once.
+  snprintf(page, sizeof(page), "page %d", 1);
+  cache.Put(1, page);
+  EXPECT_TRUE(cache.Contains(1));
+  ASSERT_TRUE(cache.Get(1, output));
+  EXPECT_EQ(0, memcmp(page, output, BUSTUB_PAGE_SIZE));
+  EXPECT_FALSE(cache.Contains(1));
+  EXPECT_FALSE(cache.Get(1, output));
+
+  // Scenario: a page that does not compress is rejected.
+  std::mt19937 generator(15445);
+  char random[BUSTUB_PAGE_SIZE];
+  for (auto &c : random) {
+    c = static_cast<char>(generator());
+  }
+  cache.Put(2, random);
+  EXPECT_FALSE(cache.Contains(2));
+
+  // Scenario: the least recently stored pages make room for new ones once the budget is used up, and erased pages
+  // are gone.
+  for (page_id_t page_id = 0; page_id < 100; page_id++) {
+    snprintf(page, sizeof(page), "page %d", page_id);
+    cache.Put(page_id, page);
+  }
+  auto stats = cache.GetStats();
+  EXPECT_GE(1024U, stats.used_bytes_);
+  EXPECT_LT(1U, stats.num_pages_);
+  EXPECT_GT(100U, stats.num_pages_);
+  EXPECT_EQ(100 - stats.num_pages_, stats.evictions_);
+  EXPECT_EQ(1U, stats.rejections_);
+  EXPECT_FALSE(cache.Contains(0));
+  EXPECT_TRUE(cache.Contains(99));
+  cache.Erase(99);
+  EXPECT_FALSE(cache.Contains(99));
+  ASSERT_TRUE(cache.Get(98, output));
+  EXPECT_EQ(std::string("page 98"), std::string(output));
+}
+
+// NOLINTNEXTLINE
+TEST(CompressedPageCacheTest, BufferPoolTest) {
+  const size_t buffer_pool_size = 4;
+  const int num_pages = 16;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  bpm->EnableCompressedCache(num_pages * BUSTUB_PAGE_SIZE);
+
+  // A working set four times the pool.
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: misses on evicted pages are served from the tier, without reading the disk.
+  const auto read_before = disk_manager->GetStats().read_bytes_;
+  for (int round = 0; round < 3; round++) {
+    for (page_id = 0; page_id < num_pages; page_id++) {
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+      EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+    }
+  }
+  EXPECT_EQ(read_before, disk_manager->GetStats().read_bytes_);
+  auto stats = bpm->GetStats();
+  EXPECT_LT(0U, stats.misses_);
+  EXPECT_EQ(stats.misses_, stats.compressed_hits_);
+  EXPECT_EQ(stats.compressed_hits_, bpm->GetCompressedCacheStats().hits_);
+
+  // Scenario: a page modified in the pool is written back when evicted, and the tier keeps the new version.
+  auto *page = bpm->FetchPage(0);
+  snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page zero");
+  EXPECT_EQ(true, bpm->UnpinPage(0, true));
+  for (page_id = 1; page_id <= static_cast<page_id_t>(buffer_pool_size); page_id++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+  page = bpm->FetchPage(0);
+  EXPECT_EQ(std::string("page zero"), std::string(page->GetData()));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+
+  // Scenario: deleting a page that was evicted to the tier drops it from the tier.
+  std::set<page_id_t> resident;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    resident.insert(bpm->GetPages()[i].GetPageId());
+  }
+  page_id = 0;
+  while (resident.count(page_id) != 0) {
+    page_id++;
+  }
+  const auto cached = bpm->GetCompressedCacheStats().num_pages_;
+  EXPECT_EQ(true, bpm->DeletePage(page_id));
+  EXPECT_EQ(cached - 1, bpm->GetCompressedCacheStats().num_pages_);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,107 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/util/numa.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, SmallArenaTest) {
+  const size_t num_frames = 10;
+  FrameArena arena(num_frames);
+  EXPECT_EQ(FrameArena::HugePages::NONE, arena.GetHugePages());
+  EXPECT_EQ(num_frames * BUSTUB_PAGE_SIZE, arena.GetMappedSize());
+
+  char zeros[BUSTUB_PAGE_SIZE] = {0};
+  for (size_t i = 0; i < num_frames; i++) {
+    char *frame = arena.GetFrame(static_cast<frame_id_t>(i));
+    EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(frame) % DIRECT_IO_ALIGNMENT);
+    EXPECT_EQ(0, memcmp(frame, zeros, BUSTUB_PAGE_SIZE));
+    memset(frame, static_cast<int>(i + 1), BUSTUB_PAGE_SIZE);
+  }
+  // Frames are contiguous and do not overlap.
+  for (size_t i = 0; i < num_frames; i++) {
+    char *frame = arena.GetFrame(static_cast<frame_id_t>(i));
+    EXPECT_EQ(arena.GetFrame(0) + i * BUSTUB_PAGE_SIZE, frame);
+    EXPECT_EQ(static_cast<char>(i + 1), frame[0]);
+    EXPECT_EQ(static_cast<char>(i + 1), frame[BUSTUB_PAGE_SIZE - 1]);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, HugePageArenaTest) {
+  // Not a whole number of huge pages, so the mapping is rounded up.
+  const size_t num_frames = (3 * HUGE_PAGE_SIZE) / BUSTUB_PAGE_SIZE + 1;
+  FrameArena arena(num_frames);
+  std::cout << "huge pages: " << static_cast<int>(arena.GetHugePages()) << std::endl;
+  EXPECT_EQ(4 * HUGE_PAGE_SIZE, arena.GetMappedSize());
+  if (arena.GetHugePages() != FrameArena::HugePages::NONE) {
+    EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(arena.GetFrame(0)) % HUGE_PAGE_SIZE);
+  }
+  char *last = arena.GetFrame(static_cast<frame_id_t>(num_frames - 1));
+  EXPECT_EQ(0, last[BUSTUB_PAGE_SIZE - 1]);
+  memset(last, 'x', BUSTUB_PAGE_SIZE);
+  EXPECT_EQ('x', last[BUSTUB_PAGE_SIZE - 1]);
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, NumaArenaTest) {
+  const size_t num_frames = 10;
+  const int node = Numa::NumNodes() - 1;
+  FrameArena arena(num_frames, node);
+  // Frames are placed only when there is more than one node to choose from.
+  EXPECT_EQ(Numa::NumNodes() > 1 ? node : -1, arena.GetNumaNode());
+  EXPECT_EQ(-1, FrameArena(num_frames).GetNumaNode());
+  EXPECT_EQ(-1, FrameArena(num_frames, Numa::NumNodes()).GetNumaNode());
+
+  char *last = arena.GetFrame(static_cast<frame_id_t>(num_frames - 1));
+  EXPECT_EQ(0, last[BUSTUB_PAGE_SIZE - 1]);
+  memset(last, 'x', BUSTUB_PAGE_SIZE);
+  EXPECT_EQ('x', last[BUSTUB_PAGE_SIZE - 1]);
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, BufferPoolFramesTest) {
+  const size_t buffer_pool_size = 16;
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Every frame of the pool is aligned for O_DIRECT and they are packed back to back.
+  page_id_t page_id;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+  Page *pages = bpm->GetPages();
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(pages[i].GetData()) % DIRECT_IO_ALIGNMENT);
+    EXPECT_EQ(pages[0].GetData() + i * BUSTUB_PAGE_SIZE, pages[i].GetData());
+  }
+
+  // A page on its own owns its data.
+  Page page;
+  EXPECT_EQ(0, page.GetData()[BUSTUB_PAGE_SIZE - 1]);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -5,6 +5,7 @@
 #include "buffer/lru_k_replacer.h"
 
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <iostream>
 #include <memory>
@@ -13,6 +14,7 @@
 #include <thread>  // NOLINT
 #include <vector>
 
+#include "common/exception.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
@@ -98,4 +100,242 @@ TEST(LRUKReplacerTest, SampleTest) {
   lru_replacer.Remove(1);
   ASSERT_EQ(0, lru_replacer.Size());
 }
+
+TEST(LRUKReplacerTest, BackwardKDistanceTest) {
+  LRUKReplacer lru_replacer(4, 2);
+
+  // Scenario: frame 0 is accessed at t=0 and t=3, frame 1 at t=1 and t=2. Frame 0 was used more recently, but its
+  // 2nd most recent access is older, so its backward 2-distance is larger and it is evicted first.
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(0);
+  lru_replacer.SetEvictable(0, true);
+  lru_replacer.SetEvictable(1, true);
+
+  // Scenario: frame 2 has a single access, so its backward k-distance is +inf and it goes before both.
+  lru_replacer.RecordAccess(2);
+  lru_replacer.SetEvictable(2, true);
+  ASSERT_EQ(3, lru_replacer.Size());
+
+  int value;
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(2, value);
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_FALSE(lru_replacer.Evict(&value));
+
+  // Scenario: an evicted frame comes back with no history.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(3);
+  lru_replacer.RecordAccess(3);
+  lru_replacer.SetEvictable(3, true);
+  lru_replacer.SetEvictable(1, true);
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+
+  // Scenario: out of range frame ids and removing a pinned frame are rejected.
+  EXPECT_THROW(lru_replacer.RecordAccess(4), Exception);
+  lru_replacer.SetEvictable(3, false);
+  EXPECT_THROW(lru_replacer.Remove(3), Exception);
+}
+
+TEST(LRUKReplacerTest, ScanAccessTest) {
+  LRUKReplacer lru_replacer(3, 2);
+
+  // Scenario: frame 0 is a hot page with two accesses. Frame 1 is read by a scan many times, frame 2 once by a lookup.
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(1, AccessType::Scan);
+  lru_replacer.RecordAccess(2, AccessType::Lookup);
+  for (int i = 0; i < 5; i++) {
+    lru_replacer.RecordAccess(1, AccessType::Scan);
+  }
+  lru_replacer.SetEvictable(0, true);
+  lru_replacer.SetEvictable(1, true);
+  lru_replacer.SetEvictable(2, true);
+
+  // Scenario: repeated scan accesses are not recorded, so frame 1 still has a single access from before frame 2 and
+  // is evicted first. The hot frame goes last.
+  int value;
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(2, value);
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+}
+
+TEST(LRUKReplacerTest, PeekVictimsTest) {
+  LRUKReplacer lru_replacer(8, 2);
+  for (frame_id_t frame_id = 0; frame_id < 8; frame_id++) {
+    lru_replacer.RecordAccess(frame_id);
+  }
+  // Frames 0..3 get a second access, so they come after the frames with a single access, ordered by their first one.
+  for (frame_id_t frame_id = 3; frame_id >= 0; frame_id--) {
+    lru_replacer.RecordAccess(frame_id);
+  }
+  for (frame_id_t frame_id = 0; frame_id < 8; frame_id++) {
+    lru_replacer.SetEvictable(frame_id, frame_id != 5);
+  }
+
+  // Peeking returns the eviction order and does not change the replacer.
+  std::vector<frame_id_t> expected{4, 6, 7, 0, 1, 2, 3};
+  std::vector<frame_id_t> victims(100);
+  ASSERT_EQ(3, lru_replacer.PeekVictims(victims.data(), 3));
+  ASSERT_EQ(std::vector<frame_id_t>(expected.begin(), expected.begin() + 3),
+            std::vector<frame_id_t>(victims.begin(), victims.begin() + 3));
+  victims.resize(lru_replacer.PeekVictims(victims.data(), victims.size()));
+  ASSERT_EQ(expected, victims);
+  ASSERT_EQ(7, lru_replacer.Size());
+  for (auto expected_frame_id : expected) {
+    int value;
+    ASSERT_TRUE(lru_replacer.Evict(&value));
+    ASSERT_EQ(expected_frame_id, value);
+  }
+  ASSERT_EQ(0, lru_replacer.PeekVictims(victims.data(), 3));
+}
+
+TEST(LRUKReplacerTest, SkipTest) {
+  LRUKReplacer lru_replacer(6, 2);
+  for (frame_id_t frame_id = 0; frame_id < 6; frame_id++) {
+    lru_replacer.RecordAccess(frame_id);
+    lru_replacer.SetEvictable(frame_id, true);
+  }
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(1);
+
+  // Scenario: the frames that are turned down, as pinned frames are by the buffer pool, are not evicted and keep both
+  // their access history and their place in the eviction order.
+  std::vector<frame_id_t> turned_down;
+  frame_id_t value;
+  ASSERT_TRUE(lru_replacer.Evict(&value, [&turned_down](frame_id_t frame_id) {
+    turned_down.push_back(frame_id);
+    return frame_id == 4;
+  }));
+  ASSERT_EQ(4, value);
+  ASSERT_EQ((std::vector<frame_id_t>{2, 3, 4}), turned_down);
+  ASSERT_FALSE(lru_replacer.Evict(&value, [](frame_id_t) { return false; }));
+  ASSERT_EQ(5, lru_replacer.Size());
+  for (auto expected_frame_id : {2, 3, 5, 0, 1}) {
+    ASSERT_TRUE(lru_replacer.Evict(&value));
+    ASSERT_EQ(expected_frame_id, value);
+  }
+  ASSERT_FALSE(lru_replacer.Evict(&value, [](frame_id_t) { return true; }));
+}
+
+TEST(LRUKReplacerTest, LazyRepairTest) {
+  LRUKReplacer lru_replacer(6, 2);
+  for (frame_id_t frame_id = 0; frame_id < 6; frame_id++) {
+    lru_replacer.RecordAccess(frame_id);
+    lru_replacer.SetEvictable(frame_id, true);
+  }
+
+  // Scenario: frames that are already evictable are accessed again, which does not reorder the heap until they reach
+  // its top. Frames 1 and 0 get their second access, and frame 2 gets it while it is briefly pinned.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(0);
+  lru_replacer.SetEvictable(2, false);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.SetEvictable(4, false);
+  lru_replacer.SetEvictable(2, true);
+  ASSERT_EQ(5, lru_replacer.Size());
+
+  // Frames with one access go first by that access, then frames 0, 1 and 2 by their first access, although frame 0
+  // still sits at the top of the heap with the key of a single access.
+  std::vector<frame_id_t> expected{3, 5, 0, 1, 2};
+  std::vector<frame_id_t> victims(100);
+  victims.resize(lru_replacer.PeekVictims(victims.data(), victims.size()));
+  ASSERT_EQ(expected, victims);
+  for (auto expected_frame_id : expected) {
+    int value;
+    ASSERT_TRUE(lru_replacer.Evict(&value));
+    ASSERT_EQ(expected_frame_id, value);
+  }
+  int value;
+  ASSERT_FALSE(lru_replacer.Evict(&value));
+  ASSERT_EQ(0, lru_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, ConcurrentAccessTest) {
+  const size_t num_frames = 64;
+  LRUKReplacer lru_replacer(num_frames, 2);
+  for (size_t i = 0; i < num_frames; i++) {
+    lru_replacer.RecordAccess(static_cast<frame_id_t>(i));
+    lru_replacer.SetEvictable(static_cast<frame_id_t>(i), true);
+  }
+
+  // Scenario: threads record accesses without the latch while frames are evicted and brought back, as buffer pool hits
+  // race with misses. Every frame stays accounted for.
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < 4; tid++) {
+    threads.emplace_back([&lru_replacer, tid]() {
+      std::mt19937 rng(tid);
+      for (int i = 0; i < 100000; i++) {
+        lru_replacer.RecordAccess(static_cast<frame_id_t>(rng() % num_frames));
+      }
+    });
+  }
+  for (int i = 0; i < 20000; i++) {
+    frame_id_t victim;
+    ASSERT_TRUE(lru_replacer.Evict(&victim));
+    lru_replacer.RecordAccess(victim);
+    lru_replacer.SetEvictable(victim, true);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(num_frames, lru_replacer.Size());
+  std::set<frame_id_t> evicted;
+  for (size_t i = 0; i < num_frames; i++) {
+    frame_id_t victim;
+    ASSERT_TRUE(lru_replacer.Evict(&victim));
+    evicted.insert(victim);
+  }
+  ASSERT_EQ(num_frames, evicted.size());
+  frame_id_t victim;
+  ASSERT_FALSE(lru_replacer.Evict(&victim));
+}
+
+/**
+ * Replay a buffer-pool-like workload against a replacer with `num_frames` frames and return the elapsed time.
+ * Every frame is resident and evictable; each step touches a frame (skewed towards a hot tenth of the pool) and every
+ * fourth step evicts a victim and refills it, as a miss in the buffer pool would.
+ */
+auto LRUKReplacerBenchmarkCall(size_t num_frames, size_t num_ops) -> int64_t {
+  LRUKReplacer lru_replacer(num_frames, LRUK_REPLACER_K);
+  for (size_t i = 0; i < num_frames; i++) {
+    lru_replacer.RecordAccess(static_cast<frame_id_t>(i));
+    lru_replacer.SetEvictable(static_cast<frame_id_t>(i), true);
+  }
+
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<frame_id_t> all(0, num_frames - 1);
+  std::uniform_int_distribution<frame_id_t> hot(0, std::max<frame_id_t>(num_frames / 10, 1) - 1);
+  auto clock_start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_ops; i++) {
+    lru_replacer.RecordAccess(i % 2 == 0 ? hot(rng) : all(rng));
+    if (i % 4 == 0) {
+      frame_id_t victim;
+      lru_replacer.Evict(&victim);
+      lru_replacer.RecordAccess(victim);
+      lru_replacer.SetEvictable(victim, true);
+    }
+  }
+  auto clock_end = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(clock_end - clock_start).count();
+}
+
+TEST(LRUKReplacerTest, DISABLED_Benchmark) {  // NOLINT
+  const size_t num_ops = 1000000;
+  std::cout << "<<< BEGIN" << std::endl;
+  for (size_t num_frames : {1000, 100000, 1000000}) {
+    std::cout << "frames=" << num_frames << " ops=" << num_ops << ": " << LRUKReplacerBenchmarkCall(num_frames, num_ops)
+              << "ms" << std::endl;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
 }  // namespace bustub
@@ -0,0 +1,316 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/util/numa.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+  const size_t num_instances = 5;
+  const size_t k = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager, k);
+  EXPECT_EQ(buffer_pool_size * num_instances, bpm->GetPoolSize());
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+
+  // Scenario: The buffer pool is empty. We should be able to create a new page.
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, page_id_temp);
+
+  // Scenario: Once we have a page, we should be able to read and write content.
+  snprintf(page0->GetData(), BUSTUB_PAGE_SIZE, "Hello");
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+
+  // Scenario: New pages are handed out round-robin, so the first round gets one page from every instance.
+  for (size_t i = 1; i < num_instances; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(static_cast<page_id_t>(i), page_id_temp);
+  }
+
+  // Scenario: We should be able to create new pages until we fill up the whole pool.
+  for (size_t i = num_instances; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: Once every instance is full, we should not be able to create any new pages.
+  for (size_t i = 0; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: Once one instance has a free frame, allocation falls through to it regardless of the rotation.
+  EXPECT_EQ(true, bpm->UnpinPage(0, true));
+  EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(0, page_id_temp % static_cast<page_id_t>(num_instances));
+  EXPECT_EQ(nullptr, bpm->FetchPage(0));
+
+  // Scenario: After unpinning the new page, page 0 can be read back from disk by its own instance.
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+  EXPECT_EQ(true, bpm->UnpinPage(0, false));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrencyTest) {
+  const size_t num_threads = 8;
+  const size_t num_instances = 4;
+  const size_t buffer_pool_size = 16;
+  const int rounds = 50;
+
+  for (int run = 0; run < rounds; run++) {
+    auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+    auto bpm = std::make_unique<ParallelBufferPoolManager>(num_instances, buffer_pool_size, disk_manager.get());
+
+    std::vector<std::thread> threads;
+    for (size_t tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([&bpm]() {
+        page_id_t page_id;
+        std::vector<page_id_t> page_ids;
+        for (int i = 0; i < 4; i++) {
+          auto *page = bpm->NewPage(&page_id);
+          ASSERT_NE(nullptr, page);
+          snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+          page_ids.push_back(page_id);
+        }
+        for (auto id : page_ids) {
+          EXPECT_EQ(true, bpm->UnpinPage(id, true));
+        }
+        for (auto id : page_ids) {
+          auto *page = bpm->FetchPage(id);
+          ASSERT_NE(nullptr, page);
+          EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(id).c_str()));
+          EXPECT_EQ(true, bpm->UnpinPage(id, false));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, FlushAllPagesTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t num_instances = 4;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<ParallelBufferPoolManager>(num_instances, buffer_pool_size, disk_manager.get());
+
+  page_id_t page_id;
+  for (size_t i = 0; i < buffer_pool_size * num_instances; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+
+  // Every page reached the disk, including the ones whose ids are not frame ids of their instance.
+  char buf[BUSTUB_PAGE_SIZE];
+  for (page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size * num_instances); page_id++) {
+    disk_manager->ReadPage(page_id, buf);
+    EXPECT_EQ(0, strcmp(buf, std::to_string(page_id).c_str()));
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_FALSE(page->IsDirty());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+}
+
+/**
+ * Fetch/unpin a random set of resident pages from `num_threads` threads and return the elapsed time.
+ * With a single instance every call serializes on one latch; with a few instances per thread they mostly do not.
+ */
+auto ParallelBufferPoolManagerBenchmarkCall(size_t num_threads, size_t num_instances) -> int64_t {
+  const size_t total_pages = 1024;
+  const size_t ops_per_thread = 200000;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm =
+      std::make_unique<ParallelBufferPoolManager>(num_instances, total_pages / num_instances, disk_manager.get());
+
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id;
+  for (size_t i = 0; i < total_pages; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    BUSTUB_ASSERT(page != nullptr, "pool sized to hold every page");
+    page_ids.push_back(page_id);
+    bpm->UnpinPage(page_id, false);
+  }
+
+  auto clock_start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&bpm, &page_ids, tid]() {
+      std::mt19937 rng(tid);
+      std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+      for (size_t i = 0; i < ops_per_thread; i++) {
+        auto id = page_ids[dist(rng)];
+        bpm->FetchPage(id);
+        bpm->UnpinPage(id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto clock_end = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(clock_end - clock_start).count();
+}
+
+TEST(ParallelBufferPoolManagerTest, DISABLED_ScalingBenchmark) {  // NOLINT
+  std::cout << "<<< BEGIN" << std::endl;
+  for (size_t num_threads : {1, 2, 4, 8, 16, 32}) {
+    auto single_ms = ParallelBufferPoolManagerBenchmarkCall(num_threads, 1);
+    auto parallel_ms = ParallelBufferPoolManagerBenchmarkCall(num_threads, num_threads * 2);
+    std::cout << "threads=" << num_threads << " single instance: " << single_ms << "ms, "
+              << num_threads * 2 << " instances: " << parallel_ms << "ms" << std::endl;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ExtentTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t num_instances = 4;
+  const size_t extent_pages = 16;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Instances 0 and 1 have handed out pages 0 and 1, so they allocate 4 and 5 next; instances 2 and 3 allocate 2 and 3.
+  page_id_t page_id_temp;
+  for (int i = 0; i < 2; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+  }
+
+  // Scenario: an extent starts where the instance furthest ahead allocates next, and its pages are created in the
+  // instances they belong to.
+  page_id_t first = bpm->AllocateExtent(extent_pages);
+  EXPECT_EQ(5, first);
+  for (page_id_t page_id = first; page_id < first + static_cast<page_id_t>(extent_pages); page_id++) {
+    auto *page = bpm->NewPageAt(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, page->GetPageId());
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: the ids the instances skipped are handed out first, then new pages come after the extent.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < 2 * num_instances; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+    page_ids.push_back(page_id_temp);
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  EXPECT_EQ((std::vector<page_id_t>{2, 3, 4, 21, 22, 23, 24, 25}), page_ids);
+  EXPECT_LE(26, bpm->AllocateExtent(extent_pages));
+
+  // Scenario: an extent that would run past the largest page id is refused, and nothing is reserved for it.
+  const page_id_t next_first = bpm->AllocateExtent(extent_pages) + static_cast<page_id_t>(extent_pages);
+  EXPECT_EQ(INVALID_PAGE_ID, bpm->AllocateExtent(std::numeric_limits<page_id_t>::max()));
+  EXPECT_EQ(INVALID_PAGE_ID, bpm->AllocateExtent(std::numeric_limits<page_id_t>::max() - next_first));
+  EXPECT_EQ(INVALID_PAGE_ID, bpm->AllocateExtent(std::numeric_limits<size_t>::max()));
+  first = bpm->AllocateExtent(extent_pages);
+  EXPECT_LE(next_first, first);
+  EXPECT_GT(next_first + static_cast<page_id_t>(num_instances), first);
+
+  // Scenario: an instance on its own hands out extents from its counter.
+  auto *bpi_disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpi = new BufferPoolManagerInstance(buffer_pool_size, bpi_disk_manager);
+  ASSERT_NE(nullptr, bpi->NewPage(&page_id_temp));
+  EXPECT_EQ(true, bpi->UnpinPage(page_id_temp, false));
+  EXPECT_EQ(1, bpi->AllocateExtent(extent_pages));
+  ASSERT_NE(nullptr, bpi->NewPageAt(5));
+  EXPECT_EQ(true, bpi->UnpinPage(5, false));
+  ASSERT_NE(nullptr, bpi->NewPage(&page_id_temp));
+  EXPECT_EQ(1 + static_cast<page_id_t>(extent_pages), page_id_temp);
+
+  delete bpi;
+  delete bpi_disk_manager;
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, NumaTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t num_instances = 4;
+  const int num_nodes = Numa::NumNodes();
+  ASSERT_LE(1, num_nodes);
+  EXPECT_LE(0, Numa::CurrentNode());
+  EXPECT_GT(num_nodes, Numa::CurrentNode());
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Scenario: the instances are spread over the NUMA nodes; on a single-node host, nothing is placed.
+  for (size_t i = 0; i < num_instances; i++) {
+    int node = bpm->GetInstanceNumaNode(i);
+    if (num_nodes > 1) {
+      EXPECT_TRUE(node == -1 || node == static_cast<int>(i % num_nodes));
+    } else {
+      EXPECT_EQ(-1, node);
+    }
+  }
+
+  // Scenario: new pages still fill every instance, so none is left idle once the local ones are full.
+  page_id_t page_id_temp;
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_instances * buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    page_ids.push_back(page_id_temp);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  for (auto page_id : page_ids) {
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -59,6 +59,7 @@ TEST(CatalogTest, DISABLED_CreateTable1) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 TEST(CatalogTest, DISABLED_CreateTable2) {
@@ -87,6 +88,7 @@ TEST(CatalogTest, DISABLED_CreateTable2) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 TEST(CatalogTest, DISABLED_CreateTable3) {
@@ -119,6 +121,7 @@ TEST(CatalogTest, DISABLED_CreateTable3) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 TEST(CatalogTest, DISABLED_CreateTableTest) {
@@ -215,6 +218,7 @@ TEST(CatalogTest, DISABLED_CreateIndex1) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 // Attempts to create an index with duplicate name should fail
@@ -264,6 +268,7 @@ TEST(CatalogTest, DISABLED_CreateIndex2) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 TEST(CatalogTest, DISABLED_CreateIndex3) {
@@ -338,6 +343,7 @@ TEST(CatalogTest, DISABLED_QueryIndex1) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 // Vanilla index queries by index OID
@@ -388,6 +394,7 @@ TEST(CatalogTest, DISABLED_QueryIndex2) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 // Query for nonexistent index on table should fail
@@ -410,6 +417,7 @@ TEST(CatalogTest, DISABLED_FailedQuery1) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 // Query for index on nonexistent table should fail
@@ -423,6 +431,7 @@ TEST(CatalogTest, DISABLED_FailedQuery2) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 // Query for nonexistent index OID should throw
@@ -437,6 +446,7 @@ TEST(CatalogTest, DISABLED_FailedQuery3) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 // Query for all indexes on nonexistent table should give empty collection
@@ -451,6 +461,7 @@ TEST(CatalogTest, DISABLED_FailedQuery4) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 // Query for all indexes on existing table with no
@@ -475,6 +486,7 @@ TEST(CatalogTest, DISABLED_FailedQuery5) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 // Should be able to create and interact with an index with a single BIGINT key
@@ -527,6 +539,7 @@ TEST(CatalogTest, DISABLED_IndexInteraction0) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 // Should be able to create and interact with an index that is keyed by two INTEGER values
@@ -579,6 +592,7 @@ TEST(CatalogTest, DISABLED_IndexInteraction1) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 // Should be able to create and interact with an index that is keyed by a single INTEGER column
@@ -631,6 +645,7 @@ TEST(CatalogTest, DISABLED_IndexInteraction2) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 TEST(CatalogTest, DISABLED_IndexInteraction3) {
@@ -686,6 +701,7 @@ TEST(CatalogTest, DISABLED_IndexInteraction3) {
 
   remove("catalog_test.db");
   remove("catalog_test.log");
+  DiskManager::RemoveSidecarFiles("catalog_test.db");
 }
 
 }  // namespace bustub
@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// crc32c_test.cpp
+//
+// Identification: test/common/crc32c_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/crc32c.h"
+
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "common/config.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(Crc32cTest, KnownValueTest) {
+  const char *check = "123456789";
+  EXPECT_EQ(0xE3069283U, Crc32c::Compute(check, strlen(check)));
+  EXPECT_EQ(0xE3069283U, Crc32c::ComputeSoftware(check, strlen(check)));
+  EXPECT_EQ(0U, Crc32c::Compute(check, 0));
+
+  // 32 bytes of zeros, from the iSCSI test vectors (RFC 3720).
+  char zeros[32] = {0};
+  EXPECT_EQ(0x8A9136AAU, Crc32c::Compute(zeros, sizeof(zeros)));
+}
+
+// NOLINTNEXTLINE
+TEST(Crc32cTest, HardwareMatchesSoftwareTest) {
+  std::cout << "hardware accelerated: " << Crc32c::IsHardwareAccelerated() << std::endl;
+  std::mt19937 gen(15445);
+  std::vector<char> data(BUSTUB_PAGE_SIZE + 7);
+  for (auto &c : data) {
+    c = static_cast<char>(gen());
+  }
+  // Every length up to a couple of words, at every alignment, and whole pages.
+  for (size_t offset = 0; offset < 8; offset++) {
+    for (size_t length = 0; length < 24; length++) {
+      ASSERT_EQ(Crc32c::ComputeSoftware(data.data() + offset, length), Crc32c::Compute(data.data() + offset, length));
+    }
+    uint32_t crc = Crc32c::Compute(data.data() + offset, BUSTUB_PAGE_SIZE);
+    EXPECT_EQ(Crc32c::ComputeSoftware(data.data() + offset, BUSTUB_PAGE_SIZE), crc);
+    // Checksumming in pieces gives the same result.
+    uint32_t pieces = Crc32c::Compute(data.data() + offset, 1000);
+    pieces = Crc32c::Compute(data.data() + offset + 1000, BUSTUB_PAGE_SIZE - 1000, pieces);
+    EXPECT_EQ(crc, pieces);
+  }
+}
+
+/** Checksum `num_pages` pages and return the time per page in nanoseconds. */
+template <typename F>
+auto ChecksumBenchmarkCall(const std::vector<char> &pages, size_t num_pages, F compute) -> double {
+  uint32_t sink = 0;
+  auto clock_start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < 64; round++) {
+    for (size_t i = 0; i < num_pages; i++) {
+      sink ^= compute(pages.data() + i * BUSTUB_PAGE_SIZE, BUSTUB_PAGE_SIZE);
+    }
+  }
+  auto clock_end = std::chrono::steady_clock::now();
+  EXPECT_NE(0xDEADBEEFU, sink);
+  return std::chrono::duration<double, std::nano>(clock_end - clock_start).count() / (64.0 * num_pages);
+}
+
+TEST(Crc32cTest, DISABLED_ChecksumBenchmark) {  // NOLINT
+  // 256 pages fit in the L2 cache, so this measures the checksum rather than memory bandwidth.
+  const size_t num_pages = 256;
+  std::vector<char> pages(num_pages * BUSTUB_PAGE_SIZE);
+  std::mt19937 gen(15445);
+  for (auto &c : pages) {
+    c = static_cast<char>(gen());
+  }
+
+  std::cout << "<<< BEGIN" << std::endl;
+  auto hardware = ChecksumBenchmarkCall(pages, num_pages, [](const char *data, size_t length) {
+    return Crc32c::Compute(data, length);
+  });
+  auto software = ChecksumBenchmarkCall(pages, num_pages, [](const char *data, size_t length) {
+    return Crc32c::ComputeSoftware(data, length);
+  });
+  std::cout << "CRC32C per " << BUSTUB_PAGE_SIZE << "-byte page: " << hardware
+            << " ns (hardware accelerated: " << Crc32c::IsHardwareAccelerated() << "), table-driven: " << software
+            << " ns" << std::endl;
+  std::cout << ">>> END" << std::endl;
+}
+
+}  // namespace bustub
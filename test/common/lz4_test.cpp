@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz4_test.cpp
+//
+// Identification: test/common/lz4_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/lz4.h"
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+
+void ExpectRoundTrip(const std::vector<char> &input) {
+  std::vector<char> compressed(Lz4::MaxCompressedSize(input.size()));
+  size_t size = Lz4::Compress(input.data(), input.size(), compressed.data(), compressed.size());
+  ASSERT_NE(0U, size);
+  std::vector<char> output(input.size());
+  ASSERT_TRUE(Lz4::Decompress(compressed.data(), size, output.data(), output.size()));
+  EXPECT_EQ(input, output);
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(Lz4Test, KnownBlockTest) {
+  // One literal, a match of 8 at offset 1, then the 5 literals a block ends with: 14 times 'a'.
+  const char block[] = {0x14, 'a', 0x01, 0x00, 0x50, 'a', 'a', 'a', 'a', 'a'};
+  char output[14];
+  ASSERT_TRUE(Lz4::Decompress(block, sizeof(block), output, sizeof(output)));
+  EXPECT_EQ(std::string(14, 'a'), std::string(output, sizeof(output)));
+
+  // Scenario: blocks that are truncated, point before the start or decompress to the wrong size are rejected.
+  EXPECT_FALSE(Lz4::Decompress(block, 3, output, sizeof(output)));
+  EXPECT_FALSE(Lz4::Decompress(block, sizeof(block), output, sizeof(output) - 1));
+  const char bad_offset[] = {0x14, 'a', 0x02, 0x00, 0x50, 'a', 'a', 'a', 'a', 'a'};
+  EXPECT_FALSE(Lz4::Decompress(bad_offset, sizeof(bad_offset), output, sizeof(output)));
+}
+
+// NOLINTNEXTLINE
+TEST(Lz4Test, RoundTripTest) {
+  std::mt19937 generator(15445);
+  // Scenario: empty, tiny and incompressible inputs come out as literals.
+  ExpectRoundTrip({});
+  ExpectRoundTrip({'x'});
+  ExpectRoundTrip(std::vector<char>(12, 'y'));
+  std::vector<char> random(BUSTUB_PAGE_SIZE);
+  for (auto &c : random) {
+    c = static_cast<char>(generator());
+  }
+  ExpectRoundTrip(random);
+
+  // Scenario: a page laid out like a table page, slots at the front and tuples at the back, compresses well.
+  std::vector<char> page(BUSTUB_PAGE_SIZE, 0);
+  for (int i = 0; i < 50; i++) {
+    int32_t slot[2] = {BUSTUB_PAGE_SIZE - 40 * (i + 1), 40};
+    memcpy(page.data() + 24 + i * 8, slot, sizeof(slot));
+    std::string tuple = "tuple number " + std::to_string(i) + ", padded to forty bytes....";
+    memcpy(page.data() + BUSTUB_PAGE_SIZE - 40 * (i + 1), tuple.data(), 40);
+  }
+  ExpectRoundTrip(page);
+  std::vector<char> compressed(Lz4::MaxCompressedSize(page.size()));
+  EXPECT_GT(BUSTUB_PAGE_SIZE / 4, Lz4::Compress(page.data(), page.size(), compressed.data(), compressed.size()));
+
+  // Scenario: long runs need length bytes beyond the token, and a buffer that is too small makes Compress() fail.
+  std::vector<char> runs;
+  for (int i = 0; i < 10; i++) {
+    runs.insert(runs.end(), 100 * i + 1, static_cast<char>('a' + i));
+  }
+  ExpectRoundTrip(runs);
+  EXPECT_EQ(0U, Lz4::Compress(random.data(), random.size(), compressed.data(), BUSTUB_PAGE_SIZE / 2));
+}
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <thread>  // NOLINT
 #include <vector>
 
@@ -57,4 +58,66 @@ TEST(RWLatchTest, BasicTest) {
   }
   EXPECT_EQ(counter.Read(), 55);
 }
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, OptimisticReadTest) {
+  OptimisticLatch latch;
+  // Writers keep both fields equal under the write latch. They are relaxed atomics only so that the torn reads the
+  // test provokes are not undefined behavior.
+  std::atomic<int> first{0};
+  std::atomic<int> second{0};
+
+  // Scenario: an optimistic read fails while a writer holds the latch, and fails to validate once a writer took it.
+  uint64_t version;
+  ASSERT_TRUE(latch.TryOptimisticRead(&version));
+  EXPECT_TRUE(latch.Validate(version));
+  latch.WLock();
+  uint64_t locked_version;
+  EXPECT_FALSE(latch.TryOptimisticRead(&locked_version));
+  latch.WUnlock();
+  EXPECT_FALSE(latch.Validate(version));
+  ASSERT_TRUE(latch.TryOptimisticRead(&version));
+  latch.RLock();
+  latch.RUnlock();
+  EXPECT_TRUE(latch.Validate(version));
+
+  // Scenario: a read that validates never sees a writer's half-done update.
+  const int num_writes = 100000;
+  std::atomic<bool> done{false};
+  std::atomic<int> validated{0};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 4; tid++) {
+    readers.emplace_back([&]() {
+      while (!done) {
+        uint64_t v;
+        if (!latch.TryOptimisticRead(&v)) {
+          continue;
+        }
+        int a = first.load(std::memory_order_relaxed);
+        int b = second.load(std::memory_order_relaxed);
+        if (latch.Validate(v)) {
+          EXPECT_EQ(a, b);
+          validated++;
+        }
+      }
+    });
+  }
+  std::thread writer([&]() {
+    for (int i = 1; i <= num_writes; i++) {
+      latch.WLock();
+      first.store(i, std::memory_order_relaxed);
+      second.store(i, std::memory_order_relaxed);
+      latch.WUnlock();
+    }
+  });
+  writer.join();
+  while (validated == 0) {
+    std::this_thread::yield();
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(num_writes, first);
+}
 }  // namespace bustub
@@ -52,6 +52,7 @@ TEST(HashTablePageTest, DISABLED_DirectoryPageSampleTest) {
   bpm->UnpinPage(directory_page_id, true, nullptr);
   disk_manager->ShutDown();
   remove("test.db");
+  DiskManager::RemoveSidecarFiles("test.db");
   delete disk_manager;
   delete bpm;
 }
@@ -110,6 +111,7 @@ TEST(HashTablePageTest, DISABLED_BucketPageSampleTest) {
   bpm->UnpinPage(bucket_page_id, true, nullptr);
   disk_manager->ShutDown();
   remove("test.db");
+  DiskManager::RemoveSidecarFiles("test.db");
   delete disk_manager;
   delete bpm;
 }
@@ -113,6 +113,7 @@ TEST(HashTableTest, DISABLED_SampleTest) {
 
   disk_manager->ShutDown();
   remove("test.db");
+  DiskManager::RemoveSidecarFiles("test.db");
   delete disk_manager;
   delete bpm;
 }
@@ -0,0 +1,98 @@
+/**
+ * lock_free_page_table_test.cpp
+ */
+
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "container/hash/lock_free_page_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(LockFreePageTableTest, SampleTest) {
+  auto table = std::make_unique<LockFreePageTable>(4);
+
+  frame_id_t frame_id;
+  EXPECT_FALSE(table->Find(0, &frame_id));
+
+  table->Insert(0, 3);
+  table->Insert(1, 2);
+  table->Insert(17, 1);
+  EXPECT_TRUE(table->Find(0, &frame_id));
+  EXPECT_EQ(3, frame_id);
+  EXPECT_TRUE(table->Find(17, &frame_id));
+  EXPECT_EQ(1, frame_id);
+
+  // Inserting an existing page updates its frame.
+  table->Insert(1, 0);
+  EXPECT_TRUE(table->Find(1, &frame_id));
+  EXPECT_EQ(0, frame_id);
+
+  EXPECT_TRUE(table->Remove(0));
+  EXPECT_FALSE(table->Remove(0));
+  EXPECT_FALSE(table->Find(0, &frame_id));
+  EXPECT_TRUE(table->Find(17, &frame_id));
+  EXPECT_EQ(1, frame_id);
+}
+
+TEST(LockFreePageTableTest, ChurnTest) {
+  // Cycle many more pages than the table can hold at once, which forces tombstone compaction.
+  const size_t max_entries = 16;
+  auto table = std::make_unique<LockFreePageTable>(max_entries);
+
+  frame_id_t frame_id;
+  for (page_id_t page_id = 0; page_id < 10000; page_id++) {
+    if (page_id >= static_cast<page_id_t>(max_entries)) {
+      EXPECT_TRUE(table->Remove(page_id - max_entries));
+    }
+    table->Insert(page_id, page_id % max_entries);
+  }
+  for (page_id_t page_id = 10000 - max_entries; page_id < 10000; page_id++) {
+    EXPECT_TRUE(table->Find(page_id, &frame_id));
+    EXPECT_EQ(page_id % static_cast<page_id_t>(max_entries), frame_id);
+  }
+  EXPECT_FALSE(table->Find(10000 - max_entries - 1, &frame_id));
+}
+
+TEST(LockFreePageTableTest, ConcurrentReadTest) {
+  // One writer remaps pages while readers look them up; readers must never see a frame that page was never mapped to.
+  const size_t max_entries = 64;
+  auto table = std::make_unique<LockFreePageTable>(max_entries);
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(max_entries); page_id++) {
+    table->Insert(page_id, page_id);
+  }
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 4; tid++) {
+    readers.emplace_back([&table, &done]() {
+      frame_id_t frame_id;
+      while (!done.load()) {
+        for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(2 * max_entries); page_id++) {
+          if (table->Find(page_id, &frame_id)) {
+            EXPECT_EQ(page_id % static_cast<page_id_t>(max_entries), frame_id);
+          }
+        }
+      }
+    });
+  }
+
+  // Swap page p and page p + max_entries in and out of frame p % max_entries.
+  for (int round = 0; round < 2000; round++) {
+    for (page_id_t frame = 0; frame < static_cast<page_id_t>(max_entries); frame++) {
+      page_id_t old_page = (round % 2 == 0) ? frame : frame + max_entries;
+      page_id_t new_page = (round % 2 == 0) ? frame + max_entries : frame;
+      table->Remove(old_page);
+      table->Insert(new_page, frame);
+    }
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+}
+
+}  // namespace bustub
@@ -38,6 +38,7 @@ class RecoveryTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    DiskManager::RemoveSidecarFiles("test.db");
   }
 
   // This function is called after every test.
@@ -45,6 +46,7 @@ class RecoveryTest : public ::testing::Test {
     LOG_INFO("Tearing down the system..");
     remove("test.db");
     remove("test.log");
+    DiskManager::RemoveSidecarFiles("test.db");
   };
 };
 
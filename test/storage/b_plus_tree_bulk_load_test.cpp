@@ -0,0 +1,235 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_bulk_load_test.cpp
+//
+// Identification: test/storage/b_plus_tree_bulk_load_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/index_entry_sorter.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using Tree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+using LeafPage = BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
+using InternalPage = BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+
+/** Bulk load keys, which must be sorted, into the empty tree; each value records its key. */
+auto BulkLoadKeys(Tree *tree, const std::vector<int64_t> &keys, double fill_factor) -> bool {
+  size_t next = 0;
+  return tree->BulkLoad(
+      [&](std::pair<GenericKey<8>, RID> *item) {
+        if (next == keys.size()) {
+          return false;
+        }
+        item->first.SetFromInteger(keys[next]);
+        item->second.Set(0, static_cast<uint32_t>(keys[next]));
+        next++;
+        return true;
+      },
+      fill_factor);
+}
+
+/** Check that the tree holds exactly the distinct keys, through point lookups and a full scan. */
+void CheckKeys(Tree *tree, std::vector<int64_t> keys) {
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  GenericKey<8> index_key;
+  for (auto key : keys) {
+    std::vector<RID> rids;
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree->GetValue(index_key, &rids)) << key;
+    ASSERT_EQ(1, rids.size());
+    ASSERT_EQ(key, rids[0].GetSlotNum());
+  }
+  size_t i = 0;
+  for (auto iterator = tree->Begin(); !iterator.IsEnd(); ++iterator) {
+    ASSERT_LT(i, keys.size());
+    ASSERT_EQ(keys[i++], (*iterator).first.ToString());
+  }
+  ASSERT_EQ(keys.size(), i);
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeBulkLoadTest, ShapeTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+
+  // Scenario: every count of keys, including the ones that leave a short last leaf or internal page, builds a tree
+  // that answers lookups and scans, for node sizes down to the smallest and fill factors up to full pages.
+  const std::vector<std::pair<int, int>> node_sizes = {{3, 3}, {4, 4}, {5, 7}, {16, 9}};
+  for (auto [leaf_max_size, internal_max_size] : node_sizes) {
+    for (double fill_factor : {0.1, 0.5, 0.9, 1.0}) {
+      for (int64_t num_keys : {0, 1, 2, 3, 5, 8, 13, 64, 100, 333}) {
+        Tree tree("foo_pk", bpm, comparator, leaf_max_size, internal_max_size, INVALID_PAGE_ID);
+        std::vector<int64_t> keys(num_keys);
+        for (int64_t i = 0; i < num_keys; i++) {
+          keys[i] = i * 2;
+        }
+        ASSERT_TRUE(BulkLoadKeys(&tree, keys, fill_factor));
+        EXPECT_EQ(num_keys == 0, tree.IsEmpty());
+        CheckKeys(&tree, keys);
+
+        // Scenario: the loaded tree keeps working for inserts in the gaps and removes of every key.
+        GenericKey<8> index_key;
+        for (auto key : keys) {
+          index_key.SetFromInteger(key + 1);
+          ASSERT_TRUE(tree.Insert(index_key, RID(0, static_cast<uint32_t>(key + 1))));
+        }
+        for (int64_t key = 0; key < num_keys * 2; key++) {
+          index_key.SetFromInteger(key);
+          tree.Remove(index_key);
+        }
+        EXPECT_TRUE(tree.IsEmpty());
+      }
+    }
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeBulkLoadTest, SortedRunTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  Tree tree("foo_pk", bpm, comparator, 6, 5, INVALID_PAGE_ID);
+
+  // Scenario: keys in random order with duplicates go through a sorter that spills to pages, and only the first
+  // entry of a duplicated key makes it into the tree.
+  std::mt19937 gen(3);
+  std::vector<int64_t> keys(5000);
+  for (auto &key : keys) {
+    key = static_cast<int64_t>(gen() % 3000);
+  }
+  IndexEntrySorter<GenericKey<8>, RID, GenericComparator<8>> sorter(bpm, comparator,
+                                                                    500 * sizeof(std::pair<GenericKey<8>, RID>));
+  for (size_t i = 0; i < keys.size(); i++) {
+    GenericKey<8> index_key;
+    index_key.SetFromInteger(keys[i]);
+    sorter.Add(index_key, RID(static_cast<page_id_t>(i), static_cast<uint32_t>(keys[i])));
+  }
+  sorter.Finish();
+  EXPECT_EQ(10, sorter.GetNumRuns());
+  ASSERT_TRUE(tree.BulkLoad([&sorter](std::pair<GenericKey<8>, RID> *item) { return sorter.Next(item); }));
+
+  auto sorted = keys;
+  std::sort(sorted.begin(), sorted.end());
+  CheckKeys(&tree, sorted);
+  GenericKey<8> index_key;
+  for (auto key : sorted) {
+    std::vector<RID> rids;
+    index_key.SetFromInteger(key);
+    tree.GetValue(index_key, &rids);
+    ASSERT_EQ(std::find(keys.begin(), keys.end(), key) - keys.begin(), rids[0].GetPageId());
+  }
+
+  // Scenario: a tree that is not empty is not bulk loaded.
+  EXPECT_FALSE(BulkLoadKeys(&tree, {1, 2, 3}, 0.9));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeBulkLoadTest, ExtentTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  Tree tree("foo_pk", bpm, comparator, 4, 4, INVALID_PAGE_ID);
+
+  // Scenario: pages created by someone else in between do not end up in the middle of the tree.
+  std::vector<page_id_t> other_pages;
+  page_id_t page_id;
+  for (int i = 0; i < 3; i++) {
+    bpm->NewPageGuarded(&page_id);
+    other_pages.push_back(page_id);
+  }
+
+  // Scenario: the leaf level of a bulk loaded tree is laid out in key order on consecutive pages of the extents of
+  // the tree, across extent boundaries.
+  std::vector<int64_t> keys(EXTENT_PAGES * 8);
+  for (size_t i = 0; i < keys.size(); i++) {
+    keys[i] = static_cast<int64_t>(i);
+  }
+  ASSERT_TRUE(BulkLoadKeys(&tree, keys, 0.5));
+  CheckKeys(&tree, keys);
+  auto extents = tree.GetExtents();
+  ASSERT_GT(extents.size(), 2);
+  for (size_t i = 1; i < extents.size(); i++) {
+    EXPECT_EQ(extents[i - 1] + EXTENT_PAGES, extents[i]);
+  }
+  for (auto other : other_pages) {
+    EXPECT_TRUE(other < extents.front() || other >= extents.back() + EXTENT_PAGES) << other;
+  }
+
+  auto guard = bpm->FetchPageRead(tree.GetRootPageId());
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+    guard = bpm->FetchPageRead(guard.As<InternalPage>()->ValueAt(0));
+  }
+  EXPECT_EQ(extents.front(), guard.PageId());
+  size_t num_leaves = 1;
+  while (guard.As<LeafPage>()->GetNextPageId() != INVALID_PAGE_ID) {
+    page_id_t next_page_id = guard.As<LeafPage>()->GetNextPageId();
+    ASSERT_EQ(guard.PageId() + 1, next_page_id);
+    guard = bpm->FetchPageRead(next_page_id);
+    num_leaves++;
+  }
+  EXPECT_GT(num_leaves, EXTENT_PAGES);
+  guard.Drop();
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeBulkLoadTest, ReadAheadTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(32, disk_manager);
+  Tree tree("foo_pk", bpm, comparator, 4, 4, INVALID_PAGE_ID);
+
+  std::vector<int64_t> keys(EXTENT_PAGES * 8);
+  for (size_t i = 0; i < keys.size(); i++) {
+    keys[i] = static_cast<int64_t>(i);
+  }
+  ASSERT_TRUE(BulkLoadKeys(&tree, keys, 0.5));
+  bpm->FlushAllPages();
+
+  // Scenario: a scan of a tree much larger than the buffer pool reads the leaves ahead of the iterator, so that
+  // most of the leaves it moves onto are already there.
+  const IoStats before = bpm->GetStats();
+  size_t i = 0;
+  for (auto iterator = tree.Begin(); !iterator.IsEnd(); ++iterator) {
+    ASSERT_EQ(keys[i++], (*iterator).first.ToString());
+  }
+  ASSERT_EQ(keys.size(), i);
+  const IoStats after = bpm->GetStats();
+  const uint64_t num_leaves = keys.size() / 2;
+  EXPECT_GT(after.prefetches_ - before.prefetches_, num_leaves / 2);
+  EXPECT_GT(after.prefetch_hits_ - before.prefetch_hits_, num_leaves / 2);
+  EXPECT_LT(after.misses_ - before.misses_, num_leaves / 2);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -10,9 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
+#include <random>
 #include <thread>  // NOLINT
 
 #include "buffer/buffer_pool_manager_instance.h"
@@ -100,7 +103,7 @@ void DeleteHelperSplit(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> *tree
   delete transaction;
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest1) {
+TEST(BPlusTreeConcurrentTest, InsertTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -150,9 +153,10 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest1) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
+TEST(BPlusTreeConcurrentTest, InsertTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -201,9 +205,10 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
+TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -243,9 +248,10 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
+TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -286,9 +292,10 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
+TEST(BPlusTreeConcurrentTest, MixTest) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -331,6 +338,106 @@ TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeConcurrentTest, MixedStressTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(256, disk_manager);
+  // Small pages make every insert and remove likely to split or merge, all the way up to the root.
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  const int64_t num_keys = 4000;
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= num_keys; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  LaunchParallelTest(8, InsertHelperSplit, &tree, keys, 8);
+
+  // Scenario: removers drop the odd keys while readers look up and scan the even ones, which must stay visible.
+  std::vector<int64_t> odd_keys;
+  for (auto key : keys) {
+    if (key % 2 == 1) {
+      odd_keys.push_back(key);
+    }
+  }
+  std::atomic<bool> removing{true};
+  std::atomic<int> failures{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 2; i++) {
+    readers.emplace_back([&]() {
+      GenericKey<8> index_key;
+      std::vector<RID> rids;
+      while (removing) {
+        for (int64_t key = 2; key <= num_keys; key += 2) {
+          rids.clear();
+          index_key.SetFromInteger(key);
+          if (!tree.GetValue(index_key, &rids) || rids[0].GetSlotNum() != key) {
+            failures++;
+          }
+        }
+      }
+    });
+    readers.emplace_back([&]() {
+      while (removing) {
+        int64_t last_key = 0;
+        int64_t even_keys = 0;
+        for (auto iterator = tree.Begin(); !iterator.IsEnd(); ++iterator) {
+          int64_t key = (*iterator).second.GetSlotNum();
+          if (key <= last_key) {
+            failures++;
+          }
+          last_key = key;
+          even_keys += key % 2 == 0 ? 1 : 0;
+        }
+        if (even_keys != num_keys / 2) {
+          failures++;
+        }
+      }
+    });
+  }
+  LaunchParallelTest(4, DeleteHelperSplit, &tree, odd_keys, 4);
+  removing = false;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0, failures);
+
+  int64_t current_key = 2;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key += 2;
+  }
+  EXPECT_EQ(current_key, num_keys + 2);
+
+  // Scenario: removing every key empties the tree, and it grows again from a new root.
+  std::vector<int64_t> even_keys;
+  for (int64_t key = 2; key <= num_keys; key += 2) {
+    even_keys.push_back(key);
+  }
+  LaunchParallelTest(4, DeleteHelperSplit, &tree, even_keys, 4);
+  EXPECT_TRUE(tree.IsEmpty());
+  EXPECT_TRUE(tree.Begin().IsEnd());
+  InsertHelper(&tree, {42});
+  std::vector<RID> rids;
+  GenericKey<8> index_key;
+  index_key.SetFromInteger(42);
+  EXPECT_TRUE(tree.GetValue(index_key, &rids));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
 }
 
 }  // namespace bustub
@@ -0,0 +1,225 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_duplicate_test.cpp
+//
+// Identification: test/storage/b_plus_tree_duplicate_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using Tree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+/** Check that the tree holds exactly the values of every key, through point lookups and a full scan. */
+void CheckValues(Tree *tree, const std::map<int64_t, std::vector<uint32_t>> &expected) {
+  GenericKey<8> index_key;
+  std::map<int64_t, std::vector<uint32_t>> scanned;
+  int64_t previous_key = INT64_MIN;
+  for (auto iterator = tree->Begin(); !iterator.IsEnd(); ++iterator) {
+    int64_t key = (*iterator).first.ToString();
+    ASSERT_LE(previous_key, key);
+    previous_key = key;
+    scanned[key].push_back((*iterator).second.GetSlotNum());
+  }
+  for (auto &[key, values] : scanned) {
+    std::sort(values.begin(), values.end());
+  }
+
+  std::map<int64_t, std::vector<uint32_t>> nonempty;
+  for (const auto &[key, values] : expected) {
+    std::vector<RID> rids;
+    index_key.SetFromInteger(key);
+    ASSERT_EQ(!values.empty(), tree->GetValue(index_key, &rids)) << key;
+    std::vector<uint32_t> found;
+    for (const auto &rid : rids) {
+      found.push_back(rid.GetSlotNum());
+    }
+    std::sort(found.begin(), found.end());
+    auto sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    ASSERT_EQ(sorted, found) << key;
+    if (!sorted.empty()) {
+      nonempty[key] = sorted;
+    }
+  }
+  ASSERT_EQ(nonempty, scanned);
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeDuplicateTest, PostingListTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  Tree tree("foo_pk", bpm, comparator, 4, 5, INVALID_PAGE_ID, false);
+  const int posting_page_capacity = BPlusTreePostingPage<RID>::CAPACITY;
+
+  // Scenario: keys with one value, a few values, and enough values to fill several posting pages, inserted in a
+  // random order with the leaves splitting around them.
+  std::map<int64_t, std::vector<uint32_t>> expected;
+  std::vector<std::pair<int64_t, uint32_t>> entries;
+  uint32_t next_value = 0;
+  for (int64_t key = 0; key < 60; key++) {
+    int count = key % 3 == 0 ? 1 : static_cast<int>(key % 7);
+    if (key == 30) {
+      count = posting_page_capacity * 2 + 10;
+    }
+    for (int i = 0; i < count; i++) {
+      entries.emplace_back(key, next_value);
+      expected[key].push_back(next_value++);
+    }
+  }
+  std::shuffle(entries.begin(), entries.end(), std::mt19937(5));
+  GenericKey<8> index_key;
+  for (const auto &[key, value] : entries) {
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.Insert(index_key, RID(0, value)));
+  }
+  CheckValues(&tree, expected);
+
+  // Scenario: a range scan from a key with a posting list streams all of its values before moving on.
+  index_key.SetFromInteger(30);
+  {
+    auto iterator = tree.Begin(index_key);
+    for (size_t i = 0; i < expected[30].size(); i++, ++iterator) {
+      ASSERT_FALSE(iterator.IsEnd());
+      ASSERT_EQ(30, (*iterator).first.ToString());
+    }
+    ASSERT_EQ(31, (*iterator).first.ToString());
+  }
+
+  // Scenario: removing single values shrinks posting lists, down to a single value and then none; values that are
+  // not there are ignored.
+  std::mt19937 gen(9);
+  for (auto &[key, values] : expected) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, RID(0, next_value));
+    std::shuffle(values.begin(), values.end(), gen);
+    size_t keep = key % 2 == 0 ? 0 : values.size() / 3;
+    while (values.size() > keep) {
+      tree.Remove(index_key, RID(0, values.back()));
+      values.pop_back();
+    }
+  }
+  CheckValues(&tree, expected);
+
+  // Scenario: values can be added back to keys that were folded back into a single value or removed.
+  for (auto &[key, values] : expected) {
+    index_key.SetFromInteger(key);
+    for (int i = 0; i < 3; i++) {
+      ASSERT_TRUE(tree.Insert(index_key, RID(0, next_value)));
+      values.push_back(next_value++);
+    }
+  }
+  CheckValues(&tree, expected);
+
+  // Scenario: removing a key without a value drops all of its values.
+  for (auto &[key, values] : expected) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key);
+    values.clear();
+  }
+  CheckValues(&tree, expected);
+  EXPECT_TRUE(tree.IsEmpty());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeDuplicateTest, BulkLoadTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  Tree tree("foo_pk", bpm, comparator, 4, 5, INVALID_PAGE_ID, false);
+
+  // Scenario: a bulk load keeps every value of a key, rather than the first one only.
+  std::map<int64_t, std::vector<uint32_t>> expected;
+  std::vector<std::pair<int64_t, uint32_t>> entries;
+  for (uint32_t value = 0; value < 3000; value++) {
+    int64_t key = value % 40 == 0 ? 7 : value / 40;
+    entries.emplace_back(key, value);
+    expected[key].push_back(value);
+  }
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](const auto &a, const auto &b) { return a.first < b.first; });
+  size_t next = 0;
+  ASSERT_TRUE(tree.BulkLoad([&](std::pair<GenericKey<8>, RID> *item) {
+    if (next == entries.size()) {
+      return false;
+    }
+    item->first.SetFromInteger(entries[next].first);
+    item->second = RID(0, entries[next].second);
+    next++;
+    return true;
+  }));
+  CheckValues(&tree, expected);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeDuplicateTest, ConcurrentTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(128, disk_manager);
+  Tree tree("foo_pk", bpm, comparator, 4, 5, INVALID_PAGE_ID, false);
+
+  // Scenario: threads add values to the same few keys while others remove theirs and scan, so that posting lists
+  // grow and shrink under the leaves splitting and merging around them.
+  const int num_threads = 4;
+  const uint32_t values_per_thread = 2000;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid]() {
+      GenericKey<8> index_key;
+      for (uint32_t i = 0; i < values_per_thread; i++) {
+        uint32_t value = tid * values_per_thread + i;
+        index_key.SetFromInteger(value % 50);
+        tree.Insert(index_key, RID(0, value));
+        if (i % 2 == 1) {
+          uint32_t removed = value - 1;
+          index_key.SetFromInteger(removed % 50);
+          tree.Remove(index_key, RID(0, removed));
+        }
+        if (i % 100 == 0) {
+          for (auto iterator = tree.Begin(); !iterator.IsEnd(); ++iterator) {
+          }
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::map<int64_t, std::vector<uint32_t>> expected;
+  for (uint32_t value = 1; value < num_threads * values_per_thread; value += 2) {
+    expected[value % 50].push_back(value);
+  }
+  CheckValues(&tree, expected);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
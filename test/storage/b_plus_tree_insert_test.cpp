@@ -20,7 +20,7 @@
 
 namespace bustub {
 
-TEST(BPlusTreeTests, DISABLED_InsertTest1) {
+TEST(BPlusTreeTests, InsertTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -62,9 +62,10 @@ TEST(BPlusTreeTests, DISABLED_InsertTest1) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
 }
 
-TEST(BPlusTreeTests, DISABLED_InsertTest2) {
+TEST(BPlusTreeTests, InsertTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -125,9 +126,10 @@ TEST(BPlusTreeTests, DISABLED_InsertTest2) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
 }
 
-TEST(BPlusTreeTests, DISABLED_InsertTest3) {
+TEST(BPlusTreeTests, InsertTest3) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -194,5 +196,6 @@ TEST(BPlusTreeTests, DISABLED_InsertTest3) {
   delete bpm;
   remove("test.db");
   remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
 }
 }  // namespace bustub
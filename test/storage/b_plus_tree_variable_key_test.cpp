@@ -0,0 +1,219 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_variable_key_test.cpp
+//
+// Identification: test/storage/b_plus_tree_variable_key_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using StringTree = BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
+using StringLeafPage = BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>;
+
+// Entries of a leaf page that stores every key in all its 64 bytes.
+const size_t FIXED_LEAF_ENTRIES = (BUSTUB_PAGE_SIZE - 28) / sizeof(std::pair<GenericKey<64>, RID>);
+
+auto MakeKey(const std::string &value, Schema *schema) -> GenericKey<64> {
+  GenericKey<64> key;
+  key.SetFromKey(Tuple({Value(TypeId::VARCHAR, value)}, schema));
+  return key;
+}
+
+auto CustomerName(int64_t id) -> std::string {
+  char name[32];
+  snprintf(name, sizeof(name), "customer#%09ld", id);
+  return name;
+}
+
+/** Check that the tree holds exactly the names, in order, through point lookups and a full scan. */
+void CheckNames(StringTree *tree, const std::set<std::string> &names, Schema *schema) {
+  std::vector<RID> rids;
+  for (const auto &name : names) {
+    rids.clear();
+    ASSERT_TRUE(tree->GetValue(MakeKey(name, schema), &rids)) << name;
+    ASSERT_EQ(std::hash<std::string>{}(name) % 1000000, rids[0].GetSlotNum()) << name;
+  }
+  auto expected = names.begin();
+  for (auto iterator = tree->Begin(); !iterator.IsEnd(); ++iterator, ++expected) {
+    ASSERT_NE(names.end(), expected);
+    ASSERT_EQ(*expected, (*iterator).first.ToValue(schema, 0).ToString());
+  }
+  ASSERT_EQ(names.end(), expected);
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeVariableKeyTest, LeafPageTest) {
+  auto key_schema = ParseCreateStatement("a varchar(40)");
+  GenericComparator<64> comparator(key_schema.get());
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager);
+  page_id_t page_id;
+  auto guard = bpm->NewPageGuarded(&page_id);
+  auto *leaf = guard.AsMut<StringLeafPage>();
+  leaf->Init(page_id, INVALID_PAGE_ID, (BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (sizeof(RID) + 4));
+
+  // Scenario: keys that share their first bytes are stored without the prefix and the padding, so a page holds
+  // several times as many of them as fixed-size slots would.
+  int64_t id = 0;
+  while (leaf->CanInsert(MakeKey(CustomerName(id * 7), key_schema.get()))) {
+    leaf->Insert(MakeKey(CustomerName(id * 7), key_schema.get()), RID(0, id), comparator);
+    id++;
+  }
+  EXPECT_GT(static_cast<size_t>(leaf->GetSize()), 3 * FIXED_LEAF_ENTRIES);
+  EXPECT_GT(leaf->GetPrefixLength(), 8);
+  EXPECT_LE(leaf->GetUsedBytes(), static_cast<size_t>(BUSTUB_PAGE_SIZE));
+  for (int i = 0; i < leaf->GetSize(); i++) {
+    ASSERT_EQ(CustomerName(i * 7), leaf->KeyAt(i).ToValue(key_schema.get(), 0).ToString());
+    ASSERT_EQ(RID(0, i), leaf->ValueAt(i));
+  }
+
+  // Scenario: a key with another prefix shortens the prefix of the page, and the keys are stored anew around it.
+  for (int i = 0; i < id; i += 2) {
+    leaf->RemoveAndDeleteRecord(MakeKey(CustomerName(i * 7), key_schema.get()), comparator);
+  }
+  size_t prefix_length = leaf->GetPrefixLength();
+  ASSERT_TRUE(leaf->CanInsert(MakeKey("client", key_schema.get())));
+  leaf->Insert(MakeKey("client", key_schema.get()), RID(1, 0), comparator);
+  EXPECT_LT(leaf->GetPrefixLength(), prefix_length);
+  ASSERT_EQ(0, leaf->FindKey(MakeKey("client", key_schema.get()), comparator));
+  for (int i = 1; i < id; i += 2) {
+    ASSERT_EQ(i / 2 + 1, leaf->FindKey(MakeKey(CustomerName(i * 7), key_schema.get()), comparator));
+  }
+  ASSERT_EQ(-1, leaf->FindKey(MakeKey(CustomerName(0), key_schema.get()), comparator));
+
+  // Scenario: an entry too large for what is left of the page does not fit, whatever the max size.
+  leaf->Init(page_id, INVALID_PAGE_ID, 1000000);
+  std::string long_name(36, 'x');
+  for (int i = 0; leaf->CanInsert(MakeKey(long_name + std::to_string(i), key_schema.get())); i++) {
+    leaf->Insert(MakeKey(long_name + std::to_string(i), key_schema.get()), RID(0, i), comparator);
+  }
+  EXPECT_LE(leaf->GetUsedBytes(), static_cast<size_t>(BUSTUB_PAGE_SIZE));
+  EXPECT_GT(leaf->GetUsedBytes() + sizeof(GenericKey<64>) + sizeof(RID), static_cast<size_t>(BUSTUB_PAGE_SIZE));
+
+  guard.Drop();
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeVariableKeyTest, StringKeyTest) {
+  auto key_schema = ParseCreateStatement("a varchar(40)");
+  GenericComparator<64> comparator(key_schema.get());
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+  StringTree tree("foo_pk", bpm, comparator);
+  std::mt19937 rng(24);
+
+  // Scenario: names of many lengths, some sharing long prefixes, inserted in a random order.
+  std::vector<std::string> names;
+  for (int64_t i = 0; i < 6000; i++) {
+    names.push_back(CustomerName(i));
+    names.push_back(std::string(1 + i % 39, static_cast<char>('a' + i % 26)) + std::to_string(i));
+  }
+  std::shuffle(names.begin(), names.end(), rng);
+  for (const auto &name : names) {
+    ASSERT_TRUE(tree.Insert(MakeKey(name, key_schema.get()), RID(0, std::hash<std::string>{}(name) % 1000000)));
+  }
+  std::set<std::string> expected(names.begin(), names.end());
+  CheckNames(&tree, expected, key_schema.get());
+
+  // Scenario: the leaves hold more keys than fixed-size slots would allow.
+  size_t leaves = 0;
+  {
+    auto guard = bpm->FetchPageRead(tree.GetRootPageId());
+    while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+      guard = bpm->FetchPageRead(guard.As<BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>>()
+                                      ->ValueAt(0));
+    }
+    while (true) {
+      leaves++;
+      page_id_t next_page_id = guard.As<StringLeafPage>()->GetNextPageId();
+      if (next_page_id == INVALID_PAGE_ID) {
+        break;
+      }
+      guard = bpm->FetchPageRead(next_page_id);
+    }
+  }
+  EXPECT_LT(leaves * FIXED_LEAF_ENTRIES, names.size());
+
+  // Scenario: removing most keys merges and redistributes leaves of uneven sizes, then the tree empties.
+  std::shuffle(names.begin(), names.end(), rng);
+  for (size_t i = 0; i < names.size(); i++) {
+    tree.Remove(MakeKey(names[i], key_schema.get()));
+    expected.erase(names[i]);
+    if (i % 3000 == 0 || i == names.size() - 100) {
+      CheckNames(&tree, expected, key_schema.get());
+    }
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BPlusTreeVariableKeyTest, BulkLoadTest) {
+  auto key_schema = ParseCreateStatement("a varchar(40)");
+  GenericComparator<64> comparator(key_schema.get());
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  page_id_t header_page_id;
+  bpm->NewPage(&header_page_id);
+
+  // Scenario: leaves are bulk loaded to the fill factor of their bytes, leaving room for inserts.
+  for (size_t count : {1, 150, 151, 5000}) {
+    StringTree tree("foo_pk", bpm, comparator);
+    std::set<std::string> expected;
+    for (size_t i = 0; i < count; i++) {
+      expected.insert(CustomerName(i * 2));
+    }
+    auto next = expected.begin();
+    ASSERT_TRUE(tree.BulkLoad([&](std::pair<GenericKey<64>, RID> *item) {
+      if (next == expected.end()) {
+        return false;
+      }
+      *item = {MakeKey(*next, key_schema.get()), RID(0, std::hash<std::string>{}(*next) % 1000000)};
+      ++next;
+      return true;
+    }));
+    CheckNames(&tree, expected, key_schema.get());
+
+    for (size_t i = 0; i < count; i += 3) {
+      auto name = CustomerName(i * 2 + 1);
+      ASSERT_TRUE(tree.Insert(MakeKey(name, key_schema.get()), RID(0, std::hash<std::string>{}(name) % 1000000)));
+      expected.insert(name);
+    }
+    CheckNames(&tree, expected, key_schema.get());
+    for (const auto &name : std::set<std::string>(expected)) {
+      tree.Remove(MakeKey(name, key_schema.get()));
+    }
+    EXPECT_TRUE(tree.IsEmpty());
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
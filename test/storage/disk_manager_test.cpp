@@ -10,11 +10,21 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <sys/resource.h>
+#include <atomic>
+#include <csignal>
+#include <chrono>  // NOLINT
 #include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>  // NOLINT
 
+#include "buffer/buffer_pool_manager_instance.h"
 #include "common/exception.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 
@@ -24,12 +34,14 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    DiskManager::RemoveSidecarFiles("test.db");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    DiskManager::RemoveSidecarFiles("test.db");
   };
 };
 
@@ -55,6 +67,519 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WriteErrorTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  std::strncpy(data, "A test string.", sizeof(data));
+  ASSERT_TRUE(dm.WritePage(0, data));
+
+  // Scenario: writes that would grow the file past its size limit fail, and leave the checksum of the page as it was.
+  rlimit old_limit;
+  ASSERT_EQ(0, getrlimit(RLIMIT_FSIZE, &old_limit));
+  auto old_handler = signal(SIGXFSZ, SIG_IGN);
+  rlimit limit = old_limit;
+  limit.rlim_cur = BUSTUB_PAGE_SIZE;
+  ASSERT_EQ(0, setrlimit(RLIMIT_FSIZE, &limit));
+  EXPECT_FALSE(dm.WritePage(1, data));
+  std::memset(buf, 1, sizeof(buf));
+  EXPECT_FALSE(dm.WritePage(1, buf));
+  setrlimit(RLIMIT_FSIZE, &old_limit);
+  signal(SIGXFSZ, old_handler);
+
+  // Page 1 becomes a hole once the file grows past it, and reads as the zeros it holds.
+  ASSERT_TRUE(dm.WritePage(2, data));
+  EXPECT_NO_THROW(dm.ReadPage(1, buf));
+  EXPECT_EQ(0, buf[0]);
+
+  // Scenario: the write succeeds once it is tried again.
+  ASSERT_TRUE(dm.WritePage(1, data));
+  dm.ReadPage(1, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  // Scenario: a run that is cut short by the limit fails; the pages before the limit are written, and the ones after
+  // it keep their old checksums.
+  std::memset(buf, 1, sizeof(buf));
+  const char *run[] = {buf, buf, buf};
+  old_handler = signal(SIGXFSZ, SIG_IGN);
+  limit.rlim_cur = 5 * BUSTUB_PAGE_SIZE;
+  ASSERT_EQ(0, setrlimit(RLIMIT_FSIZE, &limit));
+  EXPECT_FALSE(dm.WritePages(3, run, 3));
+
+  // Scenario: queued pages that cannot be written stay queued, and are written once the limit is lifted.
+  dm.SetWriteCombining(true);
+  ASSERT_TRUE(dm.WritePage(6, data));
+  dm.Sync();
+  EXPECT_EQ(1U, dm.GetNumQueuedWrites());
+  setrlimit(RLIMIT_FSIZE, &old_limit);
+  signal(SIGXFSZ, old_handler);
+  dm.Sync();
+  EXPECT_EQ(0U, dm.GetNumQueuedWrites());
+
+  for (page_id_t page_id = 3; page_id < 5; page_id++) {
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(1, buf[0]);
+  }
+  EXPECT_NO_THROW(dm.ReadPage(5, buf));
+  EXPECT_EQ(0, buf[0]);
+  dm.ReadPage(6, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  const size_t num_pages = 5;
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[num_pages][BUSTUB_PAGE_SIZE];
+  const char *pages_data[num_pages];
+  for (size_t i = 0; i < num_pages; i++) {
+    std::memset(data[i], static_cast<int>('a' + i), BUSTUB_PAGE_SIZE);
+    pages_data[i] = data[i];
+  }
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+
+  // A run that starts past the end of the file extends it; the pages in between read back as zeros.
+  dm.WritePages(3, pages_data, num_pages);
+  dm.WritePage(0, data[0]);
+  dm.WritePages(1, pages_data + 1, 1);
+  dm.Sync();
+  EXPECT_EQ(static_cast<int>(num_pages) + 2, dm.GetNumWrites());
+
+  for (size_t i = 0; i < num_pages; i++) {
+    dm.ReadPage(3 + i, buf);
+    EXPECT_EQ(std::memcmp(buf, data[i], sizeof(buf)), 0);
+  }
+  dm.ReadPage(1, buf);
+  EXPECT_EQ(std::memcmp(buf, data[1], sizeof(buf)), 0);
+  dm.ReadPage(2, buf);
+  EXPECT_EQ(buf[0], 0);
+  EXPECT_EQ(buf[BUSTUB_PAGE_SIZE - 1], 0);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WriteCombiningTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    dm.SetWriteCombining(true);
+
+    // Scenario: writes are queued, a page written twice is queued once, and reads see the queued pages.
+    for (int page_id = 9; page_id >= 0; page_id--) {
+      snprintf(data, sizeof(data), "page %d", page_id);
+      dm.WritePage(page_id, data);
+    }
+    snprintf(data, sizeof(data), "page 5 again");
+    dm.WritePage(5, data);
+    EXPECT_EQ(10U, dm.GetNumQueuedWrites());
+    EXPECT_EQ(0, dm.GetNumWrites());
+    dm.ReadPage(5, buf);
+    EXPECT_STREQ("page 5 again", buf);
+
+    // Scenario: Sync() writes the queue; so does filling it.
+    dm.Sync();
+    EXPECT_EQ(0U, dm.GetNumQueuedWrites());
+    EXPECT_EQ(10, dm.GetNumWrites());
+    for (int page_id = 10; page_id < 10 + WRITE_COMBINE_PAGES; page_id++) {
+      snprintf(data, sizeof(data), "page %d", page_id);
+      dm.WritePage(page_id, data);
+    }
+    EXPECT_EQ(0U, dm.GetNumQueuedWrites());
+    EXPECT_EQ(10 + WRITE_COMBINE_PAGES, dm.GetNumWrites());
+
+    // Scenario: a vectored write supersedes a queued write of the same page, and a freed page is not written.
+    snprintf(data, sizeof(data), "stale");
+    dm.WritePage(1, data);
+    dm.WritePage(2, data);
+    snprintf(data, sizeof(data), "page 1 written directly");
+    const char *pages_data[] = {data};
+    dm.WritePages(1, pages_data, 1);
+    dm.DeallocatePage(2);
+    EXPECT_EQ(0U, dm.GetNumQueuedWrites());
+
+    // Scenario: queued writes are written when the disk manager goes away.
+    snprintf(data, sizeof(data), "queued at shutdown");
+    dm.WritePage(100, data);
+    dm.ShutDown();
+  }
+
+  auto dm = DiskManager(db_file);
+  dm.ReadPage(0, buf);
+  EXPECT_STREQ("page 0", buf);
+  dm.ReadPage(5, buf);
+  EXPECT_STREQ("page 5 again", buf);
+  dm.ReadPage(1, buf);
+  EXPECT_STREQ("page 1 written directly", buf);
+  dm.ReadPage(2, buf);
+  EXPECT_STREQ("page 2", buf);
+  dm.ReadPage(100, buf);
+  EXPECT_STREQ("queued at shutdown", buf);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, LargeFileTest) {
+  // The first page past the 8 GB mark. The file is sparse, so this needs no 8 GB of disk.
+  const auto boundary_page_id = static_cast<page_id_t>((int64_t{8} << 30) / BUSTUB_PAGE_SIZE);
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    for (auto page_id : {0, boundary_page_id - 1, boundary_page_id, boundary_page_id + 1}) {
+      snprintf(data, sizeof(data), "page %d", page_id);
+      dm.WritePage(page_id, data);
+    }
+    const char *pages_data[] = {data};
+    snprintf(data, sizeof(data), "page %d", boundary_page_id + 10);
+    dm.WritePages(boundary_page_id + 10, pages_data, 1);
+
+    // Scenario: pages on both sides of the boundary read back, and so do the holes in between, as zeros.
+    dm.ReadPage(boundary_page_id, buf);
+    EXPECT_EQ("page " + std::to_string(boundary_page_id), std::string(buf));
+    dm.ReadPage(boundary_page_id + 5, buf);
+    EXPECT_EQ(0, buf[0]);
+    dm.ReadPage(boundary_page_id / 2, buf);
+    EXPECT_EQ(0, buf[0]);
+    dm.ShutDown();
+  }
+  EXPECT_EQ((static_cast<int64_t>(boundary_page_id) + 11) * BUSTUB_PAGE_SIZE,
+            static_cast<int64_t>(std::ifstream(db_file, std::ios::binary | std::ios::ate).tellg()));
+
+  // Scenario: after reopening, the pages past the boundary still match their checksums, and reads past the end of the
+  // file are zeros.
+  auto dm = DiskManager(db_file);
+  for (auto page_id : {0, boundary_page_id - 1, boundary_page_id, boundary_page_id + 1, boundary_page_id + 10}) {
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(buf));
+  }
+  memset(buf, 'x', sizeof(buf));
+  dm.ReadPage(boundary_page_id * 2, buf);
+  EXPECT_EQ(0, buf[0]);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ReadPageAsyncTest) {
+  const size_t num_pages = 16;
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  char bufs[num_pages][BUSTUB_PAGE_SIZE];
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  for (size_t i = 0; i < num_pages; i++) {
+    std::memset(data, static_cast<int>('a' + i), sizeof(data));
+    dm.WritePage(i, data);
+  }
+
+  std::atomic<size_t> done{0};
+  for (size_t i = 0; i < num_pages; i++) {
+    dm.ReadPageAsync(i, bufs[i], [&done](bool) { done++; });
+  }
+  // ShutDown drains the outstanding reads before closing the file.
+  dm.ShutDown();
+  EXPECT_EQ(num_pages, done.load());
+  for (size_t i = 0; i < num_pages; i++) {
+    EXPECT_EQ(static_cast<char>('a' + i), bufs[i][0]);
+    EXPECT_EQ(static_cast<char>('a' + i), bufs[i][BUSTUB_PAGE_SIZE - 1]);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, MmapReadPageTest) {
+  const size_t num_pages = 8;
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    for (size_t i = 0; i < num_pages; i++) {
+      std::memset(data, static_cast<int>('a' + i), sizeof(data));
+      dm.WritePage(i, data);
+    }
+    dm.ShutDown();
+  }
+
+  DiskManagerMmap dm(db_file);
+  EXPECT_EQ(num_pages, dm.GetNumPages());
+  for (size_t i = 0; i < num_pages; i++) {
+    dm.ReadPage(i, buf);
+    EXPECT_EQ(static_cast<char>('a' + i), buf[0]);
+    EXPECT_EQ(static_cast<char>('a' + i), buf[BUSTUB_PAGE_SIZE - 1]);
+    ASSERT_NE(nullptr, dm.GetPageData(i));
+    EXPECT_EQ(std::memcmp(buf, dm.GetPageData(i), sizeof(buf)), 0);
+  }
+
+  // Reads past the end of the file come back as zeros, asynchronous reads complete right away.
+  bool done = false;
+  dm.ReadPageAsync(num_pages, buf, [&done](bool) { done = true; });
+  EXPECT_TRUE(done);
+  EXPECT_EQ(0, buf[0]);
+  EXPECT_EQ(nullptr, dm.GetPageData(num_pages));
+
+  EXPECT_THROW(dm.WritePage(0, data), Exception);
+  EXPECT_THROW(DiskManagerMmap("dev/null\\/foo/bar/baz/test.db"), Exception);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumTest) {
+  const size_t num_pages = 4;
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    for (size_t i = 0; i < num_pages; i++) {
+      std::memset(data, static_cast<int>('a' + i), sizeof(data));
+      dm.WritePage(i, data);
+    }
+    dm.ShutDown();
+  }
+
+  // Tear page 2 behind the disk manager's back: its second half is left over from an older version.
+  {
+    std::fstream file(db_file, std::ios::binary | std::ios::in | std::ios::out);
+    std::memset(data, 'z', sizeof(data));
+    file.seekp(2 * BUSTUB_PAGE_SIZE + BUSTUB_PAGE_SIZE / 2);
+    file.write(data, BUSTUB_PAGE_SIZE / 2);
+  }
+
+  // The checksums were persisted, so a new disk manager catches the torn page, and only that one.
+  {
+    auto dm = DiskManager(db_file);
+    dm.ReadPage(1, buf);
+    EXPECT_EQ('b', buf[0]);
+    EXPECT_THROW(dm.ReadPage(2, buf), Exception);
+    std::atomic<int> verified{-1};
+    dm.ReadPageAsync(2, buf, [&verified](bool ok) { verified = ok ? 1 : 0; });
+    while (verified.load() < 0) {
+      std::this_thread::yield();
+    }
+    EXPECT_EQ(0, verified.load());
+
+    // With verification off, the torn page is handed out as is.
+    verify_page_checksums = false;
+    EXPECT_NO_THROW(dm.ReadPage(2, buf));
+    verify_page_checksums = true;
+    EXPECT_EQ('c', buf[0]);
+    EXPECT_EQ('z', buf[BUSTUB_PAGE_SIZE - 1]);
+
+    // Rewriting the page records a new checksum.
+    dm.WritePage(2, buf);
+    EXPECT_NO_THROW(dm.ReadPage(2, buf));
+    dm.ShutDown();
+  }
+
+  DiskManagerMmap mmap_dm(db_file);
+  EXPECT_NO_THROW(mmap_dm.ReadPage(2, buf));
+  mmap_dm.ShutDown();
+
+  // A database file without a checksum file is not verified.
+  remove("test.crc");
+  DiskManagerMmap unchecked_dm(db_file);
+  EXPECT_NO_THROW(unchecked_dm.ReadPage(2, buf));
+  unchecked_dm.ShutDown();
+}
+
+/** Copy the files of a database that is still open, as a crash would leave them: unsynced writes may be there or not. */
+void CopyDatabase(const std::string &from, const std::string &to) {
+  for (const auto *extension : {".db", ".crc", ".fsm"}) {
+    std::ifstream in(from + extension, std::ios::binary);
+    std::ofstream out(to + extension, std::ios::binary | std::ios::trunc);
+    out << in.rdbuf();
+  }
+}
+
+void RemoveDatabase(const std::string &name) {
+  for (const auto *extension : {".db", ".log", ".crc", ".fsm"}) {
+    remove((name + extension).c_str());
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CrashTest) {
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  auto write_page = [&data](DiskManager *dm, page_id_t page_id, char c) {
+    std::memset(data, c, sizeof(data));
+    dm->WritePage(page_id, data);
+  };
+  auto overwrite = [&data](const std::string &db_file, size_t offset, size_t length, char c) {
+    std::fstream file(db_file, std::ios::binary | std::ios::in | std::ios::out);
+    std::memset(data, c, sizeof(data));
+    file.seekp(static_cast<std::streamoff>(offset));
+    file.write(data, static_cast<std::streamsize>(length));
+  };
+  RemoveDatabase("crash");
+  RemoveDatabase("crash2");
+
+  {
+    // Combined writes sync the checksums of a batch before its pages.
+    auto dm = DiskManager("test.db");
+    dm.SetWriteCombining(true);
+    write_page(&dm, 0, 'a');
+    write_page(&dm, 1, 'b');
+    write_page(&dm, 2, 'c');
+    dm.Sync();
+    write_page(&dm, 0, 'A');
+    write_page(&dm, 1, 'B');
+    write_page(&dm, 2, 'C');
+    write_page(&dm, 3, 'D');
+    dm.SetWriteCombining(false);
+    CopyDatabase("test", "crash");
+    dm.ShutDown();
+  }
+
+  // Scenario: in the crashed copy, page 0 lost its last write, page 1 kept it, page 2 is torn between the two, and
+  // the first write of page 3 never made it. Only the torn page is corrupt.
+  overwrite("crash.db", 0, BUSTUB_PAGE_SIZE, 'a');
+  overwrite("crash.db", 2 * BUSTUB_PAGE_SIZE + BUSTUB_PAGE_SIZE / 2, BUSTUB_PAGE_SIZE / 2, 'c');
+  overwrite("crash.db", 3 * BUSTUB_PAGE_SIZE, BUSTUB_PAGE_SIZE, 0);
+  {
+    auto dm = DiskManager("crash.db");
+    dm.ReadPage(0, buf);
+    EXPECT_EQ('a', buf[0]);
+    dm.ReadPage(1, buf);
+    EXPECT_EQ('B', buf[0]);
+    EXPECT_THROW(dm.ReadPage(2, buf), Exception);
+    dm.ReadPage(3, buf);
+    EXPECT_EQ(0, buf[0]);
+
+    // Scenario: after the crash, page 0 is written again and the machine crashes once more before the write reaches
+    // the disk. The version the page falls back to is the one that was on disk, not the write that was lost.
+    write_page(&dm, 0, 'x');
+    CopyDatabase("crash", "crash2");
+    dm.ShutDown();
+  }
+  overwrite("crash2.db", 0, BUSTUB_PAGE_SIZE, 'a');
+  {
+    auto dm = DiskManager("crash2.db");
+    dm.ReadPage(0, buf);
+    EXPECT_EQ('a', buf[0]);
+    dm.ShutDown();
+  }
+
+  // Scenario: a database that was shut down cleanly reopens with its pages as they were last written.
+  {
+    auto dm = DiskManager("crash.db");
+    dm.ReadPage(0, buf);
+    EXPECT_EQ('x', buf[0]);
+
+    // Scenario: a page written without combining reached the disk after the last sync, but its checksum did not. It
+    // is taken as it is, and so are the other pages that match neither of their checksums.
+    write_page(&dm, 1, 'b');
+    dm.Sync();
+    write_page(&dm, 0, 'y');
+    CopyDatabase("crash", "crash2");
+    dm.ShutDown();
+  }
+  overwrite("crash2.db", 0, BUSTUB_PAGE_SIZE, 'z');
+  {
+    auto dm = DiskManager("crash2.db");
+    dm.ReadPage(0, buf);
+    EXPECT_EQ('z', buf[0]);
+    dm.ReadPage(1, buf);
+    EXPECT_EQ('b', buf[0]);
+    EXPECT_NO_THROW(dm.ReadPage(2, buf));
+    dm.ShutDown();
+  }
+  RemoveDatabase("crash");
+  RemoveDatabase("crash2");
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PageSizeTest) {
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    dm.WritePage(0, data);
+    dm.ShutDown();
+  }
+  // The database reopens with the page size it was created with.
+  {
+    auto dm = DiskManager(db_file);
+    dm.ShutDown();
+  }
+
+  // Pretend that the database was created with pages twice as large.
+  {
+    std::fstream file("test.crc", std::ios::binary | std::ios::in | std::ios::out);
+    uint32_t page_size = 2 * BUSTUB_PAGE_SIZE;
+    file.write(reinterpret_cast<const char *>(&page_size), sizeof(page_size));
+  }
+  EXPECT_THROW(DiskManager{db_file}, Exception);
+  EXPECT_THROW(DiskManagerMmap{db_file}, Exception);
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreeSpaceMapTest) {
+  const page_id_t num_pages = 200;
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      std::memset(data, page_id, sizeof(data));
+      dm.WritePage(page_id, data);
+    }
+    EXPECT_EQ(INVALID_PAGE_ID, dm.AllocateFreePage(1, 0));
+
+    for (page_id_t page_id : {7, 70, 130, 131}) {
+      EXPECT_TRUE(dm.DeallocatePage(page_id));
+    }
+    // Freeing a free page again is refused.
+    EXPECT_FALSE(dm.DeallocatePage(7));
+    EXPECT_FALSE(dm.DeallocatePage(INVALID_PAGE_ID));
+    EXPECT_EQ(4U, dm.GetNumFreePages());
+
+    // Each instance of a parallel buffer pool only gets its own pages, lowest first.
+    EXPECT_EQ(7, dm.AllocateFreePage(2, 1));
+    EXPECT_EQ(131, dm.AllocateFreePage(2, 1));
+    EXPECT_EQ(INVALID_PAGE_ID, dm.AllocateFreePage(2, 1));
+    EXPECT_EQ(70, dm.AllocateFreePage(2, 0));
+    EXPECT_EQ(1U, dm.GetNumFreePages());
+    dm.ShutDown();
+  }
+
+  // The map survives a restart.
+  auto dm = DiskManager(db_file);
+  EXPECT_EQ(1U, dm.GetNumFreePages());
+  EXPECT_EQ(130, dm.AllocateFreePage(1, 0));
+  EXPECT_EQ(INVALID_PAGE_ID, dm.AllocateFreePage(1, 0));
+
+  // Only the free pages at the end of the file are truncated.
+  EXPECT_EQ(0U, dm.Compact());
+  for (page_id_t page_id = 100; page_id < num_pages; page_id++) {
+    if (page_id != 150) {
+      dm.DeallocatePage(page_id);
+    }
+  }
+  EXPECT_EQ(static_cast<size_t>(num_pages - 151), dm.Compact());
+  EXPECT_EQ(151 * BUSTUB_PAGE_SIZE, std::ifstream(db_file, std::ios::binary | std::ios::ate).tellg());
+  dm.ReadPage(150, buf);
+  EXPECT_EQ(static_cast<char>(150), buf[0]);
+
+  // The truncated pages stay free, read as zeros and can be written again.
+  EXPECT_EQ(static_cast<size_t>(num_pages - 101), dm.GetNumFreePages());
+  dm.ReadPage(160, buf);
+  EXPECT_EQ(0, buf[0]);
+  std::memset(data, 'x', sizeof(data));
+  dm.WritePage(180, data);
+  dm.ReadPage(180, buf);
+  EXPECT_EQ('x', buf[0]);
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
@@ -75,4 +600,83 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
+/**
+ * Scan a `db_bytes` database file page by page and return the throughput in MB/s. With a buffer pool, the pages are
+ * fetched through a small pool as a sequential scan would; without one, they are read in place from the mapping.
+ */
+auto ScanBenchmarkCall(size_t db_bytes, bool use_mmap, bool use_buffer_pool) -> double {
+  const std::string db_name = "scan_bench.db";
+  const auto num_pages = static_cast<page_id_t>(db_bytes / BUSTUB_PAGE_SIZE);
+  remove(db_name.c_str());
+  {
+    DiskManager dm(db_name);
+    char data[BUSTUB_PAGE_SIZE];
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      std::memset(data, page_id, sizeof(data));
+      dm.WritePage(page_id, data);
+    }
+    dm.ShutDown();
+  }
+
+  std::unique_ptr<DiskManager> dm;
+  if (use_mmap) {
+    dm = std::make_unique<DiskManagerMmap>(db_name);
+  } else {
+    dm = std::make_unique<DiskManager>(db_name);
+  }
+  // Touch one byte per cache line of every page, so that every scan reads the same data.
+  auto consume = [](const char *data) {
+    size_t sum = 0;
+    for (int i = 0; i < BUSTUB_PAGE_SIZE; i += 64) {
+      sum += static_cast<unsigned char>(data[i]);
+    }
+    return sum;
+  };
+
+  size_t sum = 0;
+  auto clock_start = std::chrono::steady_clock::now();
+  if (use_buffer_pool) {
+    BufferPoolManagerInstance bpm(64, dm.get());
+    // The pages were written by another disk manager, so make this buffer pool hand out their ids.
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      bpm.NewPage(&page_id);
+      bpm.UnpinPage(page_id, false);
+    }
+    clock_start = std::chrono::steady_clock::now();
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      Page *page = bpm.FetchPage(page_id, AccessType::Scan);
+      sum += consume(page->GetData());
+      bpm.UnpinPage(page_id, false);
+    }
+  } else {
+    auto *mmap_dm = static_cast<DiskManagerMmap *>(dm.get());
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      sum += consume(mmap_dm->GetPageData(page_id));
+    }
+  }
+  auto clock_end = std::chrono::steady_clock::now();
+  EXPECT_NE(0U, sum);
+  dm->ShutDown();
+  dm.reset();
+  remove(db_name.c_str());
+  remove("scan_bench.log");
+  DiskManager::RemoveSidecarFiles(db_name);
+
+  double seconds = std::chrono::duration<double>(clock_end - clock_start).count();
+  return static_cast<double>(db_bytes >> 20) / seconds;
+}
+
+TEST_F(DiskManagerTest, DISABLED_MmapScanBenchmark) {  // NOLINT
+  std::cout << "<<< BEGIN" << std::endl;
+  for (size_t db_mb : {64, 256}) {
+    auto fstream = ScanBenchmarkCall(db_mb << 20, false, true);
+    auto mmap = ScanBenchmarkCall(db_mb << 20, true, true);
+    auto bypass = ScanBenchmarkCall(db_mb << 20, true, false);
+    std::cout << "db=" << db_mb << "MB buffer pool over DiskManager: " << fstream
+              << " MB/s, over DiskManagerMmap: " << mmap << " MB/s, mapping without buffer pool: " << bypass << " MB/s"
+              << std::endl;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
 }  // namespace bustub
@@ -0,0 +1,139 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_entry_sorter_test.cpp
+//
+// Identification: test/storage/index_entry_sorter_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/index_entry_sorter.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using Sorter = IndexEntrySorter<GenericKey<8>, RID, GenericComparator<8>>;
+
+/** Add keys[i] with a RID recording i, read everything back, and check it comes out sorted and stable. */
+void CheckSorted(Sorter *sorter, const std::vector<int64_t> &keys) {
+  for (size_t i = 0; i < keys.size(); i++) {
+    GenericKey<8> index_key;
+    index_key.SetFromInteger(keys[i]);
+    sorter->Add(index_key, RID(0, static_cast<uint32_t>(i)));
+  }
+  sorter->Finish();
+
+  std::vector<size_t> expected(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    expected[i] = i;
+  }
+  std::stable_sort(expected.begin(), expected.end(), [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+  std::pair<GenericKey<8>, RID> item;
+  for (size_t i = 0; i < expected.size(); i++) {
+    ASSERT_TRUE(sorter->Next(&item));
+    ASSERT_EQ(item.first.ToString(), keys[expected[i]]);
+    ASSERT_EQ(item.second.GetSlotNum(), expected[i]);
+  }
+  EXPECT_FALSE(sorter->Next(&item));
+  EXPECT_FALSE(sorter->Next(&item));
+}
+
+// NOLINTNEXTLINE
+TEST(IndexEntrySorterTest, InMemoryTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager);
+
+  std::mt19937 gen(7);
+  std::vector<int64_t> keys(1000);
+  for (auto &key : keys) {
+    key = static_cast<int64_t>(gen() % 300) - 150;
+  }
+
+  {
+    // Scenario: entries that fit in the budget are sorted without touching the buffer pool.
+    Sorter sorter(bpm, comparator);
+    CheckSorted(&sorter, keys);
+    EXPECT_EQ(0, sorter.GetNumRuns());
+  }
+  {
+    // Scenario: sorting nothing yields nothing.
+    Sorter sorter(bpm, comparator);
+    CheckSorted(&sorter, {});
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(IndexEntrySorterTest, ExternalMergeTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  const size_t buffer_pool_size = 32;
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  const size_t entries_per_run = 700;
+  const size_t budget = entries_per_run * sizeof(std::pair<GenericKey<8>, RID>);
+
+  std::mt19937 gen(11);
+  std::vector<int64_t> keys(entries_per_run * 20 + 123);
+  for (auto &key : keys) {
+    key = static_cast<int64_t>(gen() % 5000);
+  }
+
+  {
+    // Scenario: past the budget, entries are spilled in sorted runs that span several pages, and merged back in
+    // order, equal keys in the order they were added.
+    Sorter sorter(bpm, comparator, budget);
+    CheckSorted(&sorter, keys);
+    EXPECT_EQ(21, sorter.GetNumRuns());
+  }
+  {
+    // Scenario: a run that ends exactly at a page boundary.
+    const size_t per_page = BUSTUB_PAGE_SIZE / sizeof(std::pair<GenericKey<8>, RID>);
+    Sorter sorter(bpm, comparator, per_page * sizeof(std::pair<GenericKey<8>, RID>));
+    CheckSorted(&sorter, std::vector<int64_t>(keys.begin(), keys.begin() + per_page * 3));
+    EXPECT_EQ(3, sorter.GetNumRuns());
+  }
+  {
+    // Scenario: a sorter dropped halfway through the merge deletes the pages it did not read back.
+    Sorter sorter(bpm, comparator, budget);
+    for (size_t i = 0; i < keys.size(); i++) {
+      GenericKey<8> index_key;
+      index_key.SetFromInteger(keys[i]);
+      sorter.Add(index_key, RID(0, static_cast<uint32_t>(i)));
+    }
+    sorter.Finish();
+    std::pair<GenericKey<8>, RID> item;
+    for (size_t i = 0; i < keys.size() / 2; i++) {
+      ASSERT_TRUE(sorter.Next(&item));
+    }
+  }
+
+  // Every frame is free again: nothing was left pinned.
+  std::vector<BasicPageGuard> guards;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    guards.push_back(bpm->NewPageGuarded(&page_id));
+    ASSERT_TRUE(guards.back().IsValid());
+  }
+  guards.clear();
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,198 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring_disk_manager_test.cpp
+//
+// Identification: test/storage/io_uring_disk_manager_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/io_uring_disk_manager.h"
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+class IoUringDiskManagerTest : public ::testing::Test {
+ protected:
+  // This function is called before every test.
+  void SetUp() override {
+    remove("test.db");
+    remove("test.log");
+    DiskManager::RemoveSidecarFiles("test.db");
+  }
+
+  // This function is called after every test.
+  void TearDown() override {
+    remove("test.db");
+    remove("test.log");
+    DiskManager::RemoveSidecarFiles("test.db");
+  };
+};
+
+/** Fill a page with a pattern derived from its page id. */
+static void FillPage(page_id_t page_id, char *data) {
+  for (int i = 0; i < BUSTUB_PAGE_SIZE; i++) {
+    data[i] = static_cast<char>((page_id * 31 + i) % 251);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(IoUringDiskManagerTest, ReadWritePageTest) {
+  for (bool use_io_uring : {true, false}) {
+    remove("test.db");
+    IoUringDiskManager dm("test.db", use_io_uring);
+    if (use_io_uring) {
+      std::cout << "io_uring: " << dm.UsesIoUring() << ", O_DIRECT: " << dm.UsesDirectIo() << std::endl;
+    }
+
+    // One aligned buffer and one that is not, which goes through a bounce buffer under O_DIRECT.
+    alignas(DIRECT_IO_ALIGNMENT) char aligned[BUSTUB_PAGE_SIZE];
+    auto unaligned_storage = std::make_unique<char[]>(BUSTUB_PAGE_SIZE + 1);
+    char *unaligned = unaligned_storage.get() + 1;
+    char buf[BUSTUB_PAGE_SIZE];
+
+    FillPage(0, aligned);
+    FillPage(5, unaligned);
+    dm.WritePage(0, aligned);
+    dm.WritePage(5, unaligned);
+    EXPECT_EQ(2, dm.GetNumWrites());
+
+    dm.ReadPage(0, buf);
+    EXPECT_EQ(0, memcmp(buf, aligned, BUSTUB_PAGE_SIZE));
+    memset(aligned, 0, BUSTUB_PAGE_SIZE);
+    dm.ReadPage(5, aligned);
+    EXPECT_EQ(0, memcmp(aligned, unaligned, BUSTUB_PAGE_SIZE));
+
+    // The gap between the pages and the space past the end of the file read as zeros.
+    char zeros[BUSTUB_PAGE_SIZE] = {0};
+    dm.ReadPage(3, buf);
+    EXPECT_EQ(0, memcmp(buf, zeros, BUSTUB_PAGE_SIZE));
+    dm.ReadPage(100, buf);
+    EXPECT_EQ(0, memcmp(buf, zeros, BUSTUB_PAGE_SIZE));
+    dm.ShutDown();
+  }
+
+  // The file is a plain database file that DiskManager can read.
+  DiskManager dm("test.db");
+  char buf[BUSTUB_PAGE_SIZE];
+  char expected[BUSTUB_PAGE_SIZE];
+  FillPage(5, expected);
+  dm.ReadPage(5, buf);
+  EXPECT_EQ(0, memcmp(buf, expected, BUSTUB_PAGE_SIZE));
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(IoUringDiskManagerTest, ConcurrentIoTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 64;
+  const int num_pages = num_threads * pages_per_thread;
+  for (bool use_io_uring : {true, false}) {
+    remove("test.db");
+    IoUringDiskManager dm("test.db", use_io_uring);
+
+    // Concurrent writers keep more I/Os in flight than the queue holds.
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back([&dm, t] {
+        char data[BUSTUB_PAGE_SIZE];
+        for (int i = 0; i < pages_per_thread; i++) {
+          page_id_t page_id = i * num_threads + t;
+          FillPage(page_id, data);
+          dm.WritePage(page_id, data);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(num_pages, dm.GetNumWrites());
+
+    std::vector<char> pages(static_cast<size_t>(num_pages) * BUSTUB_PAGE_SIZE);
+    std::atomic<int> completed{0};
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      dm.ReadPageAsync(page_id, pages.data() + page_id * BUSTUB_PAGE_SIZE, [&completed](bool) { completed++; });
+    }
+    while (completed.load() < num_pages) {
+      std::this_thread::yield();
+    }
+    char expected[BUSTUB_PAGE_SIZE];
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      FillPage(page_id, expected);
+      ASSERT_EQ(0, memcmp(pages.data() + page_id * BUSTUB_PAGE_SIZE, expected, BUSTUB_PAGE_SIZE));
+    }
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(IoUringDiskManagerTest, WritePagesTest) {
+  const size_t num_pages = 3 * IO_URING_QUEUE_DEPTH + 7;
+  for (bool use_io_uring : {true, false}) {
+    remove("test.db");
+    IoUringDiskManager dm("test.db", use_io_uring);
+
+    std::vector<char> pages(num_pages * BUSTUB_PAGE_SIZE);
+    std::vector<const char *> pages_data(num_pages);
+    for (size_t i = 0; i < num_pages; i++) {
+      FillPage(static_cast<page_id_t>(i + 2), pages.data() + i * BUSTUB_PAGE_SIZE);
+      pages_data[i] = pages.data() + i * BUSTUB_PAGE_SIZE;
+    }
+    dm.WritePages(2, pages_data.data(), num_pages);
+    dm.Sync();
+    EXPECT_EQ(static_cast<int>(num_pages), dm.GetNumWrites());
+
+    char buf[BUSTUB_PAGE_SIZE];
+    for (size_t i = 0; i < num_pages; i++) {
+      dm.ReadPage(static_cast<page_id_t>(i + 2), buf);
+      ASSERT_EQ(0, memcmp(buf, pages_data[i], BUSTUB_PAGE_SIZE));
+    }
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(IoUringDiskManagerTest, BufferPoolTest) {
+  const size_t pool_size = 16;
+  const int num_pages = 64;
+  IoUringDiskManager dm("test.db");
+  {
+    BufferPoolManagerInstance bpm(pool_size, &dm);
+    for (int i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      Page *page = bpm.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      FillPage(page_id, page->GetData());
+      bpm.UnpinPage(page_id, true);
+    }
+    bpm.FlushAllPages();
+
+    // Read the pages back through prefetches and plain fetches.
+    char expected[BUSTUB_PAGE_SIZE];
+    for (page_id_t page_id = 0; page_id < num_pages; page_id++) {
+      if (page_id % READ_AHEAD_PAGES == 0) {
+        bpm.Prefetch(page_id + 1, READ_AHEAD_PAGES, AccessType::Scan);
+      }
+      Page *page = bpm.FetchPage(page_id, AccessType::Scan);
+      ASSERT_NE(nullptr, page);
+      FillPage(page_id, expected);
+      ASSERT_EQ(0, memcmp(page->GetData(), expected, BUSTUB_PAGE_SIZE));
+      bpm.UnpinPage(page_id, false);
+    }
+  }
+  dm.ShutDown();
+}
+
+}  // namespace bustub
@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// normalized_key_test.cpp
+//
+// Identification: test/storage/normalized_key_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/normalized_key.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+/** Compare the values column by column, with nulls first: the order normalized keys must keep. */
+auto CompareColumns(const std::vector<Value> &a, const std::vector<Value> &b) -> int {
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i].IsNull() || b[i].IsNull()) {
+      if (a[i].IsNull() != b[i].IsNull()) {
+        return a[i].IsNull() ? -1 : 1;
+      }
+      continue;
+    }
+    if (a[i].CompareLessThan(b[i]) == CmpBool::CmpTrue) {
+      return -1;
+    }
+    if (a[i].CompareGreaterThan(b[i]) == CmpBool::CmpTrue) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// NOLINTNEXTLINE
+TEST(NormalizedKeyTest, OrderTest) {
+  auto schema = ParseCreateStatement("a tinyint,b integer,c varchar(8),d bigint,e double,f smallint");
+  NormalizedComparator<64> comparator(schema.get());
+  std::mt19937 rng(25);
+
+  // Scenario: small domains, so that keys often tie on their first columns, with nulls, negative numbers and strings
+  // that contain zero bytes or are prefixes of each other.
+  const std::vector<std::string> strings = {"", "a", "ab", "abc", std::string("a\0", 2), std::string("a\0b", 3), "b",
+                                            "\xff", "ba"};
+  auto random_row = [&]() {
+    auto null = [&]() { return rng() % 8 == 0; };
+    std::vector<Value> row;
+    row.push_back(null() ? ValueFactory::GetNullValueByType(TypeId::TINYINT)
+                         : Value(TypeId::TINYINT, static_cast<int8_t>(static_cast<int>(rng() % 5) - 2)));
+    row.push_back(null() ? ValueFactory::GetNullValueByType(TypeId::INTEGER)
+                         : Value(TypeId::INTEGER, static_cast<int32_t>(rng() % 3) * 1000000 - 1000000));
+    row.push_back(null() ? ValueFactory::GetNullValueByType(TypeId::VARCHAR)
+                         : Value(TypeId::VARCHAR, strings[rng() % strings.size()]));
+    int64_t bigint = static_cast<int64_t>(rng() % 3 * (1ULL << 40)) - (int64_t{1} << 40);
+    row.push_back(null() ? ValueFactory::GetNullValueByType(TypeId::BIGINT) : Value(TypeId::BIGINT, bigint));
+    const double decimals[] = {-1e300, -2.5, -0.0, 0.0, 1e-300, 2.5, 1e300};
+    row.push_back(null() ? ValueFactory::GetNullValueByType(TypeId::DECIMAL)
+                         : Value(TypeId::DECIMAL, decimals[rng() % 7]));
+    row.push_back(null() ? ValueFactory::GetNullValueByType(TypeId::SMALLINT)
+                         : Value(TypeId::SMALLINT, static_cast<int16_t>(static_cast<int>(rng() % 3) * 300 - 300)));
+    return row;
+  };
+
+  std::vector<std::vector<Value>> rows;
+  std::vector<NormalizedKey<64>> keys;
+  for (int i = 0; i < 400; i++) {
+    rows.push_back(random_row());
+    keys.emplace_back();
+    keys.back().SetFromKey(Tuple(rows.back(), schema.get()), *schema);
+  }
+  for (size_t i = 0; i < rows.size(); i++) {
+    // Scenario: a key decodes to the values it was made of.
+    for (uint32_t column = 0; column < schema->GetColumnCount(); column++) {
+      Value value = keys[i].ToValue(schema.get(), column);
+      ASSERT_EQ(rows[i][column].IsNull(), value.IsNull()) << i << " " << column;
+      if (!value.IsNull()) {
+        ASSERT_EQ(CmpBool::CmpTrue, rows[i][column].CompareEquals(value)) << i << " " << column;
+      }
+    }
+    // Scenario: memcmp() orders the keys as comparing their columns one by one does.
+    for (size_t j = 0; j < rows.size(); j++) {
+      ASSERT_EQ(CompareColumns(rows[i], rows[j]), comparator(keys[i], keys[j])) << i << " " << j;
+    }
+  }
+
+  // Scenario: a key that does not fit throws rather than being cut short.
+  NormalizedKey<8> short_key;
+  auto varchar_schema = ParseCreateStatement("a varchar(16)");
+  EXPECT_THROW(short_key.SetFromKey(Tuple({Value(TypeId::VARCHAR, "longer than 8")}, varchar_schema.get()),
+                                    *varchar_schema),
+               Exception);
+}
+
+// NOLINTNEXTLINE
+TEST(NormalizedKeyTest, TreeTest) {
+  using Tree = BPlusTree<NormalizedKey<16>, RID, NormalizedComparator<16>>;
+  auto key_schema = ParseCreateStatement("a integer,b varchar(8)");
+  NormalizedComparator<16> comparator(key_schema.get());
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(32, disk_manager);
+  Tree tree("foo_pk", bpm, comparator, 5, 4, INVALID_PAGE_ID);
+  std::mt19937 rng(16);
+
+  // Scenario: two-column keys, negative integers first, ordered by the leaves comparing bytes in place.
+  std::vector<std::pair<int32_t, std::string>> rows;
+  for (int32_t a = -20; a < 20; a++) {
+    for (const auto *b : {"", "x", "xy", "y"}) {
+      rows.emplace_back(a * 1000, b);
+    }
+  }
+  auto make_key = [&](const std::pair<int32_t, std::string> &row) {
+    NormalizedKey<16> key;
+    key.SetFromKey(Tuple({Value(TypeId::INTEGER, row.first), Value(TypeId::VARCHAR, row.second)}, key_schema.get()),
+                   *key_schema);
+    return key;
+  };
+  auto shuffled = rows;
+  std::shuffle(shuffled.begin(), shuffled.end(), rng);
+  for (size_t i = 0; i < shuffled.size(); i++) {
+    ASSERT_TRUE(tree.Insert(make_key(shuffled[i]), RID(0, i)));
+  }
+  std::sort(rows.begin(), rows.end());
+  size_t i = 0;
+  for (auto iterator = tree.Begin(); !iterator.IsEnd(); ++iterator, ++i) {
+    ASSERT_LT(i, rows.size());
+    ASSERT_EQ(rows[i].first, (*iterator).first.ToValue(key_schema.get(), 0).GetAs<int32_t>());
+    ASSERT_EQ(rows[i].second, (*iterator).first.ToValue(key_schema.get(), 1).ToString());
+  }
+  ASSERT_EQ(rows.size(), i);
+
+  // Scenario: a scan from a key that is not in the tree starts at the next larger one.
+  {
+    auto iterator = tree.Begin(make_key({-3000, "xa"}));
+    ASSERT_FALSE(iterator.IsEnd());
+    EXPECT_EQ(0, comparator(make_key({-3000, "xy"}), (*iterator).first));
+  }
+
+  for (const auto &row : shuffled) {
+    std::vector<RID> result;
+    ASSERT_TRUE(tree.GetValue(make_key(row), &result));
+    tree.Remove(make_key(row));
+    ASSERT_FALSE(tree.GetValue(make_key(row), &result));
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,148 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/storage/page_guard_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, BasicTest) {
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+
+  {
+    // Scenario: a guard pins the page for as long as it lives, and reading through it does not dirty the page.
+    auto guard = bpm->FetchPageBasic(page_id_temp);
+    EXPECT_EQ(page0->GetData(), guard.GetData());
+    EXPECT_EQ(page0->GetPageId(), guard.PageId());
+    EXPECT_EQ(2, page0->GetPinCount());
+
+    // Scenario: moving a guard moves the pin; the moved-from guard holds nothing.
+    BasicPageGuard moved = std::move(guard);
+    EXPECT_FALSE(guard.IsValid());  // NOLINT(bugprone-use-after-move)
+    EXPECT_EQ(2, page0->GetPinCount());
+    moved.Drop();
+    EXPECT_EQ(1, page0->GetPinCount());
+    EXPECT_FALSE(page0->IsDirty());
+    moved.Drop();
+    EXPECT_EQ(1, page0->GetPinCount());
+  }
+
+  {
+    // Scenario: writing through AsMut() dirties the page when the guard lets go of it.
+    auto guard = bpm->FetchPageBasic(page_id_temp);
+    strcpy(guard.AsMut<char>(), "Hello");  // NOLINT
+    EXPECT_FALSE(page0->IsDirty());
+  }
+  EXPECT_TRUE(page0->IsDirty());
+  EXPECT_EQ(1, page0->GetPinCount());
+
+  // Scenario: assigning to a guard releases the page it held.
+  page_id_t page_id_other;
+  auto guard = bpm->NewPageGuarded(&page_id_other);
+  auto *page1 = bpm->FetchPage(page_id_other);
+  EXPECT_EQ(2, page1->GetPinCount());
+  guard = bpm->FetchPageBasic(page_id_temp);
+  EXPECT_EQ(1, page1->GetPinCount());
+  EXPECT_EQ(2, page0->GetPinCount());
+  guard.Drop();
+
+  // Scenario: a fetch that fails hands out an invalid guard.
+  std::vector<BasicPageGuard> guards;
+  for (size_t i = 0; i < buffer_pool_size - 2; i++) {
+    guards.push_back(bpm->NewPageGuarded(&page_id_other));
+    ASSERT_TRUE(guards.back().IsValid());
+  }
+  EXPECT_FALSE(bpm->NewPageGuarded(&page_id_other).IsValid());
+  guards.clear();
+  EXPECT_TRUE(bpm->NewPageGuarded(&page_id_other).IsValid());
+
+  EXPECT_EQ(true, bpm->UnpinPage(page1->GetPageId(), false));
+  EXPECT_EQ(true, bpm->UnpinPage(page0->GetPageId(), false));
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, LatchTest) {
+  const size_t buffer_pool_size = 5;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+  EXPECT_EQ(true, bpm->UnpinPage(page_id_temp, false));
+
+  {
+    // Scenario: read guards share the latch and release it with the pin.
+    auto read_guard0 = bpm->FetchPageRead(page_id_temp);
+    auto read_guard1 = bpm->FetchPageRead(page_id_temp);
+    EXPECT_EQ(2, page0->GetPinCount());
+    ReadPageGuard moved = std::move(read_guard0);
+    read_guard1.Drop();
+    EXPECT_EQ(1, page0->GetPinCount());
+  }
+  EXPECT_EQ(0, page0->GetPinCount());
+
+  {
+    // Scenario: a write guard holds the latch exclusively and dirties the page it writes.
+    auto write_guard = bpm->FetchPageWrite(page_id_temp);
+    strcpy(write_guard.GetDataMut(), "Hello");  // NOLINT
+    std::atomic<bool> read_latched{false};
+    std::thread reader([&]() {
+      auto read_guard = bpm->FetchPageRead(page_id_temp);
+      read_latched = true;
+      EXPECT_EQ(0, strcmp(read_guard.GetData(), "Hello"));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(read_latched);
+    write_guard.Drop();
+    reader.join();
+    EXPECT_TRUE(read_latched);
+  }
+  EXPECT_TRUE(page0->IsDirty());
+  EXPECT_EQ(0, page0->GetPinCount());
+
+  {
+    // Scenario: a basic guard upgrades to a write guard, keeping its single pin.
+    auto guard = bpm->FetchPageBasic(page_id_temp);
+    auto write_guard = guard.UpgradeWrite();
+    EXPECT_FALSE(guard.IsValid());  // NOLINT(bugprone-use-after-move)
+    EXPECT_EQ(1, page0->GetPinCount());
+    // Pinning without latching still works while the write latch is held.
+    EXPECT_TRUE(bpm->FetchPageBasic(page_id_temp).IsValid());
+  }
+  EXPECT_EQ(0, page0->GetPinCount());
+  // The write latch was released, or this would block.
+  EXPECT_TRUE(bpm->FetchPageWrite(page_id_temp).IsValid());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
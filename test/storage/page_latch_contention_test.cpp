@@ -0,0 +1,113 @@
+/**
+ * page_latch_contention_test.cpp
+ */
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <iostream>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+/**
+ * Every index lookup starts at the root page, so the root is the hottest latch of an index. This benchmark has threads
+ * binary-search the keys of a root-like page, either under its shared latch or with optimistic reads, while a writer
+ * now and then rewrites the page.
+ * @return lookups per millisecond
+ */
+auto PageLatchBenchmarkCall(size_t num_threads, bool optimistic) -> double {
+  const size_t lookups_per_thread = 200000;
+  const size_t num_keys = BUSTUB_PAGE_SIZE / sizeof(int64_t) - 1;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager);
+  page_id_t page_id;
+  Page *root = bpm->NewPage(&page_id);
+  // Slot 0 holds the number of keys, like the header of a B+ tree page; the sorted keys follow.
+  auto *slots = reinterpret_cast<int64_t *>(root->GetData());
+  slots[0] = num_keys;
+  for (size_t i = 0; i < num_keys; i++) {
+    slots[i + 1] = static_cast<int64_t>(i * 2);
+  }
+
+  auto lookup = [&](int64_t key) -> size_t {
+    // Clamp what was read: an optimistic reader may see a size torn by the writer until it validates.
+    auto size = std::min(static_cast<size_t>(slots[0]), num_keys);
+    const auto *keys = slots + 1;
+    return std::lower_bound(keys, keys + size, key) - keys;
+  };
+
+  std::vector<std::thread> threads;
+  std::vector<size_t> found(num_threads, 0);
+  auto clock_start = std::chrono::steady_clock::now();
+  for (size_t tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&, tid]() {
+      size_t hits = 0;
+      for (size_t i = 0; i < lookups_per_thread; i++) {
+        auto key = static_cast<int64_t>((i * 7919 + tid) % (num_keys * 2));
+        size_t slot;
+        if (optimistic) {
+          while (true) {
+            uint64_t version;
+            if (!root->TryOptimisticRead(&version)) {
+              continue;
+            }
+            slot = lookup(key);
+            if (root->ValidateOptimisticRead(version)) {
+              break;
+            }
+          }
+        } else {
+          root->RLatch();
+          slot = lookup(key);
+          root->RUnlatch();
+        }
+        hits += slot < num_keys ? 1 : 0;
+      }
+      found[tid] = hits;
+    });
+  }
+  // The writer rewrites the page in place, as a split of a child would.
+  std::thread writer([&]() {
+    for (int i = 0; i < 100; i++) {
+      root->WLatch();
+      slots[0] = num_keys;
+      root->WUnlatch();
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto clock_end = std::chrono::steady_clock::now();
+  writer.join();
+
+  bpm->UnpinPage(page_id, true);
+  delete bpm;
+  delete disk_manager;
+
+  auto dur = std::chrono::duration_cast<std::chrono::microseconds>(clock_end - clock_start).count();
+  return static_cast<double>(num_threads * lookups_per_thread) * 1000 / std::max<int64_t>(dur, 1);
+}
+
+TEST(PageLatchTest, DISABLED_PageLatchContentionBenchmark) {  // NOLINT
+  std::cout << "This test compares lookups on a shared root page under its read latch and with optimistic reads."
+            << std::endl;
+  std::cout << "<<< BEGIN" << std::endl;
+  for (size_t num_threads = 1; num_threads <= 64; num_threads *= 2) {
+    auto shared = PageLatchBenchmarkCall(num_threads, false);
+    auto optimistic = PageLatchBenchmarkCall(num_threads, true);
+    std::cout << "Threads: " << num_threads << " Shared latch: " << shared << " lookups/ms"
+              << " Optimistic: " << optimistic << " lookups/ms"
+              << " Ratio: " << optimistic / shared << std::endl;
+  }
+  std::cout << ">>> END" << std::endl;
+}
+
+}  // namespace bustub
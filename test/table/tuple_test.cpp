@@ -17,8 +17,10 @@
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "gtest/gtest.h"
 #include "logging/common.h"
+#include "storage/disk/disk_manager_memory.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
 
@@ -66,9 +68,62 @@ TEST(TupleTest, DISABLED_TableHeapTest) {
   disk_manager->ShutDown();
   remove("test.db");  // remove db file
   remove("test.log");
+  DiskManager::RemoveSidecarFiles("test.db");
   delete table;
   delete buffer_pool_manager;
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(TupleTest, TableHeapExtentTest) {
+  Column col1{"a", TypeId::VARCHAR, 200};
+  Column col2{"b", TypeId::BIGINT};
+  Schema schema{{col1, col2}};
+  Tuple tuple = ConstructTuple(&schema);
+
+  auto *transaction = new Transaction(0);
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *buffer_pool_manager = new ParallelBufferPoolManager(4, 16, disk_manager);
+  auto *lock_manager = new LockManager();
+  auto *log_manager = new LogManager(disk_manager);
+  auto *table_a = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+  auto *table_b = new TableHeap(buffer_pool_manager, lock_manager, log_manager, transaction);
+
+  // Two tables growing at the same time still get contiguous pages.
+  for (int i = 0; i < 10000; ++i) {
+    RID rid;
+    ASSERT_TRUE(table_a->InsertTuple(tuple, &rid, transaction));
+    ASSERT_TRUE(table_b->InsertTuple(tuple, &rid, transaction));
+  }
+  for (auto *table : {table_a, table_b}) {
+    auto extents = table->GetExtents();
+    ASSERT_FALSE(extents.empty());
+    EXPECT_EQ(extents[0], table->GetFirstPageId());
+    size_t num_pages = 0;
+    page_id_t prev_page_id = INVALID_PAGE_ID;
+    for (page_id_t page_id = table->GetFirstPageId(); page_id != INVALID_PAGE_ID;) {
+      if (prev_page_id != INVALID_PAGE_ID && page_id != prev_page_id + 1) {
+        // Only the first page of an extent may jump.
+        EXPECT_NE(extents.end(), std::find(extents.begin(), extents.end(), page_id));
+      }
+      auto *page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(page_id));
+      ASSERT_NE(nullptr, page);
+      prev_page_id = page_id;
+      page_id = page->GetNextPageId();
+      buffer_pool_manager->UnpinPage(prev_page_id, false);
+      num_pages++;
+    }
+    EXPECT_GT(num_pages, static_cast<size_t>(EXTENT_PAGES));
+    EXPECT_EQ((num_pages + EXTENT_PAGES - 1) / EXTENT_PAGES, extents.size());
+  }
+
+  delete table_a;
+  delete table_b;
+  delete log_manager;
+  delete lock_manager;
+  delete buffer_pool_manager;
+  delete disk_manager;
+  delete transaction;
+}
+
 }  // namespace bustub